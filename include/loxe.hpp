@@ -8,19 +8,41 @@
 #include "loxe/common/utility.hpp"
 
 // parser
+#include "loxe/parser/arena.hpp"
 #include "loxe/parser/ast.hpp"
+#include "loxe/parser/ast_cache.hpp"
+#include "loxe/parser/error.hpp"
+#include "loxe/parser/import_loader.hpp"
 #include "loxe/parser/lexer.hpp"
 #include "loxe/parser/parser.hpp"
+#include "loxe/parser/pipeline.hpp"
 #include "loxe/parser/resolver.hpp"
+#include "loxe/parser/scan.hpp"
+#include "loxe/parser/source.hpp"
+#include "loxe/parser/source_map.hpp"
 #include "loxe/parser/token.hpp"
+#include "loxe/parser/token_buffer.hpp"
 
 // tree walker
 #include "loxe/tree_walker/callable.hpp"
+#include "loxe/tree_walker/completion.hpp"
 #include "loxe/tree_walker/environment.hpp"
 #include "loxe/tree_walker/error.hpp"
 #include "loxe/tree_walker/instance.hpp"
 #include "loxe/tree_walker/interpreter.hpp"
 #include "loxe/tree_walker/object.hpp"
+#include "loxe/tree_walker/shape.hpp"
+#include "loxe/tree_walker/symbol.hpp"
 #include "loxe/tree_walker/tree_walker.hpp"
 
+// vm
+#include "loxe/vm/chunk.hpp"
+#include "loxe/vm/compiler.hpp"
+#include "loxe/vm/error.hpp"
+#include "loxe/vm/heap.hpp"
+#include "loxe/vm/machine.hpp"
+#include "loxe/vm/object.hpp"
+#include "loxe/vm/value.hpp"
+#include "loxe/vm/vm.hpp"
+
 #endif // !LOXE_LOXE_HPP
@@ -7,6 +7,10 @@
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace loxe::utility
 {
@@ -53,6 +57,21 @@ namespace loxe::utility
     {
         std::cout << std::format(fmt, std::forward<Args>(args)...) << '\n';
     }
+
+    // lets string keyed containers be searched with a `std::string_view` (such as a token's lexeme)
+    struct string_hash
+    {
+        using is_transparent = void;
+
+        [[nodiscard]] auto operator()(std::string_view string) const -> std::size_t
+        {
+            return std::hash<std::string_view>{}(string);
+        }
+    };
+
+    template<typename T>
+    using string_map = std::unordered_map<std::string, T, string_hash, std::equal_to<>>;
+    using string_set = std::unordered_set<std::string, string_hash, std::equal_to<>>;
 } // namespace loxe::utility
 
 #endif // !LOXE_COMMON_UTILITY_HPP
@@ -0,0 +1,101 @@
+#pragma once
+
+#ifndef LOXE_PARSER_ARENA_HPP
+#define LOXE_PARSER_ARENA_HPP
+
+#include <new>
+#include <deque>
+#include <span>
+#include <memory>
+#include <cstring>
+#include <vector>
+#include <cstddef>
+#include <utility>
+#include <string_view>
+#include <type_traits>
+
+namespace loxe::ast
+{
+    // bump allocator owning every node of a parsed program. nodes are never
+    // freed individually; the whole arena is released at once when it dies.
+    class Arena
+    {
+    public:
+        Arena() = default;
+        Arena(Arena&&) noexcept;
+        Arena(const Arena&) = delete;
+        ~Arena();
+
+        auto operator=(Arena&&) noexcept -> Arena&;
+        auto operator=(const Arena&) -> Arena& = delete;
+
+        template<typename T, typename... Args>
+        [[nodiscard]] auto make(Args&&... args) -> T*
+        {
+            auto object = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+            if constexpr (!std::is_trivially_destructible_v<T>)
+                m_destructors.push_back({ object, 1, &destroy<T> });
+            return object;
+        }
+
+        template<typename T>
+        [[nodiscard]] auto list(std::vector<T>&& items) -> std::span<T>
+        {
+            if (items.empty()) return {};
+
+            auto data = static_cast<T*>(allocate(sizeof(T) * items.size(), alignof(T)));
+            std::uninitialized_move(items.begin(), items.end(), data);
+            if constexpr (!std::is_trivially_destructible_v<T>)
+                m_destructors.push_back({ data, items.size(), &destroy<T> });
+            return { data, items.size() };
+        }
+
+        template<typename T>
+        [[nodiscard]] auto list(std::span<const T> items) -> std::span<T>
+        {
+            if (items.empty()) return {};
+
+            auto data = static_cast<T*>(allocate(sizeof(T) * items.size(), alignof(T)));
+            std::uninitialized_copy(items.begin(), items.end(), data);
+            if constexpr (!std::is_trivially_destructible_v<T>)
+                m_destructors.push_back({ data, items.size(), &destroy<T> });
+            return { data, items.size() };
+        }
+
+        [[nodiscard]] auto text(std::string_view text) -> std::string_view
+        {
+            if (text.empty()) return {};
+
+            auto data = static_cast<char*>(allocate(text.size(), alignof(char)));
+            std::memcpy(data, text.data(), text.size());
+            return { data, text.size() };
+        }
+
+    private:
+        struct Destructor
+        {
+            void*       object;
+            std::size_t count;
+            void      (*destroy)(void*, std::size_t);
+        };
+
+        template<typename T>
+        static auto destroy(void* object, std::size_t count) -> void
+        {
+            std::destroy_n(static_cast<T*>(object), count);
+        }
+
+        auto allocate(std::size_t size, std::size_t align) -> void*;
+        auto release()                                     -> void;
+
+    private:
+        static constexpr auto block_size = std::size_t{64 * 1024};
+
+        std::vector<std::unique_ptr<std::byte[]>> m_blocks      = {};
+        std::deque<Destructor>                    m_destructors = {};
+        std::byte*                                m_cursor      = nullptr;
+        std::size_t                               m_remaining   = 0;
+    };
+} // namespace loxe::ast
+
+#endif // !LOXE_PARSER_ARENA_HPP
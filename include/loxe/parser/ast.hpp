@@ -3,15 +3,24 @@
 #ifndef LOXE_PARSER_AST_HPP
 #define LOXE_PARSER_AST_HPP
 
-#include <any>
-#include <memory>
+#include <span>
 #include <string>
-#include <vector>
 #include <cstdint>
+#include <limits>
 #include <optional>
 
+#include "loxe/common/utility.hpp"
+
+#include "arena.hpp"
+#include "source_map.hpp"
 #include "token.hpp"
 
+namespace loxe::tree_walker
+{
+    class Object;
+    enum class Completion : std::uint8_t;
+} // namespace loxe::tree_walker
+
 namespace loxe::ast
 {
     constexpr auto is_const  = true;
@@ -20,18 +29,20 @@ namespace loxe::ast
     template<bool IsConst, typename T>
     using const_wrapper = typename std::conditional<IsConst, const T, T>::type;
 
-    using expr_ptr = std::unique_ptr<struct Expr>;
-    using stmt_ptr = std::unique_ptr<struct Stmt>;
+    // nodes are allocated from the program's `Arena` and link to each other
+    // without ownership; none of them outlive the arena they came from
+    using expr_ptr = struct Expr*;
+    using stmt_ptr = struct Stmt*;
 
-    using expr_list = std::vector<expr_ptr>;
-    using stmt_list = std::vector<stmt_ptr>;
+    using expr_list = std::span<expr_ptr>;
+    using stmt_list = std::span<stmt_ptr>;
 
     using op_stmt = std::optional<stmt_ptr>;
     using op_expr = std::optional<expr_ptr>;
 
-    using fun_ptr     = std::unique_ptr<struct FunctionExpr>;
-    using param_list  = std::vector<Token>;
-    using method_list = std::vector<fun_ptr>;
+    using fun_ptr     = struct FunctionExpr*;
+    using param_list  = std::span<Span>;
+    using method_list = std::span<fun_ptr>;
 } // namespace loxe::ast
 
 namespace loxe::ast
@@ -69,14 +80,19 @@ namespace loxe::ast
         template<typename R> using const_visitor = Visitor<R, is_const>;
 
     public:
-        virtual ~Expr() = default;
-        virtual auto accept(visitor<void>&)                 -> void     = 0;
-        virtual auto accept(const_visitor<void>&)     const -> void     = 0;
-        virtual auto accept(const_visitor<std::any>&) const -> std::any = 0;
+        virtual auto accept(visitor<void>&)                            -> void                = 0;
+        virtual auto accept(const_visitor<void>&)                const -> void                = 0;
+        virtual auto accept(const_visitor<tree_walker::Object>&) const -> tree_walker::Object = 0;
 
-        [[nodiscard]] virtual auto clone() const -> expr_ptr = 0;
+        // how many scopes out the variable was declared, or `global` for globals
+        static constexpr auto global = std::numeric_limits<std::uint32_t>::max();
 
-        std::optional<std::size_t> depth;
+        std::uint32_t depth = global;
+        std::uint32_t slot  = 0;
+
+    protected:
+        // only the arena destroys nodes, and it always knows the concrete type
+        ~Expr() = default;
     };
 
     struct Stmt
@@ -107,12 +123,12 @@ namespace loxe::ast
         template<typename R> using const_visitor = Visitor<R, is_const>;
 
     public:
-        virtual ~Stmt() = default;
-        virtual auto accept(visitor<void>&)                 -> void     = 0;
-        virtual auto accept(const_visitor<void>&)     const -> void     = 0;
-        virtual auto accept(const_visitor<std::any>&) const -> std::any = 0;
+        virtual auto accept(visitor<void>&)                                -> void                    = 0;
+        virtual auto accept(const_visitor<void>&)                    const -> void                    = 0;
+        virtual auto accept(const_visitor<tree_walker::Completion>&) const -> tree_walker::Completion = 0;
 
-        [[nodiscard]] virtual auto clone() const -> stmt_ptr = 0;
+    protected:
+        ~Stmt() = default;
     };
 
     template<typename Derived>
@@ -128,24 +144,11 @@ namespace loxe::ast
             return visitor.visit(*static_cast<const Derived*>(this));
         }
 
-        auto accept(const_visitor<std::any>& visitor) const -> std::any override
-        {
-            return visitor.visit(*static_cast<const Derived*>(this));
-        }
-
-        [[nodiscard]] auto clone() const -> expr_ptr override
-        {
-            return this->make_clone();
-        }
-
-        template<typename... Args>
-        [[nodiscard]] static auto make(Args&&... args) -> std::unique_ptr<Derived>
-        {
-            return std::make_unique<Derived>(std::forward<Args>(args)...);
-        }
+        // defined by the tree walker, for every kind of node, where `Object` is complete
+        auto accept(const_visitor<tree_walker::Object>& visitor) const -> tree_walker::Object override;
 
     protected:
-        [[nodiscard]] virtual auto make_clone() const->std::unique_ptr<Derived> = 0;
+        ~ExprCRTP() = default;
     };
 
     template<typename Derived>
@@ -161,24 +164,13 @@ namespace loxe::ast
             return visitor.visit(*static_cast<const Derived*>(this));
         }
 
-        auto accept(const_visitor<std::any>& visitor) const -> std::any override
+        auto accept(const_visitor<tree_walker::Completion>& visitor) const -> tree_walker::Completion override
         {
             return visitor.visit(*static_cast<const Derived*>(this));
         }
 
-        [[nodiscard]] auto clone() const -> stmt_ptr override
-        {
-            return this->make_clone();
-        }
-
-        template<typename... Args>
-        [[nodiscard]] static auto make(Args&&... args) -> std::unique_ptr<Derived>
-        {
-            return std::make_unique<Derived>(std::forward<Args>(args)...);
-        }
-
     protected:
-        [[nodiscard]] virtual auto make_clone() const->std::unique_ptr<Derived> = 0;
+        ~StmtCRTP() = default;
     };
 } // namespace loxe::ast
 
@@ -186,85 +178,51 @@ namespace loxe::ast
 {
     struct ArrayExpr final : public ExprCRTP<ArrayExpr>
     {
-        ArrayExpr(Token name, expr_ptr size, expr_list initializer)
+        ArrayExpr(Span name, expr_ptr size, expr_list initializer)
             : start(std::move(name)), size(std::move(size)), initializer(std::move(initializer)) {}
 
-        [[nodiscard]] auto make_clone() const -> std::unique_ptr<ArrayExpr> override
-        {
-            auto siz  = size ? size->clone() : nullptr;
-            auto init = expr_list();
-            for (const auto& val : initializer) init.emplace_back(val ? val->clone() : nullptr);
-            return std::make_unique<ArrayExpr>(start, std::move(siz), std::move(init));
-        }
-
-        Token     start;
+        Span      start;
         expr_ptr  size;
         expr_list initializer;
     };
 
     struct AssignExpr final : public ExprCRTP<AssignExpr>
     {
-        AssignExpr(Token name, expr_ptr value)
+        AssignExpr(Span name, expr_ptr value)
             : name(std::move(name)), value(std::move(value)) {}
 
-        [[nodiscard]] auto make_clone() const -> std::unique_ptr<AssignExpr> override
-        {
-            auto val = value ? value->clone() : nullptr;
-            return std::make_unique<AssignExpr>(name, std::move(val));
-        }
-
-        Token    name;
+        Span     name;
         expr_ptr value;
     };
 
     struct BinaryExpr final : public ExprCRTP<BinaryExpr>
     {
-        BinaryExpr(Token op, expr_ptr lhs, expr_ptr rhs)
+        BinaryExpr(Span op, expr_ptr lhs, expr_ptr rhs)
             : op(std::move(op)), lhs(std::move(lhs)), rhs(std::move(rhs)) {}
 
-        [[nodiscard]] auto make_clone() const -> std::unique_ptr<BinaryExpr> override
-        {
-            auto left  = lhs ? lhs->clone() : nullptr;
-            auto right = rhs ? rhs->clone() : nullptr;
-            return std::make_unique<BinaryExpr>(op, std::move(left), std::move(right));
-        }
-
-        Token    op;
+        Span     op;
         expr_ptr lhs;
         expr_ptr rhs;
     };
 
     struct BooleanExpr final : public ExprCRTP<BooleanExpr>
     {
-        BooleanExpr(Token token)
-            : value(token.type == Token::Type::True), token(std::move(token)) {}
+        BooleanExpr(Span token)
+            : value(token.type == Token::Type::True), offset(token.offset) {}
 
         BooleanExpr(bool value)
-            : value(value), token() {}
+            : value(value) {}
 
-        [[nodiscard]] auto make_clone() const -> std::unique_ptr<BooleanExpr> override
-        {
-            return std::make_unique<BooleanExpr>(*this);
-        }
-
-        bool  value;
-        Token token;
+        bool          value;
+        std::uint32_t offset = Token::nowhere;
     };
 
     struct CallExpr final : public ExprCRTP<CallExpr>
     {
-        CallExpr(Token paren, expr_ptr callee, expr_list args)
+        CallExpr(Span paren, expr_ptr callee, expr_list args)
             : paren(std::move(paren)), callee(std::move(callee)), args(std::move(args)) {}
 
-        [[nodiscard]] auto make_clone() const -> std::unique_ptr<CallExpr> override
-        {
-            auto cal = callee ? callee->clone() : nullptr;
-            auto ags = expr_list();
-            for (const auto& arg : args) ags.emplace_back(arg ? arg->clone() : nullptr);
-            return std::make_unique<CallExpr>(paren, std::move(cal), std::move(ags));
-        }
-
-        Token     paren;
+        Span      paren;
         expr_ptr  callee;
         expr_list args;
     };
@@ -274,13 +232,6 @@ namespace loxe::ast
         CommaExpr(expr_list expressions)
             : expressions(std::move(expressions)) {}
 
-        [[nodiscard]] auto make_clone() const -> std::unique_ptr<CommaExpr> override
-        {
-            auto exprs = expr_list();
-            for (const auto& expr : expressions) exprs.emplace_back(expr ? expr->clone() : nullptr);
-            return std::make_unique<CommaExpr>(std::move(exprs));
-        }
-
         expr_list expressions;
     };
 
@@ -289,14 +240,6 @@ namespace loxe::ast
         ConditionalExpr(expr_ptr condition, expr_ptr then_branch, expr_ptr else_branch)
             : condition(std::move(condition)), then_branch(std::move(then_branch)), else_branch(std::move(else_branch)) {}
 
-        [[nodiscard]] auto make_clone() const -> std::unique_ptr<ConditionalExpr> override
-        {
-            auto con = condition   ? condition->clone() : nullptr;
-            auto thn = then_branch ? then_branch->clone() : nullptr;
-            auto els = else_branch ? else_branch->clone() : nullptr;
-            return std::make_unique<ConditionalExpr>(std::move(con), std::move(thn), std::move(els));
-        }
-
         expr_ptr condition;
         expr_ptr then_branch;
         expr_ptr else_branch;
@@ -304,33 +247,31 @@ namespace loxe::ast
 
     struct FunctionExpr final : public ExprCRTP<FunctionExpr>
     {
-        FunctionExpr(Token name, param_list params, stmt_ptr body)
+        FunctionExpr(Span name, param_list params, stmt_ptr body)
             : name(std::move(name)), params(std::move(params)), body(std::move(body)) {}
 
-        [[nodiscard]] auto make_clone() const -> std::unique_ptr<FunctionExpr> override
-        {
-            auto bdy = body ? body->clone() : nullptr;
-            return std::make_unique<FunctionExpr>(name, params, std::move(bdy));
-        }
+        Span        name;
+        param_list  params;
+        stmt_ptr    body;
+        std::size_t slots   = 0;
+        std::size_t nesting = 0; // how deep statements and expressions in the body get
 
-        Token      name;
-        param_list params;
-        stmt_ptr   body;
+        // the body's text from `{` to `}` when the parser only matched its braces. `body` stays
+        // empty until `Resolver::expand` parses it, the first time the function is needed
+        Span deferred = {};
     };
 
     struct GetExpr final : public ExprCRTP<GetExpr>
     {
-        GetExpr(Token name, expr_ptr object)
+        GetExpr(Span name, expr_ptr object)
             : name(std::move(name)), object(std::move(object)) {}
 
-        [[nodiscard]] auto make_clone() const -> std::unique_ptr<GetExpr> override
-        {
-            auto obj = object ? object->clone() : nullptr;
-            return std::make_unique<GetExpr>(name, std::move(obj));
-        }
-
-        Token    name;
+        Span     name;
         expr_ptr object;
+
+        // numbered by the resolver across property accesses, gets and sets alike, so an
+        // engine can keep what it learns about each one in a table of its own
+        std::uint32_t site = 0;
     };
 
     struct GroupingExpr final : public ExprCRTP<GroupingExpr>
@@ -338,113 +279,75 @@ namespace loxe::ast
         GroupingExpr(expr_ptr expression)
             : expression(std::move(expression)) {}
 
-        [[nodiscard]] auto make_clone() const -> std::unique_ptr<GroupingExpr> override
-        {
-            auto expr = expression ? expression->clone() : nullptr;
-            return std::make_unique<GroupingExpr>(std::move(expr));
-        }
-
         expr_ptr expression;
     };
 
     struct LogicalExpr final : public ExprCRTP<LogicalExpr>
     {
-        LogicalExpr(Token op, expr_ptr lhs, expr_ptr rhs)
+        LogicalExpr(Span op, expr_ptr lhs, expr_ptr rhs)
             : op(std::move(op)), lhs(std::move(lhs)), rhs(std::move(rhs)) {}
 
-        [[nodiscard]] auto make_clone() const -> std::unique_ptr<LogicalExpr> override
-        {
-            auto left  = lhs ? lhs->clone() : nullptr;
-            auto right = rhs ? rhs->clone() : nullptr;
-            return std::make_unique<LogicalExpr>(op, std::move(left), std::move(right));
-        }
-
-        Token    op;
+        Span     op;
         expr_ptr lhs;
         expr_ptr rhs;
     };
 
     struct NilExpr final : public ExprCRTP<NilExpr>
     {
-        NilExpr()
-            : token() {}
+        NilExpr() = default;
 
-        NilExpr(Token token)
-            : token(std::move(token)) {}
+        NilExpr(Span token)
+            : offset(token.offset) {}
 
-        [[nodiscard]] auto make_clone() const -> std::unique_ptr<NilExpr> override
-        {
-            return std::make_unique<NilExpr>(*this);
-        }
-
-        Token token;
+        std::uint32_t offset = Token::nowhere;
     };
 
     struct NumberExpr final : public ExprCRTP<NumberExpr>
     {
-        NumberExpr(Token token)
-            : value(std::stod(token.lexeme)), token(std::move(token)) {}
+        NumberExpr(const Token& token)
+            : value(token.number), offset(token.offset) {}
 
         NumberExpr(double value)
-            : value(value), token() {}
-
-        [[nodiscard]] auto make_clone() const -> std::unique_ptr<NumberExpr> override
-        {
-            return std::make_unique<NumberExpr>(*this);
-        }
+            : value(value) {}
 
-        double value;
-        Token  token;
+        double        value;
+        std::uint32_t offset = Token::nowhere;
     };
 
     struct SetExpr final : public ExprCRTP<SetExpr>
     {
-        SetExpr(Token name, expr_ptr object, expr_ptr value)
+        SetExpr(Span name, expr_ptr object, expr_ptr value)
             : name(std::move(name)), object(std::move(object)), value(std::move(value)) {}
 
-        [[nodiscard]] auto make_clone() const -> std::unique_ptr<SetExpr> override
-        {
-            auto obj = object ? object->clone() : nullptr;
-            auto val = value  ? value->clone()  : nullptr;
-            return std::make_unique<SetExpr>(name, std::move(obj), std::move(val));
-        }
-
-        Token    name;
+        Span     name;
         expr_ptr object;
         expr_ptr value;
+
+        // numbered along with the sites of `GetExpr`
+        std::uint32_t site = 0;
     };
 
     struct StringExpr final : public ExprCRTP<StringExpr>
     {
-        StringExpr(Token token)
-            : value(token.lexeme), token(std::move(token)) {}
+        StringExpr(Span token)
+            : value(token.lexeme), offset(token.offset) {}
 
-        StringExpr(std::string value)
-            : value(std::move(value)), token() {}
+        StringExpr(std::string_view value)
+            : value(value) {}
 
-        [[nodiscard]] auto make_clone() const -> std::unique_ptr<StringExpr> override
-        {
-            return std::make_unique<StringExpr>(*this);
-        }
+        std::string_view value;
+        std::uint32_t    offset = Token::nowhere;
 
-        std::string value;
-        Token       token;
+        // numbered by the resolver across string literals
+        std::uint32_t site = 0;
     };
 
     struct SubscriptExpr final : public ExprCRTP<SubscriptExpr>
     {
-        SubscriptExpr(Token bracket, expr_ptr expression, expr_ptr index, op_expr new_value = std::nullopt)
+        SubscriptExpr(Span bracket, expr_ptr expression, expr_ptr index, op_expr new_value = std::nullopt)
             : bracket(bracket), expression(std::move(expression)), index(std::move(index)), new_value(std::move(new_value)) {}
 
-        [[nodiscard]] auto make_clone() const -> std::unique_ptr<SubscriptExpr> override
-        {
-            auto expr = expression ? expression->clone() : nullptr;
-            auto idx  = index ? index->clone() : nullptr;
-            auto nvl  = new_value && *new_value ? std::optional{(*new_value)->clone()} : std::nullopt;
-            return std::make_unique<SubscriptExpr>(bracket, std::move(expr), std::move(idx), std::move(nvl));
-        }
-
-        Token    bracket;
+        Span     bracket;
         expr_ptr expression;
         expr_ptr index;
         op_expr  new_value;
@@ -452,57 +355,39 @@ namespace loxe::ast
 
     struct SuperExpr final : public ExprCRTP<SuperExpr>
     {
-        SuperExpr(Token keyword, Token method)
+        SuperExpr(Span keyword, Span method)
             : keyword(std::move(keyword)), method(std::move(method)) {}
 
-        [[nodiscard]] auto make_clone() const -> std::unique_ptr<SuperExpr> override
-        {
-            return std::make_unique<SuperExpr>(*this);
-        }
+        Span  keyword;
+        Span  method;
 
-        Token keyword;
-        Token method;
+        // numbered by the resolver across `super` accesses
+        std::uint32_t site = 0;
     };
 
     struct ThisExpr final : public ExprCRTP<ThisExpr>
     {
-        ThisExpr(Token keyword)
+        ThisExpr(Span keyword)
             : keyword(std::move(keyword)) {}
 
-        [[nodiscard]] auto make_clone() const -> std::unique_ptr<ThisExpr> override
-        {
-            return std::make_unique<ThisExpr>(*this);
-        }
-
-        Token keyword;
+        Span  keyword;
     };
 
     struct UnaryExpr final : public ExprCRTP<UnaryExpr>
     {
-        UnaryExpr(Token op, expr_ptr operand)
+        UnaryExpr(Span op, expr_ptr operand)
             : op(std::move(op)), operand(std::move(operand)) {}
 
-        [[nodiscard]] auto make_clone() const -> std::unique_ptr<UnaryExpr> override
-        {
-            auto oper = operand ? operand->clone() : nullptr;
-            return std::make_unique<UnaryExpr>(op, std::move(oper));
-        }
-
-        Token    op;
+        Span     op;
         expr_ptr operand;
     };
 
     struct VariableExpr final : public ExprCRTP<VariableExpr>
     {
-        VariableExpr(Token name)
+        VariableExpr(Span name)
             : name(std::move(name)) {}
 
-        [[nodiscard]] auto make_clone() const -> std::unique_ptr<VariableExpr> override
-        {
-            return std::make_unique<VariableExpr>(*this);
-        }
-
-        Token name;
+        Span  name;
     };
 } // namespace loxe::ast
 
@@ -513,46 +398,28 @@ namespace loxe::ast
         BlockStmt(stmt_list statements)
             : statements(std::move(statements)) {}
 
-        [[nodiscard]] auto make_clone() const -> std::unique_ptr<BlockStmt> override
-        {
-            auto stmts = stmt_list();
-            for (const auto& stmt : statements)
-                stmts.emplace_back(stmt ? stmt->clone() : nullptr);
-            return std::make_unique<BlockStmt>(std::move(stmts));
-        }
-
-        stmt_list statements;
+        stmt_list   statements;
+        std::size_t slots = 0;
     };
 
     struct BreakStmt final : public StmtCRTP<BreakStmt>
     {
-        BreakStmt(Token keyword)
+        BreakStmt(Span keyword)
             : keyword(std::move(keyword)) {}
 
-        [[nodiscard]] auto make_clone() const -> std::unique_ptr<BreakStmt> override
-        {
-            return std::make_unique<BreakStmt>(*this);
-        }
-
-        Token keyword;
+        Span  keyword;
     };
 
     struct ClassStmt final : public StmtCRTP<ClassStmt>
     {
-        ClassStmt(Token name, expr_ptr superclass, method_list methods)
+        ClassStmt(Span name, expr_ptr superclass, method_list methods)
             : name(std::move(name)), superclass(std::move(superclass)), methods(std::move(methods)) {}
 
-        [[nodiscard]] auto make_clone() const -> std::unique_ptr<ClassStmt> override
-        {
-            auto mthds = method_list();
-            auto super = superclass ? superclass->clone() : nullptr;
-            for (const auto& method : methods) mthds.emplace_back(method->make_clone());
-            return std::make_unique<ClassStmt>(name, std::move(super), std::move(mthds));
-        }
-
-        Token       name;
+        Span        name;
         expr_ptr    superclass;
         method_list methods;
+        std::size_t slot   = 0;
+        bool        global = false;
     };
 
     struct ExpressionStmt final : public StmtCRTP<ExpressionStmt>
@@ -560,26 +427,15 @@ namespace loxe::ast
         ExpressionStmt(expr_ptr expression)
             : expression(std::move(expression)) {}
 
-        [[nodiscard]] auto make_clone() const -> std::unique_ptr<ExpressionStmt> override
-        {
-            auto expr = expression ? expression->clone() : nullptr;
-            return std::make_unique<ExpressionStmt>(std::move(expr));
-        }
-
         expr_ptr expression;
     };
 
     struct ContinueStmt final : public StmtCRTP<ContinueStmt>
     {
-        ContinueStmt(Token keyword)
+        ContinueStmt(Span keyword)
             : keyword(std::move(keyword)) {}
 
-        [[nodiscard]] auto make_clone() const -> std::unique_ptr<ContinueStmt> override
-        {
-            return std::make_unique<ContinueStmt>(*this);
-        }
-
-        Token keyword;
+        Span  keyword;
     };
 
     struct ForStmt final : public StmtCRTP<ForStmt>
@@ -587,15 +443,6 @@ namespace loxe::ast
         ForStmt(stmt_ptr initializer, expr_ptr condition, expr_ptr update, stmt_ptr body)
             : initializer(std::move(initializer)), condition(std::move(condition)), update(std::move(update)), body(std::move(body)) {}
 
-        [[nodiscard]] auto make_clone() const -> std::unique_ptr<ForStmt> override
-        {
-            auto init = initializer ? initializer->clone() : nullptr;
-            auto con  = condition   ? condition->clone()   : nullptr;
-            auto upd  = update      ? update->clone()      : nullptr;
-            auto bdy  = body        ? body->clone()        : nullptr;
-            return std::make_unique<ForStmt>(std::move(init), std::move(con), std::move(upd), std::move(bdy));
-        }
-
         stmt_ptr initializer;
         expr_ptr condition;
         expr_ptr update;
@@ -607,13 +454,9 @@ namespace loxe::ast
         FunctionStmt(fun_ptr function)
             : function(std::move(function)) {}
 
-        [[nodiscard]] auto make_clone() const -> std::unique_ptr<FunctionStmt> override
-        {
-            auto fun = function ? function->make_clone() : nullptr;
-            return std::make_unique<FunctionStmt>(std::move(fun));
-        }
-
-        fun_ptr function;
+        fun_ptr     function;
+        std::size_t slot   = 0;
+        bool        global = false;
     };
 
     struct IfStmt final : public StmtCRTP<IfStmt>
@@ -621,14 +464,6 @@ namespace loxe::ast
         IfStmt(expr_ptr condition, stmt_ptr then_branch, stmt_ptr else_branch)
             : condition(std::move(condition)), then_branch(std::move(then_branch)), else_branch(std::move(else_branch)) {}
 
-        [[nodiscard]] auto make_clone() const -> std::unique_ptr<IfStmt> override
-        {
-            auto con = condition   ? condition->clone()   : nullptr;
-            auto thn = then_branch ? then_branch->clone() : nullptr;
-            auto els = else_branch ? else_branch->clone() : nullptr;
-            return std::make_unique<IfStmt>(std::move(con), std::move(thn), std::move(els));
-        }
-
         expr_ptr condition;
         stmt_ptr then_branch;
         stmt_ptr else_branch;
@@ -636,49 +471,35 @@ namespace loxe::ast
 
     struct ImportStmt final : public StmtCRTP<ImportStmt>
     {
-        ImportStmt(Token path, stmt_list body)
+        ImportStmt(Span path, stmt_list body)
             : path(std::move(path)), body(std::move(body)) {}
 
-        [[nodiscard]] auto make_clone() const -> std::unique_ptr<ImportStmt> override
-        {
-            auto bdy = stmt_list();
-            for (const auto& dec : body) bdy.emplace_back(dec ? dec->clone() : nullptr);
-            return std::make_unique<ImportStmt>(path, std::move(bdy));
-        }
-
-        Token     path;
+        Span      path;
         stmt_list body;
     };
 
     struct LetStmt final : public StmtCRTP<LetStmt>
     {
-        LetStmt(Token name, expr_ptr initializer)
+        LetStmt(Span name, expr_ptr initializer)
             : name(std::move(name)), initializer(std::move(initializer)) {}
 
-        [[nodiscard]] auto make_clone() const -> std::unique_ptr<LetStmt> override
-        {
-            auto init = initializer ? initializer->clone() : nullptr;
-            return std::make_unique<LetStmt>(name, std::move(init));
-        }
-
-        Token    name;
-        expr_ptr initializer;
+        Span        name;
+        expr_ptr    initializer;
+        std::size_t slot   = 0;
+        bool        global = false;
     };
 
     struct ModuleStmt final : public StmtCRTP<ModuleStmt>
     {
-        ModuleStmt(Token name, stmt_list body)
+        ModuleStmt(Span name, stmt_list body)
             : name(std::move(name)), body(std::move(body)) {}
 
-        [[nodiscard]] auto make_clone() const -> std::unique_ptr<ModuleStmt> override
-        {
-            auto bdy = stmt_list();
-            for (const auto& dec : body) bdy.emplace_back(dec ? dec->clone() : nullptr);
-            return std::make_unique<ModuleStmt>(name, std::move(bdy));
-        }
-
-        Token     name;
-        stmt_list body;
+        Span                             name;
+        stmt_list                        body;
+        std::size_t                      slot    = 0;
+        bool                             global  = false;
+        std::size_t                      slots   = 0;
+        utility::string_map<std::size_t> members = {};
     };
 
     struct PrintStmt final : public StmtCRTP<PrintStmt>
@@ -686,43 +507,27 @@ namespace loxe::ast
         PrintStmt(expr_ptr expression)
             : expression(std::move(expression)) {}
 
-        [[nodiscard]] auto make_clone() const -> std::unique_ptr<PrintStmt> override
-        {
-            auto expr = expression ? expression->clone() : nullptr;
-            return std::make_unique<PrintStmt>(std::move(expr));
-        }
-
         expr_ptr expression;
     };
 
     struct ReturnStmt final : public StmtCRTP<ReturnStmt>
     {
-        ReturnStmt(Token keyword, expr_ptr value)
+        ReturnStmt(Span keyword, expr_ptr value)
             : keyword(std::move(keyword)), value(std::move(value)) {}
 
-        [[nodiscard]] auto make_clone() const -> std::unique_ptr<ReturnStmt> override
-        {
-            auto val = value ? value->clone() : nullptr;
-            return std::make_unique<ReturnStmt>(keyword, std::move(val));
-        }
-
-        Token    keyword;
+        Span     keyword;
         expr_ptr value;
     };
 
     struct VariableStmt final : public StmtCRTP<VariableStmt>
     {
-        VariableStmt(Token name, expr_ptr initializer)
+        VariableStmt(Span name, expr_ptr initializer)
             : name(std::move(name)), initializer(std::move(initializer)) {}
 
-        [[nodiscard]] auto make_clone() const -> std::unique_ptr<VariableStmt> override
-        {
-            auto init = initializer ? initializer->clone() : nullptr;
-            return std::make_unique<VariableStmt>(name, std::move(init));
-        }
-
-        Token    name;
-        expr_ptr initializer;
+        Span        name;
+        expr_ptr    initializer;
+        std::size_t slot   = 0;
+        bool        global = false;
     };
 
     struct WhileStmt final : public StmtCRTP<WhileStmt>
@@ -730,16 +535,28 @@ namespace loxe::ast
         WhileStmt(expr_ptr condition, stmt_ptr body)
             : condition(std::move(condition)), body(std::move(body)) {}
 
-        [[nodiscard]] auto make_clone() const -> std::unique_ptr<WhileStmt> override
-        {
-            auto con = condition ? condition->clone() : nullptr;
-            auto bdy = body      ? body->clone()      : nullptr;
-            return std::make_unique<WhileStmt>(std::move(con), std::move(bdy));
-        }
-
         expr_ptr condition;
         stmt_ptr body;
     };
 } // namespace loxe::ast
 
+namespace loxe
+{
+    class Resolver;
+} // namespace loxe
+
+namespace loxe::ast
+{
+    // the arena also owns the source text of every parsed file, which all tokens view into.
+    // offsets in the tree are turned back into lines and columns through `sources`. while any
+    // function body is still deferred, the resolver that will finish it lives in the arena too
+    struct Program
+    {
+        Arena     arena;
+        SourceMap sources;
+        stmt_list statements;
+        Resolver* resolver = nullptr;
+    };
+} // namespace loxe::ast
+
 #endif // !LOXE_PARSER_AST_HPP
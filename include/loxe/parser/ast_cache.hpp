@@ -0,0 +1,36 @@
+#pragma once
+
+#ifndef LOXE_PARSER_AST_CACHE_HPP
+#define LOXE_PARSER_AST_CACHE_HPP
+
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "ast.hpp"
+
+namespace loxe
+{
+    // resolved programs kept on disk, so running an unchanged script again skips the lexer,
+    // parser and resolver. an entry is named after a hash of the script's contents and lists
+    // every file the program was built from together with a hash of its contents; it is only
+    // used while all of them still match. nodes are rebuilt straight from a mapping of the
+    // entry, which the loaded program keeps alive for the names and strings that view into it
+    class AstCache
+    {
+    public:
+        // the directory is `$LOXE_CACHE_DIR`, `$XDG_CACHE_HOME/loxe` or `$HOME/.cache/loxe`,
+        // whichever is set first. setting `LOXE_CACHE_DIR` to nothing turns the cache off
+        AstCache(std::string filename, std::string_view text);
+
+        [[nodiscard]] auto load()               const -> std::optional<ast::Program>;
+        auto store(const ast::Program& program) const -> void;
+
+    private:
+        std::string           m_filename = {};
+        std::filesystem::path m_entry    = {}; // empty while the cache is off
+    };
+} // namespace loxe
+
+#endif // !LOXE_PARSER_AST_CACHE_HPP
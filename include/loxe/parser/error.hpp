@@ -0,0 +1,51 @@
+#pragma once
+
+#ifndef LOXE_PARSER_ERROR_HPP
+#define LOXE_PARSER_ERROR_HPP
+
+#include <string>
+#include <string_view>
+
+#include "loxe/common/except.hpp"
+#include "loxe/common/utility.hpp"
+
+#include "source_map.hpp"
+#include "token.hpp"
+
+namespace loxe
+{
+    // imports are parsed on other threads, so where the error is, and which name its file
+    // goes by, is only worked out once the errors of all files are reported together
+    struct ParseError : public Exception
+    {
+        ParseError(const Span& token, std::string message)
+            : Exception(std::move(message)), token(token) {}
+
+        [[nodiscard]] auto report(const SourceMap& sources, std::string_view filename) const -> std::string
+        {
+            static constexpr auto format_1 = "Error in {}:\n[{}, {}] ParseError: {} at end.\n";
+            static constexpr auto format_2 = "Error in {}:\n[{}, {}] ParseError: {} at '{}'.\n";
+
+            const auto [line, column] = sources.position(token.offset);
+            if (token.type == Token::Type::EndOfFile)
+                return utility::as_string(format_1, filename, line, column, m_message);
+            return utility::as_string(format_2, filename, line, column, m_message, token.lexeme);
+        }
+
+        Span token;
+    };
+
+    // a skipped function body that fails to parse or resolve once it is needed. it carries
+    // the errors as the parser and resolver report them, which already say where they are
+    struct ExpandError : public Exception
+    {
+        using Exception::Exception;
+
+        [[nodiscard]] auto report() const -> const std::string&
+        {
+            return m_message;
+        }
+    };
+} // namespace loxe
+
+#endif // !LOXE_PARSER_ERROR_HPP
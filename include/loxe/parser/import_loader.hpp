@@ -0,0 +1,108 @@
+#pragma once
+
+#ifndef LOXE_PARSER_IMPORT_LOADER_HPP
+#define LOXE_PARSER_IMPORT_LOADER_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <variant>
+#include <vector>
+
+#include "loxe/common/utility.hpp"
+
+#include "arena.hpp"
+#include "ast.hpp"
+#include "error.hpp"
+#include "source_map.hpp"
+
+namespace loxe
+{
+    // parses every file a program imports exactly once, on a pool of threads, while the
+    // importing files are still being parsed. nothing is spliced into the tree until all
+    // of them are done; then the imports are walked depth first in source order, the way
+    // a serial parser would meet them, so the first import of a file gets its statements
+    // and every later one (including cycles) an empty body.
+    class ImportLoader
+    {
+    public:
+        struct Unit;
+
+        struct Import
+        {
+            Span             keyword;
+            ast::ImportStmt* statement;
+            Unit*            unit;
+        };
+
+        // what a parser met that has to be reported in source order
+        using Event = std::variant<ParseError, Import>;
+
+        struct Unit
+        {
+            std::string        path       = {}; // as written by whichever import came first
+            ast::Arena         arena      = {};
+            ast::stmt_list     statements = {};
+            std::vector<Event> events     = {};
+            bool               found      = true;
+            bool               spliced    = false;
+        };
+
+    public:
+        // `defer_bodies` has imported files parsed with their function bodies skipped
+        explicit ImportLoader(SourceMap& sources, bool defer_bodies = false)
+            : m_sources(&sources), m_defer_bodies(defer_bodies) {}
+
+        ImportLoader(const ImportLoader&) = delete;
+        ~ImportLoader();
+
+        auto operator=(const ImportLoader&) -> ImportLoader& = delete;
+
+        // the unit of the file parsing starts from, so that importing it again does nothing.
+        // its errors are reported under `filename`
+        [[nodiscard]] auto root(std::string filename) -> Unit&;
+
+        // notes that `from` imports `statement`'s file and has it parsed, unless that
+        // already happened or is happening
+        auto request(Unit& from, const Span& keyword, ast::ImportStmt& statement) -> void;
+
+        // offsets for a source parsed by any of the threads
+        [[nodiscard]] auto add_source(std::string_view text, std::string path) -> std::uint32_t;
+
+        // waits for the imports requested so far, then reports the errors `root` met and fills
+        // in its import statements up to here. later calls pick up where the last one stopped
+        [[nodiscard]] auto flush(Unit& root) -> bool;
+
+        // waits for every import, reports all errors and fills in the import statements.
+        // the arenas of imported files are handed to `arena`
+        [[nodiscard]] auto finish(Unit& root, ast::Arena& arena) -> bool;
+
+    private:
+        [[nodiscard]] static auto canonical(std::string_view path) -> std::string;
+
+        auto work()                                    -> void;
+        auto load(Unit& unit)                          -> void;
+        auto splice(Unit& unit, std::string_view name) -> bool;
+
+    private:
+        SourceMap*                 m_sources      = nullptr;
+        bool                       m_defer_bodies = false;
+        std::deque<Unit>           m_units        = {};
+        utility::string_map<Unit*> m_cache        = {};
+
+        std::mutex                 m_mutex   = {};
+        std::condition_variable    m_wake    = {};
+        std::condition_variable    m_idle    = {};
+        std::deque<Unit*>          m_queue   = {};
+        std::size_t                m_pending = 0;
+        bool                       m_stop    = false;
+        std::vector<std::jthread>  m_workers = {};
+    };
+} // namespace loxe
+
+#endif // !LOXE_PARSER_IMPORT_LOADER_HPP
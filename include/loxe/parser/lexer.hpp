@@ -3,21 +3,40 @@
 #ifndef LOXE_PARSER_LEXER_HPP
 #define LOXE_PARSER_LEXER_HPP
 
-#include <string>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
 #include <optional>
+#include <string>
+#include <string_view>
 
+#include "arena.hpp"
+#include "source_map.hpp"
 #include "token.hpp"
+#include "token_buffer.hpp"
 
 namespace loxe
 {
     class Lexer
     {
     public:
-        Lexer(std::string source = {})
-            : m_line(1), m_column(1), m_cursor(0), m_source(std::move(source)) {}
+        // unescaped string literals are written to `keep`, or to the lexer itself without one.
+        // token offsets count from `base`, the offset a SourceMap gave the source
+        Lexer(std::string_view source = {}, ast::Arena* keep = nullptr, std::uint32_t base = 0)
+            : m_cursor(0), m_base(base), m_source(source), m_keep(keep) {}
+
+        // pulls `input` in blocks of `chunk` bytes, only keeping the window that live tokens
+        // still view. a token's lexeme is valid until it drops out of the previous/current/next
+        // cache, unless `keep` is given, in which case lexemes are copied into that arena.
+        // the start of every line read is added to `file`. a `chunk` of 0 pulls a line at a time
+        // instead, so input that arrives slowly is lexed as it comes rather than once a block is in
+        Lexer(std::istream& input, SourceMap::File& file, ast::Arena* keep = nullptr, std::size_t chunk = 64 * 1024);
 
         auto lex() -> Lexer&;
 
+        // lexes everything left of an in-memory source in one go
+        [[nodiscard]] auto tokenize() -> TokenBuffer;
+
         [[nodiscard]] auto peek_prev() const -> const Token&;
         [[nodiscard]] auto peek_curr() const -> const Token&;
         [[nodiscard]] auto peek_next() const -> const Token&;
@@ -29,19 +48,43 @@ namespace loxe
         [[nodiscard]] auto lex_identifier()  -> Token;
         [[nodiscard]] auto lex_punctuation() -> Token;
 
-        [[nodiscard]] auto at_end() const -> bool;
-        [[nodiscard]] auto peek0()  const -> std::optional<char>;
-        [[nodiscard]] auto peek1()  const -> std::optional<char>;
+        [[nodiscard]] auto slice(std::size_t start) const -> std::string_view;
+        [[nodiscard]] auto storage()                      -> ast::Arena&;
+
+        [[nodiscard]] auto at_end() -> bool;
+        [[nodiscard]] auto peek0()  -> std::optional<char>;
+        [[nodiscard]] auto peek1()  -> std::optional<char>;
+        [[nodiscard]] auto refill() -> bool;
 
         [[nodiscard]] auto skip_whitespace() -> std::optional<char>;
         [[nodiscard]] auto skip_comment()    -> std::optional<char>;
         [[nodiscard]] auto advance()         -> std::optional<char>;
 
+        [[nodiscard]] auto here()     const -> const char*;
+        [[nodiscard]] auto end()      const -> const char*;
+        [[nodiscard]] auto position() const -> std::uint32_t;
+        auto move_to(const char* position) -> void;
+
     private:
-        int         m_line   = 1;
-        int         m_column = 1;
-        std::size_t m_cursor = 0;
-        std::string m_source = {};
+        struct Stream
+        {
+            std::istream&    input;
+            SourceMap::File& file;
+            std::size_t      chunk;
+            std::string      window  = {};
+            std::size_t      dropped = 0;
+        };
+
+    private:
+        std::size_t      m_cursor = 0;
+        std::size_t      m_start  = 0;
+        bool             m_primed = false;
+        std::uint32_t    m_base   = 0;
+        std::string_view m_source = {};
+
+        ast::Arena*             m_keep   = nullptr;
+        ast::Arena              m_own    = {};
+        std::unique_ptr<Stream> m_stream = nullptr;
 
         struct
         {
@@ -3,31 +3,69 @@
 #ifndef LOXE_PARSER_PARSER_HPP
 #define LOXE_PARSER_PARSER_HPP
 
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <optional>
-#include <unordered_set>
-
-#include "loxe/common/except.hpp"
+#include <vector>
 
 #include "ast.hpp"
+#include "error.hpp"
+#include "import_loader.hpp"
 #include "lexer.hpp"
+#include "source.hpp"
+#include "source_map.hpp"
 #include "token.hpp"
+#include "token_buffer.hpp"
 
 namespace loxe
 {
     class Parser
     {
     public:
-        struct ParseError : public Exception
+        // with `defer_imports`, the bodies of functions and methods in imported files are only
+        // brace matched, and parsed by `parse_body` once something needs them. the file parsing
+        // starts from is always parsed in full, so its mistakes are still reported up front
+        explicit Parser(bool defer_imports = false)
+            : m_defer_imports(defer_imports) {}
+
+        // takes each top-level statement of a program as soon as it and the files it imports
+        // are parsed, along with the map its offsets are in, and null once an error means no
+        // more will follow. returning false stops parsing
+        using ready_fn = std::function<bool(ast::stmt_ptr, const SourceMap&)>;
+
+        [[nodiscard]] auto parse(Source source, std::string filename = {})        -> std::optional<ast::Program>;
+        [[nodiscard]] auto parse(std::istream& input, std::string filename = {}) -> std::optional<ast::Program>;
+
+        // after an error, the rest is only parsed to report everything else that is wrong. the
+        // program comes back either way: the statements handed out may still be running
+        [[nodiscard]] auto parse(std::istream& input, std::string filename, const ready_fn& ready) -> ast::Program;
+
+        // the block of a function whose body was skipped while its file was parsed, built into
+        // `program`. errors are thrown as an `ExpandError`, under the name the file was opened by
+        [[nodiscard]] auto parse_body(ast::Program& program, const Span& body) -> ast::stmt_ptr;
+
+    private:
+        friend class ImportLoader;
+
+        // counts one level of statement nesting for as long as it is being parsed
+        class Nesting
         {
-            ParseError(Token token, std::string message, std::string filename);
+        public:
+            explicit Nesting(std::size_t& depth)
+                : m_depth(depth) { m_depth++; }
+            ~Nesting() { m_depth--; }
+
+            Nesting(const Nesting&)                    = delete;
+            auto operator=(const Nesting&) -> Nesting& = delete;
 
-            const Token token;
+        private:
+            std::size_t& m_depth;
         };
 
-    public:
-        [[nodiscard]] auto parse(std::string source, std::string filename = {}) -> std::optional<ast::stmt_list>;
+        [[nodiscard]] auto parse_program(ast::Arena& arena, SourceMap& sources, ImportLoader& loader) -> std::optional<ast::Program>;
+        auto parse_import(ImportLoader& loader, ImportLoader::Unit& unit, std::string_view text)       -> void;
 
-    private:
         [[nodiscard]] auto parse_dec_or_stmt() -> ast::stmt_ptr;
         [[nodiscard]] auto parse_declaration() -> ast::stmt_ptr;
         [[nodiscard]] auto parse_class_dec()   -> ast::stmt_ptr;
@@ -48,29 +86,23 @@ namespace loxe
         [[nodiscard]] auto parse_return_stmt()   -> ast::stmt_ptr;
         [[nodiscard]] auto parse_while_stmt()    -> ast::stmt_ptr;
 
-        [[nodiscard]] auto parse_expression()  -> ast::expr_ptr;
-        [[nodiscard]] auto parse_comma()       -> ast::expr_ptr;
-        [[nodiscard]] auto parse_conditional() -> ast::expr_ptr;
-        [[nodiscard]] auto parse_assignment()  -> ast::expr_ptr;
-        [[nodiscard]] auto parse_logical_or()  -> ast::expr_ptr;
-        [[nodiscard]] auto parse_logical_and() -> ast::expr_ptr;
-        [[nodiscard]] auto parse_equality()    -> ast::expr_ptr;
-        [[nodiscard]] auto parse_comparison()  -> ast::expr_ptr;
-        [[nodiscard]] auto parse_term()        -> ast::expr_ptr;
-        [[nodiscard]] auto parse_factor()      -> ast::expr_ptr;
-        [[nodiscard]] auto parse_unary()       -> ast::expr_ptr;
-        [[nodiscard]] auto parse_call()        -> ast::expr_ptr;
-        [[nodiscard]] auto parse_primary()     -> ast::expr_ptr;
-
-        [[nodiscard]] auto parse_lambda()      -> ast::expr_ptr;
-        [[nodiscard]] auto parse_super()       -> ast::expr_ptr;
-        [[nodiscard]] auto parse_array()       -> ast::expr_ptr;
-        [[nodiscard]] auto parse_grouping()    -> ast::expr_ptr;
-        [[nodiscard]] auto parse_initializer() -> ast::expr_list;
-
-        [[nodiscard]] auto finish_call(ast::expr_ptr callee) -> ast::expr_ptr;
-        [[nodiscard]] auto function(const std::string& kind) -> ast::fun_ptr;
+        [[nodiscard]] auto parse_expression()                -> ast::expr_ptr;
+        [[nodiscard]] auto parse_prefix()                    -> ast::expr_ptr;
+        [[nodiscard]] auto parse_postfix(ast::expr_ptr expr) -> ast::expr_ptr;
+        [[nodiscard]] auto parse_lambda()                    -> ast::expr_ptr;
+        [[nodiscard]] auto parse_super()                     -> ast::expr_ptr;
+
+        auto open_infix(ast::expr_ptr lhs)                                  -> void;
+        [[nodiscard]] auto open_initializer(Span start, ast::expr_ptr size) -> ast::expr_ptr;
+        [[nodiscard]] auto reduce(ast::expr_ptr expr)                       -> ast::expr_ptr;
+        [[nodiscard]] auto close(ast::expr_ptr expr)                        -> ast::expr_ptr;
+        [[nodiscard]] auto comma(std::size_t base)                          -> ast::expr_ptr;
+        [[nodiscard]] auto take(std::size_t base)                           -> ast::expr_list;
+
+        [[nodiscard]] auto function(const std::string& kind, bool deferrable = false) -> ast::fun_ptr;
+        [[nodiscard]] auto skip_body()                                                -> std::optional<Span>;
 
+        [[nodiscard]] auto peek()                  const -> Token::Type;
         [[nodiscard]] auto check(Token::Type type) const -> bool;
         [[nodiscard]] auto match(Token::Type type)       -> bool;
 
@@ -78,19 +110,96 @@ namespace loxe
         [[nodiscard]] auto current()  const -> Token;
         [[nodiscard]] auto previous() const -> Token;
         [[nodiscard]] auto next()           -> Token;
+        auto advance()                      -> void;
+
+        template<typename T, typename... Args>
+        [[nodiscard]] auto make(Args&&... args) -> T*
+        {
+            return m_arena->make<T>(std::forward<Args>(args)...);
+        }
 
     private:
         auto consume(Token::Type type, std::string msg) -> Token;
-        auto error(Token token, std::string msg)        -> ParseError;
+        auto error(Span token, std::string msg)         -> ParseError;
         auto synchronize()                              -> void;
+        auto use_source(std::string_view text)          -> void;
+
+        // blocks, modules and the bodies of loops, branches and functions each take a few calls
+        // to parse, so they may only nest as deep as the resolver lets expressions, and deeper
+        // is an error here rather than a stack overflow. a function body takes the most calls,
+        // so it counts twice along with its block. nothing after such an error is parsed
+        static constexpr auto max_nesting = std::size_t{4096};
+
+        [[nodiscard]] auto nest() -> Nesting;
+
+        // how tightly an infix operator binds, loosest first
+        enum class Precedence : std::uint8_t
+        {
+            None,
+            Conditional,
+            Assignment,
+            Or,
+            And,
+            Equality,
+            Comparison,
+            Term,
+            Factor,
+            Unary,
+        };
 
-        using files = std::unordered_set<std::string>;
+        [[nodiscard]] static auto infix_precedence(Token::Type type) -> Precedence;
+
+        // a part of an expression still waiting on an operand. operators are reduced as soon
+        // as one binding looser than `floor` follows their operand; the other kinds have no
+        // floor and wait for the token that closes them instead
+        struct Frame
+        {
+            enum class Kind : std::uint8_t
+            {
+                Expression,
+                Grouping,
+                Subscript,
+                ArraySize,
+                Initializer,
+                Call,
+                Then,
+
+                Binary,
+                Unary,
+                Assign,
+                Else,
+                Missing,
+            };
+
+            Kind          kind;
+            Precedence    floor  = Precedence::None;
+            Span          token  = {};
+            ast::expr_ptr lhs    = nullptr;
+            ast::expr_ptr middle = nullptr;
+            std::size_t   base   = 0; // where the frame's list starts in `m_operands`
+        };
 
     private:
         bool  m_error          = false;
+        bool  m_too_deep       = false;
+        bool  m_defer_imports  = false;
+        bool  m_defer          = false; // skip the bodies of declared functions and methods
         Lexer m_lexer          = {};
-        files m_import_files   = {};
-        std::string m_filename = {}; 
+
+        // in-memory sources are tokenized up front and walked by index; only streamed input
+        // goes through `m_lexer` token by token
+        bool        m_buffered = false;
+        TokenBuffer m_tokens   = {};
+        std::size_t m_index    = 0;
+        std::size_t m_nesting  = 0;
+
+        const ready_fn*     m_ready  = nullptr;
+        ast::Arena*         m_arena  = nullptr;
+        ImportLoader*       m_loader = nullptr;
+        ImportLoader::Unit* m_unit   = nullptr;
+
+        std::vector<Frame>         m_frames   = {};
+        std::vector<ast::expr_ptr> m_operands = {};
     };
 } // namespace loxe
 
@@ -0,0 +1,74 @@
+#pragma once
+
+#ifndef LOXE_PARSER_PIPELINE_HPP
+#define LOXE_PARSER_PIPELINE_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <istream>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+
+#include "ast.hpp"
+#include "resolver.hpp"
+
+namespace loxe
+{
+    // parses and resolves a program on a thread of its own, handing out each top-level
+    // statement as soon as it and the files it imports are ready, so running it can start
+    // long before the input ends. imported files are parsed in full: expanding a skipped
+    // body later would race the thread that is still adding to the program
+    class Pipeline
+    {
+    public:
+        enum class State
+        {
+            Ok,
+            ParseError,
+            ResolveError,
+        };
+
+    public:
+        Pipeline(std::istream& input, std::string filename);
+        Pipeline(const Pipeline&) = delete;
+        ~Pipeline();
+
+        auto operator=(const Pipeline&) -> Pipeline& = delete;
+
+        // waits for the next statement. null once the input ended, or was cut short by an error
+        [[nodiscard]] auto next() -> ast::stmt_ptr;
+
+        // has parsing end after the statement in progress. input that is still arriving
+        // is read up to the end of that statement first
+        auto stop() -> void;
+
+        // wait for the thread. errors are reported as they are met, the program only
+        // outlives the thread so the statements handed out stay alive
+        [[nodiscard]] auto program() -> ast::Program&;
+        [[nodiscard]] auto state()   -> State;
+
+    private:
+        auto work(std::istream& input, std::string filename) -> void;
+
+    private:
+        static constexpr auto batch = std::size_t{64};
+        static constexpr auto poll  = std::chrono::milliseconds(1);
+
+        std::mutex                  m_mutex   = {};
+        std::condition_variable     m_wake    = {};
+        std::deque<ast::stmt_ptr>   m_queue   = {};
+        std::deque<ast::stmt_ptr>   m_taken   = {}; // only touched by the thread calling `next`
+        bool                        m_waiting = false;
+        bool                        m_stop    = false;
+        bool                        m_done    = false;
+        State                       m_state   = State::Ok;
+        std::optional<ast::Program> m_program = {};
+        std::jthread                m_thread  = {};
+    };
+} // namespace loxe
+
+#endif // !LOXE_PARSER_PIPELINE_HPP
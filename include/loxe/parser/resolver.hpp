@@ -3,8 +3,12 @@
 #ifndef LOXE_PARSER_RESOLVER_HPP
 #define LOXE_PARSER_RESOLVER_HPP
 
-#include <vector>
+#include <cstdint>
+#include <memory>
 #include <unordered_map>
+#include <vector>
+
+#include "loxe/common/utility.hpp"
 
 #include "ast.hpp"
 
@@ -15,11 +19,13 @@ namespace loxe
     public:
         struct Attribute
         {
-            Attribute(bool defined = false, bool assignable = false)
-                : defined(defined), assignable(assignable) {}
+            Attribute(bool defined = false, bool assignable = false, std::size_t slot = 0)
+                : defined(defined), assignable(assignable), slot(slot) {}
 
-            bool defined    = false;
-            bool assignable = false;
+            bool        defined    = false;
+            bool        assignable = false;
+            bool        hoisted    = false;
+            std::size_t slot       = 0;
         };
 
         enum class State
@@ -28,11 +34,55 @@ namespace loxe
             Error,
         };
 
-        using map   = std::unordered_map<std::string, Attribute>;
+        enum class FunType
+        {
+            Function,
+            Initializer,
+            Method,
+            None,
+        };
+
+        enum class ClsType
+        {
+            Class,
+            None,
+            SubClass,
+        };
+
+        using map   = utility::string_map<Attribute>;
         using stack = std::vector<map>;
 
+        // what surrounded a function whose body was skipped: copies of the scopes it was
+        // declared in, outermost first and without the globals, and what it was nested in
+        struct Context
+        {
+            std::vector<std::shared_ptr<const map>> scopes   = {};
+            FunType                                 fun_type = FunType::None;
+            ClsType                                 cls_type = ClsType::None;
+            int                                     loops    = 0;
+        };
+
+        // how many sites of each kind the program's nodes have been numbered with so far
+        struct Sites
+        {
+            std::uint32_t properties = 0;
+            std::uint32_t supers     = 0;
+            std::uint32_t strings    = 0;
+        };
+
     public:
-        auto resolve_ast(const ast::stmt_list& ast) -> State;
+        // a program with skipped bodies gets the resolver moved into its arena for `expand`
+        auto resolve_ast(ast::Program& program) -> State;
+
+        // for programs run while they are still being parsed: `begin` opens the globals, then
+        // each top-level statement is hoisted and resolved on its own as it arrives. errors stick
+        auto begin(const SourceMap& sources)  -> void;
+        auto resolve_stmt(ast::stmt_ptr stmt) -> State;
+
+        // parses a skipped function body and resolves it as if that had happened in place. what
+        // goes wrong is thrown as an `ExpandError`, and leaves the body missing so the next call
+        // fails the same way. `State::Error` is only for a body that is missing with no text
+        auto expand(ast::Program& program, const ast::FunctionExpr& function) -> State;
 
     private:
         auto resolve(const ast::stmt_list& stmts) -> void;
@@ -78,42 +128,56 @@ namespace loxe
         auto visit(ast::VariableExpr&    expr) -> void override;
 
     private:
-        enum class FunType
-        {
-            Function,
-            Initializer,
-            Method,
-            None,
-        };
+        friend class AstCache;
 
-        enum class ClsType
-        {
-            Class,
-            None,
-            SubClass,
-        };
-
-    private:
         auto begin_scope() -> void;
         auto end_scope()   -> void;
         auto begin_loop()  -> void;
         auto end_loop()    -> void;
 
-        auto declare(const Token& name, bool assignable = false) -> void;
-        auto define(const Token& name)                           -> void;
+        auto declare(const Span& name, bool assignable = false) -> std::size_t;
+        auto define(const Span& name)                           -> void;
+        auto hoist(const ast::stmt_list& stmts)                 -> void;
+        auto hoist(const Span& name, bool assignable)           -> void;
+        auto global_scope() const                               -> bool;
 
-        auto resolve_local(ast::Expr& expr, const Token& name) -> void;
-        auto resolve_function(ast::FunctionExpr&, FunType)     -> void;
+        auto resolve_local(ast::Expr& expr, const Span& name) -> void;
+        auto resolve_function(ast::FunctionExpr&, FunType)    -> void;
+        auto defer(const ast::FunctionExpr&, FunType)         -> void;
 
-        auto error(const Token& token, std::string message) -> void;
+        auto error(const Span& token, std::string message)     -> void;
+        auto error(std::uint32_t offset, std::string message)  -> void;
+        auto report(std::string error)                         -> void;
+
+        [[nodiscard]] static auto offset(const ast::Expr& expr) -> std::uint32_t;
 
     private:
+        // how deep expressions may nest, counting the statements around them. every pass after
+        // this one recurses over them too, so anything deeper is an error here rather than a
+        // stack overflow further on. `m_deepest` is how deep the current function body gets
+        static constexpr auto max_nesting = std::size_t{4096};
+
+        const SourceMap* m_sources = nullptr;
+        std::string*     m_errors  = nullptr; // where errors go while a body is expanded
+
+        std::size_t m_nesting  = 0;
+        std::size_t m_deepest  = 0;
+        bool        m_too_deep = false;
+
+        Sites   m_sites    = {};
         int     m_loops    = 0;
         bool    m_assign   = false;
         stack   m_scopes   = {};
         State   m_state    = State::Ok;
         FunType m_fun_type = FunType::None;
         ClsType m_cls_type = ClsType::None;
+
+        // `m_frozen` holds the last copy taken of each scope in `m_scopes`, to be shared by every
+        // skipped body declared in it while it doesn't grow. `m_outer` are the copies a body
+        // that is being expanded was declared in, which sit between the globals and `m_scopes`
+        std::vector<std::shared_ptr<const map>>               m_frozen   = {};
+        std::vector<std::shared_ptr<const map>>               m_outer    = {};
+        std::unordered_map<const ast::FunctionExpr*, Context> m_deferred = {};
     };
 } // namespace loxe
 
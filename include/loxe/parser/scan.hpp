@@ -0,0 +1,21 @@
+#pragma once
+
+#ifndef LOXE_PARSER_SCAN_HPP
+#define LOXE_PARSER_SCAN_HPP
+
+// bulk scanning primitives used by the lexer. each one works on the half-open
+// range [first, last) and never reads past `last`. the implementation is picked
+// once at startup from what the cpu supports.
+namespace loxe::scan
+{
+    // first character that is not ' ', '\t', '\r' or '\n'
+    [[nodiscard]] auto skip_blanks(const char* first, const char* last) -> const char*;
+
+    // first character that can't continue an identifier
+    [[nodiscard]] auto skip_ident(const char* first, const char* last) -> const char*;
+
+    // first occurrence of `c`, or `last`
+    [[nodiscard]] auto find(const char* first, const char* last, char c) -> const char*;
+} // namespace loxe::scan
+
+#endif // !LOXE_PARSER_SCAN_HPP
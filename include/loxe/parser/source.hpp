@@ -0,0 +1,42 @@
+#pragma once
+
+#ifndef LOXE_PARSER_SOURCE_HPP
+#define LOXE_PARSER_SOURCE_HPP
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace loxe
+{
+    // the text of a script. regular files are mapped read-only and viewed in
+    // place; pipes, stdin and anything else that can't be mapped are read into
+    // an owned buffer instead.
+    class Source
+    {
+    public:
+        Source() = default;
+        explicit Source(std::string text);
+        Source(Source&&) noexcept;
+        Source(const Source&) = delete;
+        ~Source();
+
+        auto operator=(Source&&) noexcept -> Source&;
+        auto operator=(const Source&) -> Source& = delete;
+
+        [[nodiscard]] static auto open(const std::string& path) -> std::optional<Source>;
+
+        [[nodiscard]] auto text() const -> std::string_view;
+
+    private:
+        auto release() -> void;
+
+    private:
+        void*       m_mapping = nullptr;
+        std::size_t m_size    = 0;
+        std::string m_buffer  = {};
+    };
+} // namespace loxe
+
+#endif // !LOXE_PARSER_SOURCE_HPP
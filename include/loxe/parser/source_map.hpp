@@ -0,0 +1,56 @@
+#pragma once
+
+#ifndef LOXE_PARSER_SOURCE_MAP_HPP
+#define LOXE_PARSER_SOURCE_MAP_HPP
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace loxe
+{
+    // gives every file of a program its own range of 32-bit offsets, so a single offset
+    // says both which file a token is in and where. lines and columns are only worked
+    // out when an error is reported, from a line table built on first use.
+    class SourceMap
+    {
+    public:
+        struct File
+        {
+            std::uint32_t    base = 0;
+            std::string_view text = {};
+            std::string      path = {}; // as the file was opened, empty for streamed input
+
+            // where each line starts, relative to `base`. streamed files have no text to
+            // build this from later, so the lexer fills it in while reading
+            mutable std::vector<std::uint32_t> lines = {};
+        };
+
+    public:
+        auto add(std::string_view text, std::string path = {}) -> const File&;
+
+        // puts a file back at the offsets it had in another map, for trees that were built
+        // against that map. files have to be restored in the order they were added there
+        auto restore(std::uint32_t base, std::string_view text, std::string path) -> const File&;
+
+        // the length of streamed input isn't known up front, so it is given half of the
+        // offsets still free and files added after it take the rest
+        auto add_stream() -> File&;
+
+        [[nodiscard]] auto file(std::uint32_t offset) const -> const File*;
+
+        // (-1, -1) for offsets outside of any file, like those of implicit tokens
+        [[nodiscard]] auto position(std::uint32_t offset) const -> std::pair<int, int>;
+
+        [[nodiscard]] auto files() const -> const std::deque<File>&;
+
+    private:
+        std::deque<File> m_files = {};
+        std::uint32_t    m_next  = 0;
+    };
+} // namespace loxe
+
+#endif // !LOXE_PARSER_SOURCE_MAP_HPP
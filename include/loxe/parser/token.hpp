@@ -3,14 +3,17 @@
 #ifndef LOXE_PARSER_TOKEN_HPP
 #define LOXE_PARSER_TOKEN_HPP
 
+#include <cstdint>
+#include <limits>
 #include <string>
+#include <string_view>
 
 namespace loxe
 {
     class Token
     {
     public:
-        enum class Type
+        enum class Type : std::uint8_t
         {
             // single-character tokens
             Colon,
@@ -75,8 +78,14 @@ namespace loxe
         };
 
     public:
-        Token(Type type = Type::Unknown, int line = -1, int column = -1, std::string lexeme = {})
-            : line(line), column(column), type(type), lexeme(std::move(lexeme)) {}
+        // the offset of tokens that don't come from any source
+        static constexpr auto nowhere = std::numeric_limits<std::uint32_t>::max();
+
+        // `lexeme` views the source buffer (or static text), which must outlive the token.
+        // for strings it is the unescaped contents; for numbers `number` holds the value.
+        // `offset` is where the token starts, counted in a SourceMap's offsets
+        Token(Type type = Type::Unknown, std::uint32_t offset = nowhere, std::string_view lexeme = {}, double number = 0)
+            : type(type), offset(offset), lexeme(lexeme), number(number) {}
 
         [[nodiscard]] auto to_string()   const -> std::string;
         [[nodiscard]] auto type_string() const -> std::string;
@@ -85,10 +94,24 @@ namespace loxe
         [[nodiscard]] static auto ident_type(std::string_view identifier) -> Type;
 
     public:
-        int         line   = -1;
-        int         column = -1;
-        Type        type   = Type::Unknown;
-        std::string lexeme = {};
+        Type             type   = Type::Unknown;
+        std::uint32_t    offset = nowhere;
+        std::string_view lexeme = {};
+        double           number = 0;
+    };
+
+    // what the syntax tree keeps of a token
+    struct Span
+    {
+        Span(Token::Type type = Token::Type::Unknown, std::uint32_t offset = Token::nowhere, std::string_view lexeme = {})
+            : type(type), offset(offset), lexeme(lexeme) {}
+
+        Span(const Token& token)
+            : type(token.type), offset(token.offset), lexeme(token.lexeme) {}
+
+        Token::Type      type   = Token::Type::Unknown;
+        std::uint32_t    offset = Token::nowhere;
+        std::string_view lexeme = {};
     };
 } // namespace loxe
 
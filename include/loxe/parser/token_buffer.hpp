@@ -0,0 +1,83 @@
+#pragma once
+
+#ifndef LOXE_PARSER_TOKEN_BUFFER_HPP
+#define LOXE_PARSER_TOKEN_BUFFER_HPP
+
+#include <limits>
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <string_view>
+
+#include "token.hpp"
+
+namespace loxe
+{
+    // every token of a source, stored column-wise so walking the types stays
+    // dense. offsets are kept relative to the source and lexemes are sliced
+    // back out of it when a token is materialized.
+    class TokenBuffer
+    {
+    public:
+        static constexpr auto max_source = std::size_t{std::numeric_limits<std::uint32_t>::max()};
+
+        TokenBuffer() = default;
+        TokenBuffer(std::string_view source, std::uint32_t base)
+            : m_source(source), m_base(base) {}
+
+        auto reserve(std::size_t count) -> void;
+
+        auto push(const Token& token) -> void;
+
+        [[nodiscard]] auto size()                 const -> std::size_t;
+        [[nodiscard]] auto type(std::size_t i)    const -> Token::Type;
+        [[nodiscard]] auto lexeme(std::size_t i)  const -> std::string_view;
+        [[nodiscard]] auto token(std::size_t i)   const -> Token;
+
+    private:
+        // values belonging to a few tokens only, kept in token order. lookups mostly
+        // come in order too, so the last hit and the entry after it are tried first
+        template<typename T>
+        struct Side
+        {
+            std::vector<std::pair<std::uint32_t, T>> entries = {};
+            mutable std::size_t                      hint    = 0;
+
+            [[nodiscard]] auto get(std::size_t token, T fallback) const -> T
+            {
+                const auto index = static_cast<std::uint32_t>(token);
+                auto holds = [&](std::size_t entry) { return entry < entries.size() && entries[entry].first == index; };
+
+                if (!holds(hint))
+                {
+                    if (holds(hint + 1))
+                        hint++;
+                    else
+                    {
+                        const auto found = std::ranges::lower_bound(entries, index, {}, &std::pair<std::uint32_t, T>::first);
+                        if (found == entries.end() || found->first != index) return fallback;
+                        hint = static_cast<std::size_t>(found - entries.begin());
+                    }
+                }
+
+                return entries[hint].second;
+            }
+        };
+
+    private:
+        std::string_view           m_source  = {};
+        std::uint32_t              m_base    = 0;
+        std::vector<Token::Type>   m_types   = {};
+        std::vector<std::uint32_t> m_offsets = {};
+        std::vector<std::uint32_t> m_lengths = {};
+
+        // lexemes that aren't a slice of the source: error messages of `Unknown`
+        // tokens and unescaped strings
+        Side<std::string_view> m_texts   = {};
+        Side<double>           m_numbers = {};
+    };
+} // namespace loxe
+
+#endif // !LOXE_PARSER_TOKEN_BUFFER_HPP
@@ -9,10 +9,12 @@
 #include <cstdint>
 #include <unordered_map>
 
+#include "loxe/common/utility.hpp"
 #include "loxe/parser/ast.hpp"
 #include "loxe/parser/token.hpp"
 
 #include "object.hpp"
+#include "symbol.hpp"
 
 namespace loxe::tree_walker
 {
@@ -20,28 +22,34 @@ namespace loxe::tree_walker
     class Environment;
     class InstanceObj;
 
-    class Callable
+    class Callable : public HeapObj
     {
     public:
+        static constexpr auto heap_kind = Kind::Callable;
         using args = std::vector<Object>;
 
     public:
+        Callable()
+            : HeapObj(heap_kind) {}
+
         virtual ~Callable() = default;
         virtual auto call(Interpreter&, args) const -> Object      = 0;
         virtual auto arity()                  const -> std::size_t = 0;
         virtual auto to_string()              const -> std::string = 0;
     };
 
+    // functions point into the program's AST instead of copying their
+    // declaration, so the AST must outlive the interpreter that runs it
     class FunctionObj : public Callable
     {
     public:
-        using dec_ptr  = std::shared_ptr<ast::FunctionExpr>;
+        using dec_ptr  = const ast::FunctionExpr*;
         using env_ptr  = std::shared_ptr<Environment>;
-        using inst_ptr = std::shared_ptr<InstanceObj>;
+        using inst_ptr = Ref<InstanceObj>;
 
     public:
         FunctionObj(dec_ptr declaration, env_ptr closure, bool init = false)
-            : m_init(init), m_closure(std::move(closure)), m_declaration(std::move(declaration)) {}
+            : m_init(init), m_closure(std::move(closure)), m_declaration(declaration) {}
 
         auto call(Interpreter&, args) const -> Object      override;
         auto arity()                  const -> std::size_t override;
@@ -55,28 +63,32 @@ namespace loxe::tree_walker
         dec_ptr m_declaration;
     };
 
+    // a class copies its superclass's methods into its own table when it is made, so finding
+    // a method is one lookup by the name's symbol however deep the hierarchy is. a class with
+    // no `init` of its own runs the one it inherits when it is called
     class ClassObj : public Callable
     {
     public:
-        using fun_ptr      = std::shared_ptr<FunctionObj>;
-        using super_type   = std::shared_ptr<ClassObj>;
-        using methods_type = std::unordered_map<std::string, fun_ptr>;
+        using fun_ptr      = Ref<FunctionObj>;
+        using super_type   = Ref<ClassObj>;
+        using methods_type = std::unordered_map<Symbols::id, fun_ptr>;
 
     public:
-        ClassObj(Token name, methods_type methods, super_type superclass)
-            : m_name(std::move(name)), m_superclass(std::move(superclass)), m_methods(std::move(methods)) {}
+        ClassObj(Span name, methods_type methods, fun_ptr init, const super_type& superclass);
 
         auto call(Interpreter&, args) const -> Object      override;
         auto arity()                  const -> std::size_t override;
         auto to_string()              const -> std::string override;
 
-        auto name()                         const -> const std::string&;
-        auto find_method(const Token& name) const -> fun_ptr;
+        auto id()                            const -> std::uint64_t;
+        auto name()                          const -> std::string_view;
+        auto find_method(Symbols::id symbol) const -> FunctionObj*;
 
     private:
-        Token        m_name;
-        super_type   m_superclass;
-        methods_type m_methods;
+        Span          m_name;
+        fun_ptr       m_init;
+        methods_type  m_methods;
+        std::uint64_t m_id;
     };
 } // namespace loxe::tree_walker
 
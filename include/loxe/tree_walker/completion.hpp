@@ -0,0 +1,21 @@
+#pragma once
+
+#ifndef LOXE_TREE_WALKER_COMPLETION_HPP
+#define LOXE_TREE_WALKER_COMPLETION_HPP
+
+#include <cstdint>
+
+namespace loxe::tree_walker
+{
+    // how a statement finished executing: anything other than `Normal` unwinds
+    // the enclosing statements until a loop or function call consumes it
+    enum class Completion : std::uint8_t
+    {
+        Normal,
+        Break,
+        Continue,
+        Return,
+    };
+} // namespace loxe::tree_walker
+
+#endif // !LOXE_TREE_WALKER_COMPLETION_HPP
@@ -3,11 +3,9 @@
 #ifndef LOXE_TREE_WALKER_ENVIRONMENT_HPP
 #define LOXE_TREE_WALKER_ENVIRONMENT_HPP
 
-#include <string>
+#include <memory>
+#include <vector>
 #include <cstdint>
-#include <unordered_map>
-
-#include "loxe/parser/token.hpp"
 
 #include "object.hpp"
 
@@ -16,25 +14,24 @@ namespace loxe::tree_walker
     class Environment
     {
     public:
-        using value_map = std::unordered_map<std::string, Object>;
+        using env_ptr    = std::shared_ptr<Environment>;
+        using value_list = std::vector<Object>;
 
     public:
-        Environment(Environment* enclosing = nullptr)
-            : m_enclosing(enclosing), m_values({}) {}
+        Environment(env_ptr enclosing, std::size_t slots)
+            : m_enclosing(std::move(enclosing)), m_values(slots) {}
 
-        auto define(const class Token& name, Object value) -> void;
-        auto assign(const class Token& name, Object value) -> const Object&;
-        auto access(const class Token& name)  const        -> const Object&;
+        auto define(std::size_t slot, Object value) -> void;
 
-        auto assign_at(std::size_t depth, const Token& name, Object value) -> const Object&;
-        auto access_at(std::size_t depth, const Token& name) const         -> const Object&;
+        auto assign_at(std::size_t depth, std::size_t slot, Object value) -> const Object&;
+        auto access_at(std::size_t depth, std::size_t slot) const         -> const Object&;
 
     private:
         auto ancestor(std::size_t distance) const -> Environment*;
 
     private:
-        Environment* m_enclosing;
-        value_map    m_values;
+        env_ptr    m_enclosing;
+        value_list m_values;
     };
 } // namespace loxe::tree_walker
 
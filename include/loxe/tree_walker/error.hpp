@@ -5,39 +5,27 @@
 
 #include "loxe/common/utility.hpp"
 #include "loxe/common/except.hpp"
+#include "loxe/parser/source_map.hpp"
 #include "loxe/parser/token.hpp"
 
 #include "object.hpp"
 
 namespace loxe::tree_walker
 {
+    // the token's line and column are only looked up once the error is reported
     struct RuntimeError : public Exception
     {
-        RuntimeError(const Token& token, std::string message)
+        RuntimeError(const Span& token, std::string message)
+            : Exception(std::move(message)), token(token) {}
+
+        [[nodiscard]] auto report(const SourceMap& sources) const -> std::string
         {
             static constexpr auto format = "[{}, {}] RuntimeError at token '{}': {}.";
-            m_message = utility::as_string(format, token.line, token.column, token.lexeme, std::move(message));
+            const auto [line, column] = sources.position(token.offset);
+            return utility::as_string(format, line, column, token.lexeme, m_message);
         }
-    };
-
-    struct ReturnError : public Exception
-    {
-        ReturnError(Object value)
-            : Exception("using exception to return value"), value(std::move(value)) {}
-
-        Object value;
-    };
 
-    struct BreakError : public Exception
-    {
-        BreakError()
-            : Exception("using exception to break from loop") {}
-    };
-
-    struct ContinueError : public Exception
-    {
-        ContinueError()
-            : Exception("using exception to continue in loop") {}
+        Span token;
     };
 } // namespace loxe::tree_walker
 
@@ -5,31 +5,43 @@
 
 #include <string>
 #include <memory>
-#include <unordered_map>
+#include <vector>
+#include <cstdint>
+
+#include "loxe/common/utility.hpp"
 
 #include "object.hpp"
+#include "shape.hpp"
 #include "callable.hpp"
 
 namespace loxe::tree_walker
 {
-    class InstanceObj : public std::enable_shared_from_this<InstanceObj>
+    // fields live in a dense slot vector laid out by the instance's shape. a property access
+    // passes its site's cache along, so a site that keeps seeing the same few shapes skips
+    // the name lookup and goes straight to the slot
+    class InstanceObj : public HeapObj
     {
     public:
-        using class_type = ClassObj;
-        using field_type = std::unordered_map<std::string, Object>;
+        static constexpr auto heap_kind = Kind::Instance;
+        using class_type = Ref<const ClassObj>;
+        using slot_list  = std::vector<Object>;
 
     public:
-        InstanceObj(class_type class_obj)
-            : m_class(std::move(class_obj)), m_fields({}) {}
+        InstanceObj(class_type class_obj, Shape* shape)
+            : HeapObj(heap_kind), m_class(std::move(class_obj)), m_shape(shape), m_slots({}) {}
 
         auto to_string() const -> std::string;
 
-        auto get(const class Token& name)               -> Object;
-        auto set(const class Token& name, Object value) -> Object&;
+        auto get(const struct Span& name, Symbols::id symbol, PropertyCache& cache) -> Object;
+        auto set(const struct Span& name, Object value, PropertyCache& cache)       -> Object&;
+
+    private:
+        auto lookup(const struct Span& name, PropertyCache& cache, bool store) -> const PropertyCache::Entry&;
 
     private:
         class_type m_class;
-        field_type m_fields;
+        Shape*     m_shape;
+        slot_list  m_slots;
     };
 } // namespace loxe::tree_walker
 
@@ -3,72 +3,160 @@
 #ifndef LOXE_TREE_WALKER_INTERPRETER_HPP
 #define LOXE_TREE_WALKER_INTERPRETER_HPP
 
+#include <deque>
 #include <memory>
+#include <vector>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
 
 #include "loxe/parser/ast.hpp"
+#include "loxe/parser/pipeline.hpp"
 
+#include "shape.hpp"
+#include "symbol.hpp"
 #include "object.hpp"
+#include "completion.hpp"
 #include "environment.hpp"
 
 namespace loxe::tree_walker
 {
-    class Interpreter : public ast::Stmt::const_visitor<void>, public ast::Expr::const_visitor<std::any>
+    class Interpreter : public ast::Stmt::const_visitor<Completion>, public ast::Expr::const_visitor<Object>
     {
     public:
-        using env_ptr = std::shared_ptr<Environment>;
+        using env_ptr      = std::shared_ptr<Environment>;
+        using global_list  = std::vector<std::optional<Object>>;
+        using string_table = std::unordered_map<std::string_view, Ref<Object::String>>;
+
+    public:
+        // adds the depth of a function body to the interpreter's for as long as the call lasts
+        class Nesting
+        {
+        public:
+            Nesting(std::size_t& depth, std::size_t body)
+                : m_depth(depth), m_body(body) { m_depth += m_body; }
+            ~Nesting() { m_depth -= m_body; }
+
+            Nesting(const Nesting&)                    = delete;
+            auto operator=(const Nesting&) -> Nesting& = delete;
+
+        private:
+            std::size_t& m_depth;
+            std::size_t  m_body;
+        };
 
     public:
         Interpreter();
 
-        auto interpret(const ast::stmt_list& program)            -> void;
+        auto interpret(ast::Program& program)                    -> void;
+        auto interpret(Pipeline& pipeline)                       -> void;
         auto evaluate (const ast::expr_ptr&  expr)               -> Object;
-        auto execute  (const ast::stmt_ptr&  stmt)               -> void;
-        auto execute  (const ast::stmt_list& stmts, env_ptr env) -> void;
+        auto execute  (const ast::stmt_ptr&  stmt)               -> Completion;
+        auto execute  (const ast::stmt_list& stmts, env_ptr env) -> Completion;
+
+        // parses the body of a function from an imported file, which the parser skipped
+        auto expand(const ast::FunctionExpr& function) -> void;
+
+        [[nodiscard]] auto return_value() -> Object;
+
+        // for the duration of a call to `function`, which was checked to fit before it was made
+        [[nodiscard]] auto nest(const ast::FunctionExpr& function) -> Nesting;
+
+        // literals share one string object per content, which lives as long as the interpreter
+        [[nodiscard]] auto intern(std::string_view string) -> Object;
+
+        // the root of the shape tree every new instance starts from
+        [[nodiscard]] auto empty_shape() -> Shape*;
 
     private:
-        auto visit(const ast::BlockStmt&      stmt) -> void override;
-        auto visit(const ast::BreakStmt&      stmt) -> void override;
-        auto visit(const ast::ClassStmt&      stmt) -> void override;
-        auto visit(const ast::ContinueStmt&   stmt) -> void override;
-        auto visit(const ast::ExpressionStmt& stmt) -> void override;
-        auto visit(const ast::ForStmt&        stmt) -> void override;
-        auto visit(const ast::FunctionStmt&   stmt) -> void override;
-        auto visit(const ast::IfStmt&         stmt) -> void override;
-        auto visit(const ast::ImportStmt&     stmt) -> void override;
-        auto visit(const ast::LetStmt&        stmt) -> void override;
-        auto visit(const ast::ModuleStmt&     stmt) -> void override;
-        auto visit(const ast::PrintStmt&      stmt) -> void override;
-        auto visit(const ast::ReturnStmt&     stmt) -> void override;
-        auto visit(const ast::VariableStmt&   stmt) -> void override;
-        auto visit(const ast::WhileStmt&      stmt) -> void override;
-
-        auto visit(const ast::ArrayExpr&       expr) -> std::any override;
-        auto visit(const ast::AssignExpr&      expr) -> std::any override;
-        auto visit(const ast::BinaryExpr&      expr) -> std::any override;
-        auto visit(const ast::BooleanExpr&     expr) -> std::any override;
-        auto visit(const ast::CallExpr&        expr) -> std::any override;
-        auto visit(const ast::CommaExpr&       expr) -> std::any override;
-        auto visit(const ast::ConditionalExpr& expr) -> std::any override;
-        auto visit(const ast::FunctionExpr&    expr) -> std::any override;
-        auto visit(const ast::GetExpr&         expr) -> std::any override;
-        auto visit(const ast::GroupingExpr&    expr) -> std::any override;
-        auto visit(const ast::LogicalExpr&     expr) -> std::any override;
-        auto visit(const ast::NilExpr&         expr) -> std::any override;
-        auto visit(const ast::NumberExpr&      expr) -> std::any override;
-        auto visit(const ast::SetExpr&         expr) -> std::any override;
-        auto visit(const ast::StringExpr&      expr) -> std::any override;
-        auto visit(const ast::SubscriptExpr&   expr) -> std::any override;
-        auto visit(const ast::SuperExpr&       expr) -> std::any override;
-        auto visit(const ast::ThisExpr&        expr) -> std::any override;
-        auto visit(const ast::UnaryExpr&       expr) -> std::any override;
-        auto visit(const ast::VariableExpr&    expr) -> std::any override;
+        auto visit(const ast::BlockStmt&      stmt) -> Completion override;
+        auto visit(const ast::BreakStmt&      stmt) -> Completion override;
+        auto visit(const ast::ClassStmt&      stmt) -> Completion override;
+        auto visit(const ast::ContinueStmt&   stmt) -> Completion override;
+        auto visit(const ast::ExpressionStmt& stmt) -> Completion override;
+        auto visit(const ast::ForStmt&        stmt) -> Completion override;
+        auto visit(const ast::FunctionStmt&   stmt) -> Completion override;
+        auto visit(const ast::IfStmt&         stmt) -> Completion override;
+        auto visit(const ast::ImportStmt&     stmt) -> Completion override;
+        auto visit(const ast::LetStmt&        stmt) -> Completion override;
+        auto visit(const ast::ModuleStmt&     stmt) -> Completion override;
+        auto visit(const ast::PrintStmt&      stmt) -> Completion override;
+        auto visit(const ast::ReturnStmt&     stmt) -> Completion override;
+        auto visit(const ast::VariableStmt&   stmt) -> Completion override;
+        auto visit(const ast::WhileStmt&      stmt) -> Completion override;
+
+        auto visit(const ast::ArrayExpr&       expr) -> Object override;
+        auto visit(const ast::AssignExpr&      expr) -> Object override;
+        auto visit(const ast::BinaryExpr&      expr) -> Object override;
+        auto visit(const ast::BooleanExpr&     expr) -> Object override;
+        auto visit(const ast::CallExpr&        expr) -> Object override;
+        auto visit(const ast::CommaExpr&       expr) -> Object override;
+        auto visit(const ast::ConditionalExpr& expr) -> Object override;
+        auto visit(const ast::FunctionExpr&    expr) -> Object override;
+        auto visit(const ast::GetExpr&         expr) -> Object override;
+        auto visit(const ast::GroupingExpr&    expr) -> Object override;
+        auto visit(const ast::LogicalExpr&     expr) -> Object override;
+        auto visit(const ast::NilExpr&         expr) -> Object override;
+        auto visit(const ast::NumberExpr&      expr) -> Object override;
+        auto visit(const ast::SetExpr&         expr) -> Object override;
+        auto visit(const ast::StringExpr&      expr) -> Object override;
+        auto visit(const ast::SubscriptExpr&   expr) -> Object override;
+        auto visit(const ast::SuperExpr&       expr) -> Object override;
+        auto visit(const ast::ThisExpr&        expr) -> Object override;
+        auto visit(const ast::UnaryExpr&       expr) -> Object override;
+        auto visit(const ast::VariableExpr&    expr) -> Object override;
 
     private:
-        auto look_up_var(const Token& name, const ast::Expr& expr) -> const Object&;
+        auto define(std::size_t slot, bool global, Object value)               -> void;
+        auto look_up_var(const Span& name, const ast::Expr& expr)              -> const Object&;
+        auto assign_var(const Span& name, const ast::Expr& expr, Object value) -> const Object&;
+        auto global(const Span& name, std::size_t slot)                        -> Object&;
+        auto symbol(const Span& name, Symbols::id& cached)                     -> Symbols::id;
+
+        // what a property access site has learned. sets leave `symbol` alone, only gets go on
+        // to look for a method by it
+        struct PropertySite
+        {
+            PropertyCache cache  = {};
+            Symbols::id   symbol = Symbols::unresolved;
+        };
+
+        // the same for `super.method`, which always looks for a method
+        struct SuperSite
+        {
+            SuperCache  cache  = {};
+            Symbols::id symbol = Symbols::unresolved;
+        };
+
+        // the entry a node's `site` refers to in one of the tables below, added on first use
+        template<typename T>
+        static auto site(std::deque<T>& table, std::uint32_t index) -> T&
+        {
+            if (index >= table.size()) table.resize(index + 1);
+            return table[index];
+        }
 
     private:
-        env_ptr m_global;
-        env_ptr m_environment;
+        // how deep the statements and expressions being run may nest, calls included. every
+        // call adds how deep the body it runs gets and checks the sum first, which bounds the
+        // stack an interpreter uses without counting each node on the way down
+        static constexpr auto max_depth = std::size_t{8192};
+
+        Shape         m_shapes; // declared first, so instances still around go before it
+        Symbols       m_symbols;
+        global_list   m_globals;
+        env_ptr       m_environment;
+        Object        m_return_value;
+        string_table  m_strings = {};
+        ast::Program* m_program = nullptr;
+        std::size_t   m_depth   = 0;
+
+        // what is learned about the nodes that have a `site` as they run, kept out of the tree,
+        // by the numbers the resolver gave them in the one program being run. deques, as
+        // evaluating a node can add sites for others while a reference to its own is held
+        std::deque<PropertySite> m_property_sites = {};
+        std::deque<SuperSite>    m_super_sites    = {};
+        std::deque<Object>       m_string_sites   = {};
     };
 } // namespace loxe::tree_walker
 
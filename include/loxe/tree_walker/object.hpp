@@ -3,24 +3,157 @@
 #ifndef LOXE_TREE_WALKER_OBJECT_HPP
 #define LOXE_TREE_WALKER_OBJECT_HPP
 
+#include <bit>
 #include <memory>
 #include <string>
 #include <vector>
+#include <string_view>
+#include <cstdint>
+#include <utility>
 #include <variant>
+#include <type_traits>
+
+#include "loxe/common/utility.hpp"
+#include "loxe/parser/token.hpp"
 
 namespace loxe::tree_walker
 {
+    // base of every value that lives on the heap. the count is intrusive and not atomic:
+    // objects are only ever touched by the thread running the interpreter
+    class HeapObj
+    {
+    public:
+        enum class Kind : std::uint8_t
+        {
+            String,
+            Callable,
+            Instance,
+            Array,
+            Module,
+        };
+
+    public:
+        explicit HeapObj(Kind kind)
+            : m_kind(kind) {}
+
+        HeapObj(const HeapObj&)                    = delete;
+        auto operator=(const HeapObj&) -> HeapObj& = delete;
+        virtual ~HeapObj()                         = default;
+
+        [[nodiscard]] auto kind() const -> Kind { return m_kind; }
+
+    private:
+        template<typename> friend class Ref;
+        friend class Object;
+
+        auto retain() const -> void { ++m_refs; }
+        auto release() const -> void { if (--m_refs == 0) delete this; }
+
+    private:
+        mutable std::uint32_t m_refs = {};
+        Kind                  m_kind = {};
+    };
+
+    // owning pointer to a heap object, for the places that hold one outside an Object
+    template<typename T>
+    class Ref
+    {
+    public:
+        Ref() = default;
+        Ref(std::nullptr_t) {}
+
+        explicit Ref(T* ptr)
+            : m_ptr(ptr) { if (m_ptr) m_ptr->retain(); }
+
+        template<typename U> requires std::is_convertible_v<U*, T*>
+        Ref(Ref<U> other)
+            : m_ptr(other.release()) {}
+
+        Ref(const Ref& other)
+            : m_ptr(other.m_ptr) { if (m_ptr) m_ptr->retain(); }
+
+        Ref(Ref&& other) noexcept
+            : m_ptr(std::exchange(other.m_ptr, nullptr)) {}
+
+        ~Ref() { if (m_ptr) m_ptr->release(); }
+
+        auto operator=(Ref other) noexcept -> Ref&
+        {
+            std::swap(m_ptr, other.m_ptr);
+            return *this;
+        }
+
+        [[nodiscard]] auto get()        const -> T* { return m_ptr;  }
+        [[nodiscard]] auto operator->() const -> T* { return m_ptr;  }
+        [[nodiscard]] auto operator*()  const -> T& { return *m_ptr; }
+        [[nodiscard]] explicit operator bool() const { return m_ptr != nullptr; }
+
+        // hands the reference over to the caller, who is now responsible for releasing it
+        [[nodiscard]] auto release() -> T* { return std::exchange(m_ptr, nullptr); }
+
+    private:
+        T* m_ptr = nullptr;
+    };
+
+    template<typename T, typename... Args>
+    [[nodiscard]] inline auto make_ref(Args&&... args) -> Ref<T>
+    {
+        return Ref<T>(new T(std::forward<Args>(args)...));
+    }
+
     class Object
     {
     public:
-        class Array
+        // strings never change once made. interned ones are unique per content, so two of them
+        // are equal only when they are the same object.
+        //
+        // a concatenation shares its buffer with its left operand when that operand ends where
+        // the buffer does, and only appends the right one to it: building a string up in a loop
+        // then costs amortized constant time per character instead of a copy of the whole prefix
+        class String : public HeapObj
         {
         public:
+            static constexpr auto heap_kind = Kind::String;
+
+        public:
+            String(std::string value)
+                : HeapObj(heap_kind), m_buffer(std::move(value)), m_length(m_buffer.size()) {}
+
+            String(std::string value, std::size_t hash)
+                : HeapObj(heap_kind), m_buffer(std::move(value)), m_length(m_buffer.size()), m_hash(hash), m_hashed(true), m_interned(true) {}
+
+            [[nodiscard]] static auto concat(const String& lhs, const String& rhs) -> Ref<String>;
+
+            [[nodiscard]] auto value()    const -> std::string_view { return { root().m_buffer.data(), m_length }; }
+            [[nodiscard]] auto interned() const -> bool             { return m_interned; }
+
+            [[nodiscard]] auto hash()                      const -> std::size_t;
+            [[nodiscard]] auto equals(const String& other) const -> bool;
+
+        private:
+            String(Ref<const String> root, std::size_t length)
+                : HeapObj(heap_kind), m_root(std::move(root)), m_length(length) {}
+
+            [[nodiscard]] auto root() const -> const String& { return m_root ? *m_root : *this; }
+
+        private:
+            mutable std::string m_buffer   = {}; // empty unless this string owns the buffer
+            Ref<const String>   m_root     = {}; // the string owning the buffer, if it is not this one
+            const std::size_t   m_length   = {};
+            mutable std::size_t m_hash     = {};
+            mutable bool        m_hashed   = false;
+            const bool          m_interned = false;
+        };
+
+        class Array : public HeapObj
+        {
+        public:
+            static constexpr auto heap_kind = Kind::Array;
             using container = std::vector<Object>;
 
         public:
             Array(container values = {})
-                : m_values(std::move(values)) {}
+                : HeapObj(heap_kind), m_values(std::move(values)) {}
 
             auto length() const                        -> std::size_t;
             auto to_string() const                     -> std::string;
@@ -31,71 +164,144 @@ namespace loxe::tree_walker
             container m_values;
         };
 
-        class Module
+        class Module : public HeapObj
         {
         public:
-            using env_ptr = std::shared_ptr<class Environment>;
+            static constexpr auto heap_kind = Kind::Module;
+            using env_ptr    = std::shared_ptr<class Environment>;
+            using member_map = utility::string_map<std::size_t>;
 
         public:
-            Module(std::string name, env_ptr environment)
-                : m_name(std::move(name)), m_environment(std::move(environment)) {}
+            Module(std::string name, env_ptr environment, member_map members)
+                : HeapObj(heap_kind), m_name(std::move(name)), m_environment(std::move(environment)), m_members(std::move(members)) {}
 
             [[nodiscard]] auto to_string() const -> std::string;
-            [[nodiscard]] auto env() -> env_ptr&;
+
+            auto access(const Span& name) const        -> const Object&;
+            auto assign(const Span& name, Object value) -> const Object&;
+
+        private:
+            auto slot(const Span& name) const -> std::size_t;
 
         private:
             std::string m_name;
             env_ptr     m_environment;
+            member_map  m_members;
         };
 
     public:
-        using nil        = std::monostate;
-        using boolean    = bool;
-        using number     = double;
-        using string     = std::string;
-        using callable   = std::shared_ptr<class Callable>;
-        using instance   = std::shared_ptr<class InstanceObj>;
-        using array      = std::shared_ptr<Array>;
-        using module_    = std::shared_ptr<Module>;
-        using value_type = std::variant<nil, boolean, number, string, callable, instance, array, module_>;
+        using nil      = std::monostate;
+        using boolean  = bool;
+        using number   = double;
+        using string   = String;
+        using callable = class Callable;
+        using instance = class InstanceObj;
+        using array    = Array;
+        using module_  = Module;
 
     public:
-        Object()               : m_value(nil())            {}
-        Object(boolean  value) : m_value(value)            {}
-        Object(number   value) : m_value(value)            {}
-        Object(string   value) : m_value(std::move(value)) {}
-        Object(callable value) : m_value(std::move(value)) {}
-        Object(instance value) : m_value(std::move(value)) {}
-        Object(array    value) : m_value(std::move(value)) {}
-        Object(module_  value) : m_value(std::move(value)) {}
+        Object()              : m_bits(nil_bits)                                    {}
+        Object(boolean value) : m_bits(value ? true_bits : false_bits)              {}
+        Object(number  value) : m_bits(canon(std::bit_cast<std::uint64_t>(value)))  {}
+
+        template<typename T> requires std::is_base_of_v<HeapObj, T>
+        Object(Ref<T> value)
+            : m_bits(heap_bits | reinterpret_cast<std::uintptr_t>(static_cast<const HeapObj*>(value.release()))) {}
 
+        // a raw pointer would otherwise quietly convert to a boolean
         template<typename T>
-        [[nodiscard]] constexpr auto is() const -> bool
+        Object(T*) = delete;
+
+        Object(const Object& other)
+            : m_bits(other.m_bits) { if (is_heap()) heap()->retain(); }
+
+        Object(Object&& other) noexcept
+            : m_bits(std::exchange(other.m_bits, nil_bits)) {}
+
+        ~Object() { if (is_heap()) heap()->release(); }
+
+        auto operator=(const Object& other) -> Object&
         {
-            return std::holds_alternative<T>(m_value);
+            if (other.is_heap()) other.heap()->retain();
+            if (is_heap())       heap()->release();
+            m_bits = other.m_bits;
+            return *this;
+        }
+
+        auto operator=(Object&& other) noexcept -> Object&
+        {
+            if (this != &other)
+            {
+                if (is_heap()) heap()->release();
+                m_bits = std::exchange(other.m_bits, nil_bits);
+            }
+            return *this;
         }
 
         template<typename T>
-        [[nodiscard]] constexpr auto as() -> T&
+        [[nodiscard]] auto is() const -> bool
         {
-            return std::get<T>(m_value);
+            if constexpr (std::is_same_v<T, nil>)          return m_bits == nil_bits;
+            else if constexpr (std::is_same_v<T, boolean>) return (m_bits | 1) == true_bits;
+            else if constexpr (std::is_same_v<T, number>)  return (m_bits & qnan) != qnan;
+            else                                           return is_heap() && heap()->kind() == T::heap_kind;
         }
 
+        // heap values come back as borrowed pointers, valid while this object holds them
         template<typename T>
-        [[nodiscard]] constexpr auto as() const -> const T&
+        [[nodiscard]] auto as() const
         {
-            return std::get<T>(m_value);
+            if constexpr (std::is_same_v<T, boolean>)     return m_bits == true_bits;
+            else if constexpr (std::is_same_v<T, number>) return std::bit_cast<number>(m_bits);
+            else                                          return static_cast<T*>(const_cast<HeapObj*>(heap()));
         }
 
-        [[nodiscard]] constexpr auto operator==(const Object& other) const -> bool = default;
-        [[nodiscard]] constexpr auto operator!=(const Object& other) const -> bool = default;
+        [[nodiscard]] auto operator==(const Object& other) const -> bool
+        {
+            if (is<number>() && other.is<number>()) return as<number>() == other.as<number>();
+            if (is<string>() && other.is<string>()) return as<string>()->equals(*other.as<string>());
+            return m_bits == other.m_bits;
+        }
 
         [[nodiscard]] auto is_truthy() const -> bool;
         [[nodiscard]] auto stringify() const -> std::string;
 
     private:
-        value_type m_value;
+        // numbers are stored as they are. everything else hides in the payload of a quiet nan
+        // that arithmetic never produces: nil and the booleans in the low bits, heap objects
+        // with the sign bit set and their address in the low 48 bits, which is all user space
+        // addresses use on the 64-bit targets we support
+        static constexpr auto qnan       = std::uint64_t{0x7ffc000000000000};
+        static constexpr auto sign_bit   = std::uint64_t{0x8000000000000000};
+        static constexpr auto heap_bits  = sign_bit | qnan;
+        static constexpr auto nil_bits   = qnan | 1;
+        static constexpr auto false_bits = qnan | 2;
+        static constexpr auto true_bits  = qnan | 3;
+
+        static_assert(sizeof(void*) == sizeof(std::uint64_t));
+
+        [[nodiscard]] static auto canon(std::uint64_t bits) -> std::uint64_t
+        {
+            // a nan with an unlucky payload would read back as a tagged value, so it keeps only its sign
+            if ((bits & qnan) != qnan) return bits;
+            return (bits & sign_bit) | std::uint64_t{0x7ff8000000000000};
+        }
+
+        [[nodiscard]] auto is_heap() const -> bool
+        {
+            return (m_bits & heap_bits) == heap_bits;
+        }
+
+        [[nodiscard]] auto heap() const -> const HeapObj*
+        {
+            return reinterpret_cast<const HeapObj*>(m_bits & ~heap_bits);
+        }
+
+    private:
+        std::uint64_t m_bits;
     };
+
+    static_assert(sizeof(Object) == sizeof(std::uint64_t));
 } // namespace loxe::tree_walker
 
 #endif // !LOXE_TREE_WALKER_OBJECT_HPP
@@ -0,0 +1,80 @@
+#pragma once
+
+#ifndef LOXE_TREE_WALKER_SHAPE_HPP
+#define LOXE_TREE_WALKER_SHAPE_HPP
+
+#include <array>
+#include <limits>
+#include <memory>
+#include <cstdint>
+#include <string_view>
+
+#include "loxe/common/utility.hpp"
+
+namespace loxe::tree_walker
+{
+    // the field layout shared by every instance that was given the same fields in the same
+    // order. shapes form a tree rooted at the empty shape the interpreter owns: giving an
+    // instance a new field moves it to a child, and each child is only created once. shapes
+    // live as long as the interpreter, so a pointer to one is a stable key for a cache
+    class Shape
+    {
+    public:
+        static constexpr auto absent = std::numeric_limits<std::uint32_t>::max();
+
+    public:
+        Shape() = default;
+
+        Shape(const Shape&)                    = delete;
+        auto operator=(const Shape&) -> Shape& = delete;
+
+        [[nodiscard]] auto size() const -> std::uint32_t;
+
+        // the field's index in an instance's slots, or `absent`
+        [[nodiscard]] auto find(std::string_view name) const -> std::uint32_t;
+
+        // the shape of an instance that gets `name` as its next field
+        [[nodiscard]] auto with(std::string_view name) -> Shape*;
+
+    private:
+        utility::string_map<std::uint32_t>          m_slots       = {};
+        utility::string_map<std::unique_ptr<Shape>> m_transitions = {};
+    };
+
+    // a polymorphic inline cache for a property access site: the shapes the site has seen,
+    // and where the property was in each. a store that adds a field also records the shape
+    // the instance moves to. once full, the oldest entry makes room for the next
+    class PropertyCache
+    {
+    public:
+        struct Entry
+        {
+            const Shape*  shape  = nullptr;
+            Shape*        target = nullptr;
+            std::uint32_t slot   = Shape::absent;
+        };
+
+    public:
+        [[nodiscard]] auto find(const Shape* shape) const -> const Entry*
+        {
+            for (const auto& entry : m_entries)
+                if (entry.shape == shape) return &entry;
+            return nullptr;
+        }
+
+        auto insert(Entry entry) -> const Entry&
+        {
+            auto& slot = m_entries[m_next];
+            m_next     = (m_next + 1) % ways;
+            return (slot = entry);
+        }
+
+    private:
+        static constexpr auto ways = std::size_t{4};
+
+        std::array<Entry, ways> m_entries = {};
+        std::size_t             m_next    = 0;
+    };
+} // namespace loxe::tree_walker
+
+#endif // !LOXE_TREE_WALKER_SHAPE_HPP
@@ -0,0 +1,44 @@
+#pragma once
+
+#ifndef LOXE_TREE_WALKER_SYMBOL_HPP
+#define LOXE_TREE_WALKER_SYMBOL_HPP
+
+#include <limits>
+#include <cstdint>
+#include <string_view>
+
+#include "loxe/common/utility.hpp"
+
+namespace loxe::tree_walker
+{
+    class FunctionObj;
+
+    // interns method names to dense integer ids, which class method tables are keyed by
+    class Symbols
+    {
+    public:
+        using id = std::uint32_t;
+        static constexpr auto unresolved = std::numeric_limits<id>::max();
+
+    public:
+        [[nodiscard]] auto intern(std::string_view name) -> id
+        {
+            if (auto it = m_ids.find(name); it != m_ids.end()) return it->second;
+            return m_ids.emplace(name, static_cast<id>(m_ids.size())).first->second;
+        }
+
+    private:
+        utility::string_map<id> m_ids = {};
+    };
+
+    // what a `super.method` site last resolved to: the superclass it looked in, by an id that
+    // is never reused, and the method found there. the method is only used after the class
+    // that is now in scope turns out to have the same id, as that class keeps it alive
+    struct SuperCache
+    {
+        std::uint64_t class_id = 0;
+        FunctionObj*  method   = nullptr;
+    };
+} // namespace loxe::tree_walker
+
+#endif // !LOXE_TREE_WALKER_SYMBOL_HPP
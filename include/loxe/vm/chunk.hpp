@@ -0,0 +1,101 @@
+#pragma once
+
+#ifndef LOXE_VM_CHUNK_HPP
+#define LOXE_VM_CHUNK_HPP
+
+#include <vector>
+#include <cstdint>
+#include <utility>
+
+#include "loxe/parser/token.hpp"
+
+#include "value.hpp"
+
+namespace loxe::vm
+{
+    enum class OpCode : std::uint8_t
+    {
+        // constants and literals
+        Constant,
+        Nil,
+        True,
+        False,
+
+        // stack and variables
+        Pop,
+        GetLocal,
+        SetLocal,
+        GetUpvalue,
+        SetUpvalue,
+        DefineGlobal,
+        GetGlobal,
+        SetGlobal,
+        CloseUpvalue,
+
+        // properties and subscripts
+        GetProperty,
+        SetProperty,
+        GetSuper,
+        GetIndex,
+        SetIndex,
+
+        // operators
+        Equal,
+        NotEqual,
+        Greater,
+        GreaterEqual,
+        Less,
+        LessEqual,
+        Add,
+        Subtract,
+        Multiply,
+        Divide,
+        Not,
+        Negate,
+        Identity,
+
+        // control flow
+        Jump,
+        JumpIfFalse,
+        Loop,
+        Call,
+        Invoke,
+        SuperInvoke,
+        Closure,
+        Return,
+
+        // declarations
+        Array,
+        SizedArray,
+        Class,
+        Inherit,
+        Method,
+        Module,
+        Print,
+
+        // doubles the width of the next instruction's slot, constant, global or count operand
+        Wide,
+    };
+
+    class Chunk
+    {
+    public:
+        auto write(std::uint8_t byte, const Span& token) -> void;
+        auto write(OpCode op, const Span& token)         -> void;
+        auto add_constant(Value value)                   -> std::size_t;
+
+        [[nodiscard]] auto token_at(std::size_t offset) const -> const Span&;
+
+    public:
+        std::vector<std::uint8_t> code      = {};
+        std::vector<Value>        constants = {};
+
+    private:
+        using token_span = std::pair<std::size_t, Span>;
+
+        std::vector<token_span> m_tokens = {};
+        const Span*             m_last   = nullptr;
+    };
+} // namespace loxe::vm
+
+#endif // !LOXE_VM_CHUNK_HPP
@@ -0,0 +1,201 @@
+#pragma once
+
+#ifndef LOXE_VM_COMPILER_HPP
+#define LOXE_VM_COMPILER_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+
+#include "loxe/common/utility.hpp"
+#include "loxe/parser/ast.hpp"
+
+#include "chunk.hpp"
+#include "error.hpp"
+#include "heap.hpp"
+#include "object.hpp"
+
+namespace loxe::vm
+{
+    class Compiler : public ast::Stmt::const_visitor<void>, public ast::Expr::const_visitor<void>
+    {
+    public:
+        using names = std::vector<StringObj*>;
+
+    public:
+        // skipped function bodies are parsed into `program` as they are compiled
+        Compiler(Heap& heap, ast::Program& program)
+            : m_heap(heap), m_program(program) {}
+
+        [[nodiscard]] auto compile_ast(const ast::stmt_list& ast) -> FunctionObj*;
+        [[nodiscard]] auto globals() const -> const names&;
+
+    private:
+        auto visit(const ast::BlockStmt&      stmt) -> void override;
+        auto visit(const ast::BreakStmt&      stmt) -> void override;
+        auto visit(const ast::ClassStmt&      stmt) -> void override;
+        auto visit(const ast::ContinueStmt&   stmt) -> void override;
+        auto visit(const ast::ExpressionStmt& stmt) -> void override;
+        auto visit(const ast::ForStmt&        stmt) -> void override;
+        auto visit(const ast::FunctionStmt&   stmt) -> void override;
+        auto visit(const ast::IfStmt&         stmt) -> void override;
+        auto visit(const ast::ImportStmt&     stmt) -> void override;
+        auto visit(const ast::LetStmt&        stmt) -> void override;
+        auto visit(const ast::ModuleStmt&     stmt) -> void override;
+        auto visit(const ast::PrintStmt&      stmt) -> void override;
+        auto visit(const ast::ReturnStmt&     stmt) -> void override;
+        auto visit(const ast::VariableStmt&   stmt) -> void override;
+        auto visit(const ast::WhileStmt&      stmt) -> void override;
+
+        auto visit(const ast::ArrayExpr&       expr) -> void override;
+        auto visit(const ast::AssignExpr&      expr) -> void override;
+        auto visit(const ast::BinaryExpr&      expr) -> void override;
+        auto visit(const ast::BooleanExpr&     expr) -> void override;
+        auto visit(const ast::CallExpr&        expr) -> void override;
+        auto visit(const ast::CommaExpr&       expr) -> void override;
+        auto visit(const ast::ConditionalExpr& expr) -> void override;
+        auto visit(const ast::FunctionExpr&    expr) -> void override;
+        auto visit(const ast::GetExpr&         expr) -> void override;
+        auto visit(const ast::GroupingExpr&    expr) -> void override;
+        auto visit(const ast::LogicalExpr&     expr) -> void override;
+        auto visit(const ast::NilExpr&         expr) -> void override;
+        auto visit(const ast::NumberExpr&      expr) -> void override;
+        auto visit(const ast::SetExpr&         expr) -> void override;
+        auto visit(const ast::StringExpr&      expr) -> void override;
+        auto visit(const ast::SubscriptExpr&   expr) -> void override;
+        auto visit(const ast::SuperExpr&       expr) -> void override;
+        auto visit(const ast::ThisExpr&        expr) -> void override;
+        auto visit(const ast::UnaryExpr&       expr) -> void override;
+        auto visit(const ast::VariableExpr&    expr) -> void override;
+
+    private:
+        enum class FunType
+        {
+            Function,
+            Initializer,
+            Method,
+            Script,
+        };
+
+        struct Local
+        {
+            std::string_view name     = {};
+            int              depth    = -1;
+            bool             captured = false;
+        };
+
+        struct Upvalue
+        {
+            std::uint16_t index    = 0;
+            bool          is_local = false;
+        };
+
+        struct Loop
+        {
+            bool                     is_for    = false;
+            std::size_t              start     = 0;
+            std::size_t              locals    = 0;
+            std::vector<std::size_t> breaks    = {};
+            std::vector<std::size_t> continues = {};
+        };
+
+        struct FunctionState
+        {
+            FunctionState*       enclosing   = nullptr;
+            FunctionObj*         function    = nullptr;
+            FunType              type        = FunType::Script;
+            int                  scope_depth = 0;
+            std::vector<Local>   locals      = {};
+            std::vector<Upvalue> upvalues    = {};
+            std::vector<Loop>    loops       = {};
+
+            std::unordered_map<Obj*, std::uint32_t>          object_constants = {};
+            std::unordered_map<std::uint64_t, std::uint32_t> number_constants = {};
+        };
+
+        // a module's members are locals of the function it is declared in, set aside before its
+        // body runs, so each time the declaration runs the module closes over a fresh set of them
+        struct ModuleState
+        {
+            FunctionState*                     owner   = nullptr;
+            int                                depth   = 0;
+            utility::string_map<std::uint16_t> members = {};
+        };
+
+        // where a declaration stores its value: a global, the local it just pushed, or the
+        // local of the module member it names
+        struct Variable
+        {
+            enum class Kind { Global, Local, Member };
+
+            Kind          kind  = Kind::Local;
+            std::uint32_t index = 0;
+        };
+
+    private:
+        auto compile(const ast::stmt_list& stmts) -> void;
+        auto compile(const ast::stmt_ptr&  stmt)  -> void;
+        auto compile(const ast::expr_ptr&  expr)  -> void;
+
+        auto function(const ast::FunctionExpr& expr, FunType type) -> void;
+
+        auto begin_scope() -> void;
+        auto end_scope()   -> void;
+        auto discard_locals(std::size_t count) -> void;
+
+        auto declare(const Span& name)                           -> Variable;
+        auto define(Variable variable)                           -> void;
+        auto add_local(std::string_view name, const Span& token) -> void;
+        auto mark_initialized()                                  -> void;
+
+        auto get_variable(std::string_view name, const Span& token) -> void;
+        auto set_variable(std::string_view name, const Span& token) -> void;
+
+        auto resolve_local(FunctionState& state, std::string_view name)   -> std::optional<std::uint16_t>;
+        auto resolve_upvalue(FunctionState& state, std::string_view name) -> std::optional<std::uint16_t>;
+        auto add_upvalue(FunctionState& state, std::uint16_t index, bool is_local) -> std::uint16_t;
+        auto global(std::string_view name)                                         -> std::uint32_t;
+
+        // slots name a local or upvalue and take one byte, indices pick a constant or global, or
+        // count an array's values, and take two. either is written after `Wide` if it won't fit
+        auto emit(std::uint8_t byte)                      -> void;
+        auto emit(OpCode op)                              -> void;
+        auto emit(OpCode op, std::uint8_t operand)        -> void;
+        auto emit_slot(OpCode op, std::uint16_t slot)     -> void;
+        auto emit_index(OpCode op, std::uint32_t index)   -> void;
+        auto emit_short(std::uint16_t value)              -> void;
+        auto emit_long(std::uint32_t value)               -> void;
+        auto emit_jump(OpCode op)                         -> std::size_t;
+        auto emit_loop(std::size_t start)                 -> void;
+        auto emit_return()                                -> void;
+        auto patch_jump(std::size_t offset)               -> void;
+
+        [[nodiscard]] static auto stack_size(const FunctionObj& function) -> std::size_t;
+
+        auto constant(Value value)             -> std::uint32_t;
+        auto identifier(std::string_view name) -> std::uint32_t;
+
+        [[nodiscard]] auto chunk() -> Chunk&;
+        [[nodiscard]] auto error(const Span& token, std::string message) const -> CompileError;
+
+    private:
+        // the resolver turns deeper expressions away already, this only keeps the
+        // compiler from recursing past them on a tree that didn't go through it
+        static constexpr auto max_nesting = std::size_t{4096};
+
+        Heap&                    m_heap;
+        ast::Program&            m_program;
+        FunctionState*           m_function = nullptr;
+        const Span*              m_token    = nullptr;
+        std::size_t              m_nesting  = 0;
+        std::vector<ModuleState> m_modules  = {};
+        names                    m_globals  = {};
+
+        utility::string_map<std::uint32_t> m_global_ids = {};
+    };
+} // namespace loxe::vm
+
+#endif // !LOXE_VM_COMPILER_HPP
@@ -0,0 +1,45 @@
+#pragma once
+
+#ifndef LOXE_VM_ERROR_HPP
+#define LOXE_VM_ERROR_HPP
+
+#include "loxe/common/utility.hpp"
+#include "loxe/common/except.hpp"
+#include "loxe/parser/source_map.hpp"
+#include "loxe/parser/token.hpp"
+
+namespace loxe::vm
+{
+    // both errors only look up the token's line and column once they are reported
+    struct CompileError : public Exception
+    {
+        CompileError(const Span& token, std::string message)
+            : Exception(std::move(message)), token(token) {}
+
+        [[nodiscard]] auto report(const SourceMap& sources) const -> std::string
+        {
+            static constexpr auto format = "[{}, {}] CompileError at token '{}': {}.";
+            const auto [line, column] = sources.position(token.offset);
+            return utility::as_string(format, line, column, token.lexeme, m_message);
+        }
+
+        Span token;
+    };
+
+    struct RuntimeError : public Exception
+    {
+        RuntimeError(const Span& token, std::string message)
+            : Exception(std::move(message)), token(token) {}
+
+        [[nodiscard]] auto report(const SourceMap& sources) const -> std::string
+        {
+            static constexpr auto format = "[{}, {}] RuntimeError at token '{}': {}.";
+            const auto [line, column] = sources.position(token.offset);
+            return utility::as_string(format, line, column, token.lexeme, m_message);
+        }
+
+        Span token;
+    };
+} // namespace loxe::vm
+
+#endif // !LOXE_VM_ERROR_HPP
@@ -0,0 +1,65 @@
+#pragma once
+
+#ifndef LOXE_VM_HEAP_HPP
+#define LOXE_VM_HEAP_HPP
+
+#include <string>
+#include <vector>
+#include <string_view>
+#include <unordered_map>
+
+#include "object.hpp"
+#include "value.hpp"
+
+namespace loxe::vm
+{
+    class Heap
+    {
+    public:
+        Heap() = default;
+        ~Heap();
+
+        Heap(const Heap&)                    = delete;
+        auto operator=(const Heap&) -> Heap& = delete;
+
+        template<typename T, typename... Args>
+        [[nodiscard]] auto make(Args&&... args) -> T*
+        {
+            auto object = new T(std::forward<Args>(args)...);
+            object->next = m_objects;
+            object->size = sizeof(T) + object->payload();
+            m_objects    = object;
+            m_bytes     += object->size;
+            return object;
+        }
+
+        [[nodiscard]] auto intern(std::string_view string) -> StringObj*;
+        [[nodiscard]] auto intern(std::string&&    string) -> StringObj*;
+
+        // `lhs + rhs`, which isn't interned, appended in place to the buffer of `lhs` when it can
+        [[nodiscard]] auto concat(StringObj* lhs, StringObj* rhs) -> StringObj*;
+
+        auto mark(Value value) -> void;
+        auto mark(Obj* object) -> void;
+
+        // once the bytes allocated since the last collection pass the threshold. counting
+        // objects instead would let a few large dead strings pile up without bound
+        [[nodiscard]] auto should_collect() const -> bool;
+        auto collect() -> void;
+
+    private:
+        auto trace()  -> void;
+        auto sweep()  -> void;
+
+    private:
+        static constexpr auto initial_threshold = std::size_t{1024 * 1024};
+
+        Obj*                                              m_objects   = nullptr;
+        std::size_t                                       m_bytes     = 0;
+        std::size_t                                       m_threshold = initial_threshold;
+        std::vector<Obj*>                                 m_gray      = {};
+        std::unordered_map<std::string_view, StringObj*> m_strings   = {};
+    };
+} // namespace loxe::vm
+
+#endif // !LOXE_VM_HEAP_HPP
@@ -0,0 +1,71 @@
+#pragma once
+
+#ifndef LOXE_VM_MACHINE_HPP
+#define LOXE_VM_MACHINE_HPP
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+#include "loxe/parser/ast.hpp"
+
+#include "error.hpp"
+#include "heap.hpp"
+#include "object.hpp"
+#include "value.hpp"
+
+namespace loxe::vm
+{
+    class Machine
+    {
+    public:
+        Machine();
+
+        auto interpret(ast::Program& program) -> void;
+
+    private:
+        struct CallFrame
+        {
+            ClosureObj*         closure = nullptr;
+            const std::uint8_t* ip      = nullptr;
+            Value*              slots   = nullptr;
+        };
+
+    private:
+        auto run() -> void;
+
+        auto push(Value value) -> void;
+        auto pop()             -> Value;
+        auto peek(std::size_t distance) const -> Value;
+
+        auto call_value(Value callee, std::size_t argc)                      -> void;
+        auto call(ClosureObj* closure, std::size_t argc)                     -> void;
+        auto invoke(StringObj* name, std::size_t argc)                       -> void;
+        auto invoke_from_class(ClassObj* cls, StringObj* name, std::size_t argc) -> void;
+        auto get_property(Value receiver, StringObj* name, std::size_t back) -> Value;
+        auto bind_method(ClassObj* cls, Value receiver, StringObj* name)     -> Value;
+
+        auto capture_upvalue(Value* local) -> UpvalueObj*;
+        auto close_upvalues(Value* last)   -> void;
+
+        auto collect_garbage() -> void;
+        auto reset()           -> void;
+
+        [[nodiscard]] auto error(std::string message, std::size_t back = 1) const -> RuntimeError;
+
+    private:
+        static constexpr auto frames_max = std::size_t{1024};
+        static constexpr auto stack_max  = frames_max * 256;
+
+        Heap                     m_heap;
+        std::unique_ptr<Value[]> m_stack;
+        Value*                   m_top           = nullptr;
+        std::vector<CallFrame>   m_frames        = {};
+        std::vector<Value>       m_globals       = {};
+        std::vector<StringObj*>  m_global_names  = {};
+        UpvalueObj*              m_open_upvalues = nullptr;
+        StringObj*               m_init_string   = nullptr;
+    };
+} // namespace loxe::vm
+
+#endif // !LOXE_VM_MACHINE_HPP
@@ -0,0 +1,212 @@
+#pragma once
+
+#ifndef LOXE_VM_OBJECT_HPP
+#define LOXE_VM_OBJECT_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+
+#include "chunk.hpp"
+#include "value.hpp"
+
+namespace loxe::vm
+{
+    class Heap;
+
+    struct Obj
+    {
+    public:
+        enum class Type : std::uint8_t
+        {
+            Array,
+            BoundMethod,
+            Class,
+            Closure,
+            Function,
+            Instance,
+            Module,
+            String,
+            Upvalue,
+        };
+
+    public:
+        Obj(Type type)
+            : type(type) {}
+
+        virtual ~Obj() = default;
+        virtual auto trace(Heap& heap)  -> void        = 0;
+        virtual auto to_string()  const -> std::string = 0;
+
+        // bytes held outside of the object itself, which the heap counts towards collecting
+        [[nodiscard]] virtual auto payload() const -> std::size_t { return 0; }
+
+        const Type  type;
+        bool        marked = false;
+        Obj*        next   = nullptr;
+        std::size_t size   = 0; // what the heap counted for the object, payload included
+    };
+
+    template<Obj::Type Tag>
+    struct TaggedObj : public Obj
+    {
+        static constexpr auto tag = Tag;
+
+        TaggedObj()
+            : Obj(Tag) {}
+
+        [[nodiscard]] static auto is(const Obj* object) -> bool
+        {
+            return object->type == Tag;
+        }
+    };
+
+    // interned strings are unique per content, so two of them are equal only when they are
+    // the same object. the results of `+` are not interned: a concatenation shares its buffer
+    // with its left operand when that operand ends where the buffer does, and only appends
+    // the right one to it, so building a string up in a loop costs amortized constant time
+    // per character instead of a copy and a hash of the whole prefix
+    struct StringObj final : public TaggedObj<Obj::Type::String>
+    {
+        StringObj(std::string value)
+            : buffer(std::move(value)), length(buffer.size()) {}
+
+        StringObj(std::string value, std::size_t hash)
+            : buffer(std::move(value)), length(buffer.size()), hash(hash), interned(true) {}
+
+        StringObj(StringObj* root, std::size_t length)
+            : root(root), length(length) {}
+
+        auto trace(Heap& heap)  -> void        override;
+        auto to_string()  const -> std::string override;
+        auto payload()    const -> std::size_t override;
+
+        [[nodiscard]] auto value() const -> std::string_view
+        {
+            return { (root ? root->buffer : buffer).data(), length };
+        }
+
+        [[nodiscard]] auto equals(const StringObj& other) const -> bool;
+
+        std::string       buffer   = {};      // empty unless this string owns the buffer
+        StringObj*        root     = nullptr; // the string owning the buffer, if it is not this one
+        const std::size_t length   = 0;
+        const std::size_t hash     = 0;       // only known for interned strings
+        const bool        interned = false;
+    };
+
+    struct FunctionObj final : public TaggedObj<Obj::Type::Function>
+    {
+        FunctionObj(StringObj* name)
+            : name(name) {}
+
+        auto trace(Heap& heap)  -> void        override;
+        auto to_string()  const -> std::string override;
+
+        std::size_t arity         = 0;
+        std::size_t upvalue_count = 0;
+        std::size_t max_stack     = 0; // most values a call keeps on the stack, its slot included
+        Chunk       chunk         = {};
+        StringObj*  name          = nullptr;
+    };
+
+    struct UpvalueObj final : public TaggedObj<Obj::Type::Upvalue>
+    {
+        UpvalueObj(Value* slot)
+            : location(slot) {}
+
+        auto trace(Heap& heap)  -> void        override;
+        auto to_string()  const -> std::string override;
+
+        Value*      location  = nullptr;
+        Value       closed    = {};
+        UpvalueObj* next_open = nullptr;
+    };
+
+    struct ClosureObj final : public TaggedObj<Obj::Type::Closure>
+    {
+        ClosureObj(FunctionObj* function)
+            : function(function), upvalues(function->upvalue_count, nullptr) {}
+
+        auto trace(Heap& heap)  -> void        override;
+        auto to_string()  const -> std::string override;
+
+        FunctionObj*             function;
+        std::vector<UpvalueObj*> upvalues;
+    };
+
+    struct ClassObj final : public TaggedObj<Obj::Type::Class>
+    {
+        using methods_type = std::unordered_map<StringObj*, ClosureObj*>;
+
+        ClassObj(StringObj* name)
+            : name(name) {}
+
+        auto trace(Heap& heap)  -> void        override;
+        auto to_string()  const -> std::string override;
+
+        StringObj*   name;
+        methods_type methods = {};
+        ClosureObj*  init    = nullptr;
+    };
+
+    struct InstanceObj final : public TaggedObj<Obj::Type::Instance>
+    {
+        using field_type = std::unordered_map<StringObj*, Value>;
+
+        InstanceObj(ClassObj* class_obj)
+            : class_obj(class_obj) {}
+
+        auto trace(Heap& heap)  -> void        override;
+        auto to_string()  const -> std::string override;
+
+        ClassObj*  class_obj;
+        field_type fields = {};
+    };
+
+    struct BoundMethodObj final : public TaggedObj<Obj::Type::BoundMethod>
+    {
+        BoundMethodObj(Value receiver, ClosureObj* method)
+            : receiver(receiver), method(method) {}
+
+        auto trace(Heap& heap)  -> void        override;
+        auto to_string()  const -> std::string override;
+
+        Value       receiver;
+        ClosureObj* method;
+    };
+
+    struct ArrayObj final : public TaggedObj<Obj::Type::Array>
+    {
+        using container = std::vector<Value>;
+
+        ArrayObj(container values)
+            : values(std::move(values)) {}
+
+        auto trace(Heap& heap)  -> void        override;
+        auto to_string()  const -> std::string override;
+        auto payload()    const -> std::size_t override;
+
+        container values;
+    };
+
+    // each member is captured from the local the module's body defined it in, so functions in
+    // the module and the module itself share it
+    struct ModuleObj final : public TaggedObj<Obj::Type::Module>
+    {
+        using member_type = std::unordered_map<StringObj*, UpvalueObj*>;
+
+        ModuleObj(StringObj* name)
+            : name(name) {}
+
+        auto trace(Heap& heap)  -> void        override;
+        auto to_string()  const -> std::string override;
+
+        StringObj*  name;
+        member_type members = {};
+    };
+} // namespace loxe::vm
+
+#endif // !LOXE_VM_OBJECT_HPP
@@ -0,0 +1,93 @@
+#pragma once
+
+#ifndef LOXE_VM_VALUE_HPP
+#define LOXE_VM_VALUE_HPP
+
+#include <string>
+#include <variant>
+#include <cstdint>
+#include <type_traits>
+
+namespace loxe::vm
+{
+    struct Obj;
+
+    class Value
+    {
+    public:
+        enum class Type : std::uint8_t
+        {
+            Nil,
+            Boolean,
+            Number,
+            Object,
+            Undefined,
+        };
+
+        using nil     = std::monostate;
+        using boolean = bool;
+        using number  = double;
+
+    public:
+        Value()               : m_type(Type::Nil),     m_as{ .number  = 0     } {}
+        Value(boolean  value) : m_type(Type::Boolean), m_as{ .boolean = value } {}
+        Value(number   value) : m_type(Type::Number),  m_as{ .number  = value } {}
+        Value(Obj*     value) : m_type(Type::Object),  m_as{ .object  = value } {}
+
+        [[nodiscard]] static auto undefined() -> Value
+        {
+            auto value   = Value();
+            value.m_type = Type::Undefined;
+            return value;
+        }
+
+        [[nodiscard]] auto type() const -> Type
+        {
+            return m_type;
+        }
+
+        template<typename T>
+        [[nodiscard]] auto is() const -> bool
+        {
+            if      constexpr (std::is_same_v<T, nil>)     return m_type == Type::Nil;
+            else if constexpr (std::is_same_v<T, boolean>) return m_type == Type::Boolean;
+            else if constexpr (std::is_same_v<T, number>)  return m_type == Type::Number;
+            else if constexpr (std::is_same_v<T, Obj>)     return m_type == Type::Object;
+            else return m_type == Type::Object && T::is(m_as.object);
+        }
+
+        template<typename T>
+        [[nodiscard]] auto as() const
+        {
+            if      constexpr (std::is_same_v<T, boolean>) return m_as.boolean;
+            else if constexpr (std::is_same_v<T, number>)  return m_as.number;
+            else return static_cast<T*>(m_as.object);
+        }
+
+        [[nodiscard]] auto is_undefined() const -> bool
+        {
+            return m_type == Type::Undefined;
+        }
+
+        [[nodiscard]] auto is_truthy() const -> bool
+        {
+            if (m_type == Type::Nil)     return false;
+            if (m_type == Type::Boolean) return m_as.boolean;
+            return true;
+        }
+
+        [[nodiscard]] auto operator==(const Value& other) const -> bool;
+        [[nodiscard]] auto stringify() const -> std::string;
+
+    private:
+        Type m_type;
+        union
+        {
+            bool   boolean;
+            double number;
+            Obj*   object;
+        } m_as;
+    };
+} // namespace loxe::vm
+
+#endif // !LOXE_VM_VALUE_HPP
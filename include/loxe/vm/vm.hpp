@@ -0,0 +1,13 @@
+#pragma once
+
+#ifndef LOXE_VM_VM_HPP
+#define LOXE_VM_VM_HPP
+
+#include <string>
+
+namespace loxe::vm
+{
+    auto run_file(std::string filename) -> void;
+} // namespace loxe::vm
+
+#endif // !LOXE_VM_VM_HPP
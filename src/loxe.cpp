@@ -1,16 +1,17 @@
+#include <string_view>
+
 #include "loxe.hpp"
 
 auto main(int argc, char* argv[]) -> int
 {
-    switch (argc)
-    {
-        case 2:
-            loxe::tree_walker::run_file(argv[1]);
-            break;
-        default:
-            loxe::utility::println(std::cerr, "usage: loxe [script]");
-            break;
-    }
+    const auto engine = argc == 3 ? std::string_view(argv[1]) : std::string_view("--engine=tree_walker");
+
+    if ((argc == 2 || argc == 3) && engine == "--engine=tree_walker")
+        loxe::tree_walker::run_file(argv[argc - 1]);
+    else if (argc == 3 && engine == "--engine=vm")
+        loxe::vm::run_file(argv[argc - 1]);
+    else
+        loxe::utility::println(std::cerr, "usage: loxe [--engine=tree_walker|vm] [script | -]");
 
     return EXIT_SUCCESS;
 }
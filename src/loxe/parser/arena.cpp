@@ -0,0 +1,59 @@
+#include <algorithm>
+
+#include "loxe/parser/arena.hpp"
+
+loxe::ast::Arena::Arena(Arena&& other) noexcept
+    : m_blocks(std::move(other.m_blocks))
+    , m_destructors(std::move(other.m_destructors))
+    , m_cursor(std::exchange(other.m_cursor, nullptr))
+    , m_remaining(std::exchange(other.m_remaining, 0)) {}
+
+loxe::ast::Arena::~Arena()
+{
+    release();
+}
+
+auto loxe::ast::Arena::operator=(Arena&& other) noexcept -> Arena&
+{
+    if (this != &other)
+    {
+        release();
+        m_blocks      = std::move(other.m_blocks);
+        m_destructors = std::move(other.m_destructors);
+        m_cursor      = std::exchange(other.m_cursor, nullptr);
+        m_remaining   = std::exchange(other.m_remaining, 0);
+    }
+
+    return *this;
+}
+
+auto loxe::ast::Arena::allocate(std::size_t size, std::size_t align) -> void*
+{
+    auto memory = static_cast<void*>(m_cursor);
+    if (!m_cursor || !std::align(align, size, memory, m_remaining))
+    {
+        const auto capacity = std::max(block_size, size + align);
+        m_blocks.emplace_back(std::make_unique_for_overwrite<std::byte[]>(capacity));
+        memory      = m_blocks.back().get();
+        m_remaining = capacity;
+        std::align(align, size, memory, m_remaining);
+    }
+
+    m_cursor     = static_cast<std::byte*>(memory) + size;
+    m_remaining -= size;
+    return memory;
+}
+
+auto loxe::ast::Arena::release() -> void
+{
+    // nodes point at each other but never own anything, so the order only
+    // matters for the members that still hold heap memory of their own
+    std::for_each(m_destructors.rbegin(), m_destructors.rend(), [](const Destructor& entry) {
+        entry.destroy(entry.object, entry.count);
+    });
+
+    m_destructors.clear();
+    m_blocks.clear();
+    m_cursor    = nullptr;
+    m_remaining = 0;
+}
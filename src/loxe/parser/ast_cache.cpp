@@ -0,0 +1,1162 @@
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "loxe/common/except.hpp"
+#include "loxe/common/utility.hpp"
+#include "loxe/parser/ast_cache.hpp"
+#include "loxe/parser/resolver.hpp"
+#include "loxe/parser/source.hpp"
+
+namespace
+{
+    namespace ast = loxe::ast;
+
+    using Resolver = loxe::Resolver;
+    using deferred = std::unordered_map<const ast::FunctionExpr*, Resolver::Context>;
+
+    // bumped whenever the layout of an entry or of the nodes changes
+    constexpr auto magic   = std::string_view("loxe-ast");
+    constexpr auto version = std::uint32_t{3};
+
+    enum class Node : std::uint8_t
+    {
+        None,
+
+        ArrayExpr,
+        AssignExpr,
+        BinaryExpr,
+        BooleanExpr,
+        CallExpr,
+        CommaExpr,
+        ConditionalExpr,
+        FunctionExpr,
+        GetExpr,
+        GroupingExpr,
+        LogicalExpr,
+        NilExpr,
+        NumberExpr,
+        SetExpr,
+        StringExpr,
+        SubscriptExpr,
+        SuperExpr,
+        ThisExpr,
+        UnaryExpr,
+        VariableExpr,
+
+        BlockStmt,
+        BreakStmt,
+        ClassStmt,
+        ContinueStmt,
+        ExpressionStmt,
+        ForStmt,
+        FunctionStmt,
+        IfStmt,
+        ImportStmt,
+        LetStmt,
+        ModuleStmt,
+        PrintStmt,
+        ReturnStmt,
+        VariableStmt,
+        WhileStmt,
+    };
+
+    // names and strings that aren't a slice of their file are written with this in place of
+    // their length, and kept in a pool instead
+    constexpr auto pooled = std::uint32_t{0xffffffff};
+
+    // an entry that was cut short or doesn't hold what this build writes
+    struct Corrupt : public loxe::Exception {};
+
+    [[nodiscard]] auto hash(std::string_view text) -> std::uint64_t
+    {
+        constexpr auto k1 = std::uint64_t{0x9e3779b97f4a7c15};
+        constexpr auto k2 = std::uint64_t{0xff51afd7ed558ccd};
+
+        auto h = k1 ^ text.size();
+        auto i = std::size_t{0};
+        for (; i + 8 <= text.size(); i += 8)
+        {
+            auto word = std::uint64_t{0};
+            std::memcpy(&word, text.data() + i, sizeof(word));
+            h = std::rotl(h ^ (word * k1), 27) * k2;
+        }
+        for (; i < text.size(); i++)
+            h = std::rotl(h ^ static_cast<unsigned char>(text[i]), 8) * k1;
+
+        h ^= h >> 33;
+        h *= k2;
+        h ^= h >> 33;
+        return h;
+    }
+
+    [[nodiscard]] auto environment(const char* name) -> std::optional<std::string>
+    {
+#if defined(_MSC_VER)
+        auto value = static_cast<char*>(nullptr);
+        auto size  = std::size_t{0};
+        if (_dupenv_s(&value, &size, name) != 0 || !value) return std::nullopt;
+
+        auto result = std::string(value);
+        std::free(value);
+        return result;
+#else
+        const auto value = std::getenv(name);
+        if (!value) return std::nullopt;
+        return std::string(value);
+#endif
+    }
+
+    [[nodiscard]] auto directory() -> std::filesystem::path
+    {
+        if (const auto dir = environment("LOXE_CACHE_DIR"))
+            return *dir;
+        if (const auto dir = environment("XDG_CACHE_HOME"); dir && !dir->empty())
+            return std::filesystem::path(*dir) / "loxe";
+        if (const auto dir = environment("HOME"); dir && !dir->empty())
+            return std::filesystem::path(*dir) / ".cache" / "loxe";
+        return {};
+    }
+
+    // what is left of the file an offset points into, from there on. neighbouring nodes are
+    // nearly always from the same file, so the one found last is tried first
+    class Files
+    {
+    public:
+        explicit Files(const loxe::SourceMap& sources)
+            : m_sources(&sources) {}
+
+        [[nodiscard]] auto rest(std::uint32_t offset) -> std::string_view
+        {
+            if (!m_file || offset < m_file->base || offset - m_file->base > m_file->text.size())
+            {
+                const auto& files = m_sources->files();
+                const auto  next  = std::ranges::upper_bound(files, offset, {}, &loxe::SourceMap::File::base);
+                if (offset == loxe::Token::nowhere || next == files.begin()) return {};
+
+                m_file = &*std::prev(next);
+                if (offset - m_file->base > m_file->text.size()) return {};
+            }
+
+            return m_file->text.substr(offset - m_file->base);
+        }
+
+    private:
+        const loxe::SourceMap*       m_sources = nullptr;
+        const loxe::SourceMap::File* m_file    = nullptr;
+    };
+
+    // nodes are written depth first, each as its `Node` tag followed by its fields. the few
+    // expressions the resolver looks a variable up for end in their depth and slot. they are
+    // preceded by what the resolver keeps for skipped function bodies, if there are any: the
+    // globals and every scope the bodies were declared in, which each body refers to by index
+    class Writer final : public ast::Stmt::const_visitor<void>, public ast::Expr::const_visitor<void>
+    {
+    public:
+        explicit Writer(const loxe::SourceMap& sources)
+            : m_files(sources) {}
+
+        template<typename T>
+        auto value(T value) -> void
+        {
+            auto bytes = std::array<char, sizeof(T)>();
+            std::memcpy(bytes.data(), &value, sizeof(T));
+            m_tree.append(bytes.data(), bytes.size());
+        }
+
+        // most names are still sitting in the source at `offset`, and the source is checked to
+        // be unchanged before an entry is used, so their length is all that has to be kept
+        auto text(std::string_view text, std::uint32_t offset) -> void
+        {
+            const auto rest = m_files.rest(offset);
+            if (text.data() == rest.data() && text.size() <= rest.size() && text.size() < pooled)
+                return value(static_cast<std::uint32_t>(text.size()));
+
+            auto entry = m_strings.find(text);
+            if (entry == m_strings.end())
+            {
+                entry = m_strings.emplace(std::string(text), static_cast<std::uint32_t>(m_pool.size())).first;
+                m_pool += text;
+            }
+
+            value(pooled);
+            value(entry->second);
+            value(static_cast<std::uint32_t>(text.size()));
+        }
+
+        auto span(const loxe::Span& span) -> void
+        {
+            value(span.type);
+            value(span.offset);
+            text(span.lexeme, span.offset);
+        }
+
+        auto expr(const ast::Expr* expr) -> void
+        {
+            if (expr) expr->accept(*this);
+            else      value(Node::None);
+        }
+
+        auto stmt(const ast::Stmt* stmt) -> void
+        {
+            if (stmt) stmt->accept(*this);
+            else      value(Node::None);
+        }
+
+        template<typename T>
+        auto list(std::span<T> items) -> void
+        {
+            value(static_cast<std::uint32_t>(items.size()));
+            for (const auto& item : items)
+            {
+                if constexpr (std::is_same_v<T, loxe::Span>)             span(item);
+                else if constexpr (std::is_convertible_v<T, ast::Expr*>) expr(item);
+                else                                                     stmt(item);
+            }
+        }
+
+        auto resolver(const Resolver::map* globals, const deferred* functions) -> void
+        {
+            value(static_cast<std::uint8_t>(globals != nullptr));
+            if (!globals) return;
+
+            auto table = std::vector<const Resolver::map*>();
+            for (const auto& [function, context] : *functions)
+            {
+                for (const auto& scope : context.scopes)
+                    if (m_scopes.emplace(scope.get(), static_cast<std::uint32_t>(table.size())).second)
+                        table.push_back(scope.get());
+            }
+
+            m_deferred = functions;
+            scope(*globals);
+            value(static_cast<std::uint32_t>(table.size()));
+            for (const auto scope : table)
+                this->scope(*scope);
+        }
+
+        [[nodiscard]] auto pool() const -> std::string_view { return m_pool; }
+        [[nodiscard]] auto tree() const -> std::string_view { return m_tree; }
+
+    private:
+        auto resolved(const ast::Expr& expr) -> void
+        {
+            value(expr.depth);
+            value(expr.slot);
+        }
+
+        auto scope(const Resolver::map& scope) -> void
+        {
+            value(static_cast<std::uint32_t>(scope.size()));
+            for (const auto& [name, attribute] : scope)
+            {
+                text(name, loxe::Token::nowhere);
+                value(static_cast<std::uint8_t>(attribute.defined));
+                value(static_cast<std::uint8_t>(attribute.assignable));
+                value(static_cast<std::uint8_t>(attribute.hoisted));
+                value(attribute.slot);
+            }
+        }
+
+        auto context(const ast::FunctionExpr& function) -> void
+        {
+            const auto found = m_deferred ? m_deferred->find(&function) : deferred::const_iterator();
+            value(static_cast<std::uint8_t>(m_deferred && found != m_deferred->end()));
+            if (!m_deferred || found == m_deferred->end()) return;
+
+            const auto& context = found->second;
+            value(static_cast<std::uint32_t>(context.scopes.size()));
+            for (const auto& scope : context.scopes)
+                value(m_scopes.at(scope.get()));
+            value(context.fun_type);
+            value(context.cls_type);
+            value(context.loops);
+        }
+
+        auto visit(const ast::ArrayExpr& expr) -> void override
+        {
+            value(Node::ArrayExpr);
+            span(expr.start);
+            this->expr(expr.size);
+            list(expr.initializer);
+        }
+
+        auto visit(const ast::AssignExpr& expr) -> void override
+        {
+            value(Node::AssignExpr);
+            span(expr.name);
+            this->expr(expr.value);
+            resolved(expr);
+        }
+
+        auto visit(const ast::BinaryExpr& expr) -> void override
+        {
+            value(Node::BinaryExpr);
+            span(expr.op);
+            this->expr(expr.lhs);
+            this->expr(expr.rhs);
+        }
+
+        auto visit(const ast::BooleanExpr& expr) -> void override
+        {
+            value(Node::BooleanExpr);
+            value(static_cast<std::uint8_t>(expr.value));
+            value(expr.offset);
+        }
+
+        auto visit(const ast::CallExpr& expr) -> void override
+        {
+            value(Node::CallExpr);
+            span(expr.paren);
+            this->expr(expr.callee);
+            list(expr.args);
+        }
+
+        auto visit(const ast::CommaExpr& expr) -> void override
+        {
+            value(Node::CommaExpr);
+            list(expr.expressions);
+        }
+
+        auto visit(const ast::ConditionalExpr& expr) -> void override
+        {
+            value(Node::ConditionalExpr);
+            this->expr(expr.condition);
+            this->expr(expr.then_branch);
+            this->expr(expr.else_branch);
+        }
+
+        auto visit(const ast::FunctionExpr& expr) -> void override
+        {
+            value(Node::FunctionExpr);
+            span(expr.name);
+            list(expr.params);
+            stmt(expr.body);
+            value(expr.slots);
+            value(expr.nesting);
+            span(expr.deferred);
+            if (!expr.body && !expr.deferred.lexeme.empty()) context(expr);
+        }
+
+        auto visit(const ast::GetExpr& expr) -> void override
+        {
+            value(Node::GetExpr);
+            span(expr.name);
+            this->expr(expr.object);
+        }
+
+        auto visit(const ast::GroupingExpr& expr) -> void override
+        {
+            value(Node::GroupingExpr);
+            this->expr(expr.expression);
+        }
+
+        auto visit(const ast::LogicalExpr& expr) -> void override
+        {
+            value(Node::LogicalExpr);
+            span(expr.op);
+            this->expr(expr.lhs);
+            this->expr(expr.rhs);
+        }
+
+        auto visit(const ast::NilExpr& expr) -> void override
+        {
+            value(Node::NilExpr);
+            value(expr.offset);
+        }
+
+        auto visit(const ast::NumberExpr& expr) -> void override
+        {
+            value(Node::NumberExpr);
+            value(expr.value);
+            value(expr.offset);
+        }
+
+        auto visit(const ast::SetExpr& expr) -> void override
+        {
+            value(Node::SetExpr);
+            span(expr.name);
+            this->expr(expr.object);
+            this->expr(expr.value);
+        }
+
+        auto visit(const ast::StringExpr& expr) -> void override
+        {
+            value(Node::StringExpr);
+            value(expr.offset);
+            text(expr.value, expr.offset == loxe::Token::nowhere ? expr.offset : expr.offset + 1);
+        }
+
+        auto visit(const ast::SubscriptExpr& expr) -> void override
+        {
+            value(Node::SubscriptExpr);
+            span(expr.bracket);
+            this->expr(expr.expression);
+            this->expr(expr.index);
+            value(static_cast<std::uint8_t>(expr.new_value.has_value()));
+            if (expr.new_value) this->expr(*expr.new_value);
+        }
+
+        auto visit(const ast::SuperExpr& expr) -> void override
+        {
+            value(Node::SuperExpr);
+            span(expr.keyword);
+            span(expr.method);
+            resolved(expr);
+        }
+
+        auto visit(const ast::ThisExpr& expr) -> void override
+        {
+            value(Node::ThisExpr);
+            span(expr.keyword);
+            resolved(expr);
+        }
+
+        auto visit(const ast::UnaryExpr& expr) -> void override
+        {
+            value(Node::UnaryExpr);
+            span(expr.op);
+            this->expr(expr.operand);
+        }
+
+        auto visit(const ast::VariableExpr& expr) -> void override
+        {
+            value(Node::VariableExpr);
+            span(expr.name);
+            resolved(expr);
+        }
+
+        auto visit(const ast::BlockStmt& stmt) -> void override
+        {
+            value(Node::BlockStmt);
+            list(stmt.statements);
+            value(stmt.slots);
+        }
+
+        auto visit(const ast::BreakStmt& stmt) -> void override
+        {
+            value(Node::BreakStmt);
+            span(stmt.keyword);
+        }
+
+        auto visit(const ast::ClassStmt& stmt) -> void override
+        {
+            value(Node::ClassStmt);
+            span(stmt.name);
+            expr(stmt.superclass);
+            list(stmt.methods);
+            value(stmt.slot);
+            value(static_cast<std::uint8_t>(stmt.global));
+        }
+
+        auto visit(const ast::ContinueStmt& stmt) -> void override
+        {
+            value(Node::ContinueStmt);
+            span(stmt.keyword);
+        }
+
+        auto visit(const ast::ExpressionStmt& stmt) -> void override
+        {
+            value(Node::ExpressionStmt);
+            expr(stmt.expression);
+        }
+
+        auto visit(const ast::ForStmt& stmt) -> void override
+        {
+            value(Node::ForStmt);
+            this->stmt(stmt.initializer);
+            expr(stmt.condition);
+            expr(stmt.update);
+            this->stmt(stmt.body);
+        }
+
+        auto visit(const ast::FunctionStmt& stmt) -> void override
+        {
+            value(Node::FunctionStmt);
+            expr(stmt.function);
+            value(stmt.slot);
+            value(static_cast<std::uint8_t>(stmt.global));
+        }
+
+        auto visit(const ast::IfStmt& stmt) -> void override
+        {
+            value(Node::IfStmt);
+            expr(stmt.condition);
+            this->stmt(stmt.then_branch);
+            this->stmt(stmt.else_branch);
+        }
+
+        auto visit(const ast::ImportStmt& stmt) -> void override
+        {
+            value(Node::ImportStmt);
+            span(stmt.path);
+            list(stmt.body);
+        }
+
+        auto visit(const ast::LetStmt& stmt) -> void override
+        {
+            value(Node::LetStmt);
+            span(stmt.name);
+            expr(stmt.initializer);
+            value(stmt.slot);
+            value(static_cast<std::uint8_t>(stmt.global));
+        }
+
+        auto visit(const ast::ModuleStmt& stmt) -> void override
+        {
+            value(Node::ModuleStmt);
+            span(stmt.name);
+            list(stmt.body);
+            value(stmt.slot);
+            value(static_cast<std::uint8_t>(stmt.global));
+            value(stmt.slots);
+
+            value(static_cast<std::uint32_t>(stmt.members.size()));
+            for (const auto& [name, slot] : stmt.members)
+            {
+                text(name, loxe::Token::nowhere);
+                value(slot);
+            }
+        }
+
+        auto visit(const ast::PrintStmt& stmt) -> void override
+        {
+            value(Node::PrintStmt);
+            expr(stmt.expression);
+        }
+
+        auto visit(const ast::ReturnStmt& stmt) -> void override
+        {
+            value(Node::ReturnStmt);
+            span(stmt.keyword);
+            expr(stmt.value);
+        }
+
+        auto visit(const ast::VariableStmt& stmt) -> void override
+        {
+            value(Node::VariableStmt);
+            span(stmt.name);
+            expr(stmt.initializer);
+            value(stmt.slot);
+            value(static_cast<std::uint8_t>(stmt.global));
+        }
+
+        auto visit(const ast::WhileStmt& stmt) -> void override
+        {
+            value(Node::WhileStmt);
+            expr(stmt.condition);
+            this->stmt(stmt.body);
+        }
+
+    private:
+        Files                                    m_files;
+        std::string                              m_tree    = {};
+        std::string                              m_pool    = {};
+        loxe::utility::string_map<std::uint32_t> m_strings = {};
+
+        const deferred*                                       m_deferred = nullptr;
+        std::unordered_map<const Resolver::map*, std::uint32_t> m_scopes   = {};
+    };
+
+    // the inverse of `Writer`. every read is bounds checked and anything unexpected throws
+    // `Corrupt`. arguments are read into locals first since their order of evaluation isn't
+    // fixed inside a call
+    class Reader
+    {
+    public:
+        Reader(std::string_view data, ast::Arena& arena, const loxe::SourceMap& sources)
+            : m_data(data), m_arena(&arena), m_files(sources) {}
+
+        [[nodiscard]] auto bytes(std::size_t count) -> std::string_view
+        {
+            if (count > m_data.size()) throw Corrupt();
+
+            const auto result = m_data.substr(0, count);
+            m_data.remove_prefix(count);
+            return result;
+        }
+
+        template<typename T>
+        [[nodiscard]] auto value() -> T
+        {
+            auto result = T();
+            std::memcpy(&result, bytes(sizeof(T)).data(), sizeof(T));
+            return result;
+        }
+
+        [[nodiscard]] auto flag() -> bool
+        {
+            return value<std::uint8_t>() != 0;
+        }
+
+        [[nodiscard]] auto size() -> std::size_t
+        {
+            return value<std::size_t>();
+        }
+
+        [[nodiscard]] auto text(std::uint32_t offset) -> std::string_view
+        {
+            if (const auto length = value<std::uint32_t>(); length != pooled)
+            {
+                const auto rest = m_files.rest(offset);
+                if (length > rest.size()) throw Corrupt();
+                return rest.substr(0, length);
+            }
+
+            const auto start  = value<std::uint32_t>();
+            const auto length = value<std::uint32_t>();
+            if (start > m_pool.size() || length > m_pool.size() - start) throw Corrupt();
+            return m_pool.substr(start, length);
+        }
+
+        [[nodiscard]] auto span() -> loxe::Span
+        {
+            const auto type   = value<loxe::Token::Type>();
+            const auto offset = value<std::uint32_t>();
+            if (type > loxe::Token::Type::Unknown) throw Corrupt();
+            return { type, offset, text(offset) };
+        }
+
+        auto use_pool(std::string_view pool) -> void
+        {
+            m_pool = pool;
+        }
+
+        [[nodiscard]] auto rest() const -> std::string_view
+        {
+            return m_data;
+        }
+
+        [[nodiscard]] auto done() const -> bool
+        {
+            return m_data.empty();
+        }
+
+        [[nodiscard]] auto expr() -> ast::expr_ptr
+        {
+            const auto node = value<Node>();
+            return node == Node::None ? nullptr : expr(node);
+        }
+
+        [[nodiscard]] auto function() -> ast::fun_ptr
+        {
+            const auto result = dynamic_cast<ast::FunctionExpr*>(expr());
+            if (!result) throw Corrupt();
+            return result;
+        }
+
+        [[nodiscard]] auto stmt() -> ast::stmt_ptr
+        {
+            switch (value<Node>())
+            {
+                case Node::None:
+                    return nullptr;
+
+                case Node::BlockStmt:
+                {
+                    const auto statements = stmts();
+                    const auto result     = make<ast::BlockStmt>(statements);
+                    result->slots = size();
+                    return result;
+                }
+
+                case Node::BreakStmt:
+                    return make<ast::BreakStmt>(span());
+
+                case Node::ClassStmt:
+                {
+                    const auto name       = span();
+                    const auto superclass = expr();
+                    const auto methods    = list<ast::fun_ptr>([this] { return function(); });
+                    const auto result     = make<ast::ClassStmt>(name, superclass, methods);
+                    result->slot   = size();
+                    result->global = flag();
+                    return result;
+                }
+
+                case Node::ContinueStmt:
+                    return make<ast::ContinueStmt>(span());
+
+                case Node::ExpressionStmt:
+                    return make<ast::ExpressionStmt>(expr());
+
+                case Node::ForStmt:
+                {
+                    const auto initializer = stmt();
+                    const auto condition   = expr();
+                    const auto update      = expr();
+                    const auto body        = stmt();
+                    return make<ast::ForStmt>(initializer, condition, update, body);
+                }
+
+                case Node::FunctionStmt:
+                {
+                    const auto result = make<ast::FunctionStmt>(function());
+                    result->slot   = size();
+                    result->global = flag();
+                    return result;
+                }
+
+                case Node::IfStmt:
+                {
+                    const auto condition   = expr();
+                    const auto then_branch = stmt();
+                    const auto else_branch = stmt();
+                    return make<ast::IfStmt>(condition, then_branch, else_branch);
+                }
+
+                case Node::ImportStmt:
+                {
+                    const auto path = span();
+                    return make<ast::ImportStmt>(path, stmts());
+                }
+
+                case Node::LetStmt:
+                {
+                    const auto name   = span();
+                    const auto result = make<ast::LetStmt>(name, expr());
+                    result->slot   = size();
+                    result->global = flag();
+                    return result;
+                }
+
+                case Node::ModuleStmt:
+                {
+                    const auto name   = span();
+                    const auto result = make<ast::ModuleStmt>(name, stmts());
+                    result->slot   = size();
+                    result->global = flag();
+                    result->slots  = size();
+
+                    for (auto count = value<std::uint32_t>(); count > 0; count--)
+                    {
+                        const auto member = text(loxe::Token::nowhere);
+                        result->members.insert_or_assign(std::string(member), size());
+                    }
+                    return result;
+                }
+
+                case Node::PrintStmt:
+                    return make<ast::PrintStmt>(expr());
+
+                case Node::ReturnStmt:
+                {
+                    const auto keyword = span();
+                    return make<ast::ReturnStmt>(keyword, expr());
+                }
+
+                case Node::VariableStmt:
+                {
+                    const auto name   = span();
+                    const auto result = make<ast::VariableStmt>(name, expr());
+                    result->slot   = size();
+                    result->global = flag();
+                    return result;
+                }
+
+                case Node::WhileStmt:
+                {
+                    const auto condition = expr();
+                    return make<ast::WhileStmt>(condition, stmt());
+                }
+
+                default:
+                    throw Corrupt();
+            }
+        }
+
+        [[nodiscard]] auto stmts() -> ast::stmt_list
+        {
+            return list<ast::stmt_ptr>([this] { return stmt(); });
+        }
+
+        // the resolver's globals, if it was kept. the scopes of skipped bodies are read along
+        [[nodiscard]] auto resolver() -> std::optional<Resolver::map>
+        {
+            if (!flag()) return std::nullopt;
+
+            auto globals = scope();
+            auto count   = value<std::uint32_t>();
+            if (count > m_data.size()) throw Corrupt();
+
+            m_scopes.reserve(count);
+            for (; count > 0; count--)
+                m_scopes.push_back(std::make_shared<const Resolver::map>(scope()));
+            return globals;
+        }
+
+        [[nodiscard]] auto functions() -> deferred
+        {
+            return std::move(m_deferred);
+        }
+
+        // sites aren't stored, the nodes that have them are numbered again as they are read
+        [[nodiscard]] auto sites() const -> Resolver::Sites
+        {
+            return m_sites;
+        }
+
+    private:
+        template<typename T, typename... Args>
+        [[nodiscard]] auto make(Args&&... args) -> T*
+        {
+            return m_arena->make<T>(std::forward<Args>(args)...);
+        }
+
+        template<typename T, typename F>
+        [[nodiscard]] auto list(F read) -> std::span<T>
+        {
+            const auto count = value<std::uint32_t>();
+            if (count > m_data.size()) throw Corrupt(); // every item takes at least a byte
+
+            auto items = std::vector<T>();
+            items.reserve(count);
+            for (auto i = std::uint32_t{0}; i < count; i++)
+                items.push_back(read());
+            return m_arena->list(std::move(items));
+        }
+
+        [[nodiscard]] auto resolved(ast::expr_ptr expr) -> ast::expr_ptr
+        {
+            expr->depth = value<std::uint32_t>();
+            expr->slot  = value<std::uint32_t>();
+            return expr;
+        }
+
+        [[nodiscard]] auto scope() -> Resolver::map
+        {
+            auto result = Resolver::map();
+            for (auto count = value<std::uint32_t>(); count > 0; count--)
+            {
+                const auto name       = text(loxe::Token::nowhere);
+                const auto defined    = flag();
+                const auto assignable = flag();
+                auto       attribute  = Resolver::Attribute(defined, assignable);
+                attribute.hoisted = flag();
+                attribute.slot    = size();
+                result.insert_or_assign(std::string(name), attribute);
+            }
+            return result;
+        }
+
+        [[nodiscard]] auto context() -> Resolver::Context
+        {
+            auto result = Resolver::Context();
+            auto count  = value<std::uint32_t>();
+            if (count > m_data.size()) throw Corrupt();
+
+            for (; count > 0; count--)
+            {
+                const auto index = value<std::uint32_t>();
+                if (index >= m_scopes.size()) throw Corrupt();
+                result.scopes.push_back(m_scopes[index]);
+            }
+
+            result.fun_type = value<Resolver::FunType>();
+            result.cls_type = value<Resolver::ClsType>();
+            result.loops    = value<int>();
+            if (result.fun_type > Resolver::FunType::None || result.cls_type > Resolver::ClsType::SubClass) throw Corrupt();
+            return result;
+        }
+
+        [[nodiscard]] auto exprs() -> ast::expr_list
+        {
+            return list<ast::expr_ptr>([this] { return expr(); });
+        }
+
+        [[nodiscard]] auto expr(Node node) -> ast::expr_ptr
+        {
+            switch (node)
+            {
+                case Node::ArrayExpr:
+                {
+                    const auto start = span();
+                    const auto size  = expr();
+                    return make<ast::ArrayExpr>(start, size, exprs());
+                }
+
+                case Node::AssignExpr:
+                {
+                    const auto name = span();
+                    return resolved(make<ast::AssignExpr>(name, expr()));
+                }
+
+                case Node::BinaryExpr:
+                {
+                    const auto op  = span();
+                    const auto lhs = expr();
+                    return make<ast::BinaryExpr>(op, lhs, expr());
+                }
+
+                case Node::BooleanExpr:
+                {
+                    const auto result = make<ast::BooleanExpr>(flag());
+                    result->offset = value<std::uint32_t>();
+                    return result;
+                }
+
+                case Node::CallExpr:
+                {
+                    const auto paren  = span();
+                    const auto callee = expr();
+                    return make<ast::CallExpr>(paren, callee, exprs());
+                }
+
+                case Node::CommaExpr:
+                    return make<ast::CommaExpr>(exprs());
+
+                case Node::ConditionalExpr:
+                {
+                    const auto condition   = expr();
+                    const auto then_branch = expr();
+                    return make<ast::ConditionalExpr>(condition, then_branch, expr());
+                }
+
+                case Node::FunctionExpr:
+                {
+                    const auto name   = span();
+                    const auto params = list<loxe::Span>([this] { return span(); });
+                    const auto result = make<ast::FunctionExpr>(name, params, stmt());
+                    result->slots    = size();
+                    result->nesting  = size();
+                    result->deferred = span();
+                    if (!result->body && !result->deferred.lexeme.empty() && flag())
+                        m_deferred.insert_or_assign(result, context());
+                    return result;
+                }
+
+                case Node::GetExpr:
+                {
+                    const auto name   = span();
+                    const auto result = make<ast::GetExpr>(name, expr());
+                    result->site = m_sites.properties++;
+                    return result;
+                }
+
+                case Node::GroupingExpr:
+                    return make<ast::GroupingExpr>(expr());
+
+                case Node::LogicalExpr:
+                {
+                    const auto op  = span();
+                    const auto lhs = expr();
+                    return make<ast::LogicalExpr>(op, lhs, expr());
+                }
+
+                case Node::NilExpr:
+                {
+                    const auto result = make<ast::NilExpr>();
+                    result->offset = value<std::uint32_t>();
+                    return result;
+                }
+
+                case Node::NumberExpr:
+                {
+                    const auto result = make<ast::NumberExpr>(value<double>());
+                    result->offset = value<std::uint32_t>();
+                    return result;
+                }
+
+                case Node::SetExpr:
+                {
+                    const auto name   = span();
+                    const auto object = expr();
+                    const auto result = make<ast::SetExpr>(name, object, expr());
+                    result->site = m_sites.properties++;
+                    return result;
+                }
+
+                case Node::StringExpr:
+                {
+                    const auto offset = value<std::uint32_t>();
+                    const auto result = make<ast::StringExpr>(text(offset == loxe::Token::nowhere ? offset : offset + 1));
+                    result->offset = offset;
+                    result->site   = m_sites.strings++;
+                    return result;
+                }
+
+                case Node::SubscriptExpr:
+                {
+                    const auto bracket    = span();
+                    const auto expression = expr();
+                    const auto index      = expr();
+                    const auto new_value  = flag() ? ast::op_expr(expr()) : std::nullopt;
+                    return make<ast::SubscriptExpr>(bracket, expression, index, new_value);
+                }
+
+                case Node::SuperExpr:
+                {
+                    const auto keyword = span();
+                    const auto result  = make<ast::SuperExpr>(keyword, span());
+                    result->site = m_sites.supers++;
+                    return resolved(result);
+                }
+
+                case Node::ThisExpr:
+                    return resolved(make<ast::ThisExpr>(span()));
+
+                case Node::UnaryExpr:
+                {
+                    const auto op = span();
+                    return make<ast::UnaryExpr>(op, expr());
+                }
+
+                case Node::VariableExpr:
+                    return resolved(make<ast::VariableExpr>(span()));
+
+                default:
+                    throw Corrupt();
+            }
+        }
+
+    private:
+        std::string_view m_data  = {};
+        std::string_view m_pool  = {};
+        ast::Arena*      m_arena = nullptr;
+        Files            m_files;
+
+        std::vector<std::shared_ptr<const Resolver::map>> m_scopes   = {};
+        deferred                                          m_deferred = {};
+        Resolver::Sites                                   m_sites    = {};
+    };
+} // namespace
+
+loxe::AstCache::AstCache(std::string filename, std::string_view text)
+    : m_filename(std::move(filename))
+{
+    if (const auto dir = directory(); !dir.empty())
+        m_entry = dir / utility::as_string("{:016x}.ast", hash(text));
+}
+
+auto loxe::AstCache::load() const -> std::optional<ast::Program>
+{
+    if (m_entry.empty()) return std::nullopt;
+
+    auto program = ast::Program();
+    auto entry   = Source::open(m_entry.string());
+    if (!entry) return std::nullopt;
+
+    try
+    {
+        auto reader = Reader(program.arena.make<Source>(std::move(*entry))->text(), program.arena, program.sources);
+        if (reader.bytes(magic.size()) != magic || reader.value<std::uint32_t>() != version)
+            return std::nullopt;
+
+        struct File
+        {
+            std::uint32_t    base;
+            std::uint64_t    digest;
+            std::string_view path;
+        };
+
+        const auto header = reader.rest();
+        const auto count  = reader.value<std::uint32_t>();
+        if (count > reader.rest().size() / 16) throw Corrupt(); // every file takes at least this
+
+        auto files = std::vector<File>(count);
+        for (auto& file : files)
+        {
+            file.base   = reader.value<std::uint32_t>();
+            file.digest = reader.value<std::uint64_t>();
+            file.path   = reader.bytes(reader.value<std::uint32_t>());
+        }
+
+        // a damaged entry could still decode into nodes that point nowhere sensible
+        const auto pool     = reader.bytes(reader.value<std::uint32_t>());
+        const auto read     = header.substr(0, header.size() - reader.rest().size());
+        const auto checksum = reader.value<std::uint64_t>();
+        if (checksum != (std::rotl(hash(read), 1) ^ hash(reader.rest()))) return std::nullopt;
+
+        // the script itself comes first, under whatever name it was run by this time
+        for (const auto& file : files)
+        {
+            auto path   = std::string(&file == files.data() ? m_filename : file.path);
+            auto source = Source::open(path);
+            if (!source || hash(source->text()) != file.digest) return std::nullopt;
+
+            const auto& known = program.sources.files();
+            if (!known.empty() && file.base <= known.back().base) return std::nullopt;
+
+            const auto text = program.arena.make<Source>(std::move(*source))->text();
+            utility::ignore(program.sources.restore(file.base, text, std::move(path)));
+        }
+
+        reader.use_pool(pool);
+        auto globals = reader.resolver();
+        program.statements = reader.stmts();
+        if (!reader.done()) return std::nullopt;
+
+        if (globals)
+        {
+            program.resolver = program.arena.make<Resolver>();
+            program.resolver->m_scopes   = { std::move(*globals) };
+            program.resolver->m_frozen   = { nullptr };
+            program.resolver->m_deferred = reader.functions();
+            program.resolver->m_sites    = reader.sites();
+        }
+    }
+    catch (const Corrupt&)
+    {
+        return std::nullopt;
+    }
+
+    return program;
+}
+
+auto loxe::AstCache::store(const ast::Program& program) const -> void
+{
+    // streamed input can't be read a second time to check it
+    const auto& files = program.sources.files();
+    if (m_entry.empty() || std::ranges::any_of(files, [](const auto& file) { return file.path.empty(); })) return;
+
+    const auto resolver = program.resolver;
+    auto       writer   = Writer(program.sources);
+    writer.resolver(resolver ? &resolver->m_scopes.front() : nullptr, resolver ? &resolver->m_deferred : nullptr);
+    writer.list(program.statements);
+
+    auto header = std::string(magic);
+    auto append = [&header](auto value)
+    {
+        auto bytes = std::array<char, sizeof(value)>();
+        std::memcpy(bytes.data(), &value, sizeof(value));
+        header.append(bytes.data(), bytes.size());
+    };
+
+    append(version);
+    const auto start = header.size();
+    append(static_cast<std::uint32_t>(files.size()));
+    for (const auto& file : files)
+    {
+        append(file.base);
+        append(hash(file.text));
+        append(static_cast<std::uint32_t>(file.path.size()));
+        header += file.path;
+    }
+    append(static_cast<std::uint32_t>(writer.pool().size()));
+    header += writer.pool();
+    append(std::rotl(hash(std::string_view(header).substr(start)), 1) ^ hash(writer.tree()));
+
+    // written next to the entry and renamed over it, so a reader never sees half of one
+    auto error = std::error_code();
+    std::filesystem::create_directories(m_entry.parent_path(), error);
+    if (error) return;
+
+    auto temporary = m_entry;
+    temporary += utility::as_string(".{:08x}", std::random_device()());
+    {
+        auto file = std::ofstream(temporary, std::ios::binary | std::ios::trunc);
+        for (const auto part : { std::string_view(header), writer.tree() })
+            file.write(part.data(), static_cast<std::streamsize>(part.size()));
+        if (!file.good()) error = std::make_error_code(std::errc::io_error);
+    }
+
+    if (!error) std::filesystem::rename(temporary, m_entry, error);
+    if (error)  std::filesystem::remove(temporary, error);
+}
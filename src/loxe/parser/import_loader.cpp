@@ -0,0 +1,154 @@
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <utility>
+
+#include "loxe/parser/import_loader.hpp"
+#include "loxe/parser/parser.hpp"
+#include "loxe/parser/source.hpp"
+
+loxe::ImportLoader::~ImportLoader()
+{
+    {
+        auto lock = std::scoped_lock(m_mutex);
+        m_stop = true;
+        m_queue.clear();
+    }
+
+    m_wake.notify_all();
+}
+
+auto loxe::ImportLoader::root(std::string filename) -> Unit&
+{
+    auto key   = canonical(filename);
+    auto& unit = m_units.emplace_back(Unit{ .path = std::move(filename), .spliced = true });
+    m_cache.try_emplace(std::move(key), &unit);
+    return unit;
+}
+
+auto loxe::ImportLoader::request(Unit& from, const Span& keyword, ast::ImportStmt& statement) -> void
+{
+    auto path = std::string(statement.path.lexeme);
+    auto key  = canonical(path);
+
+    auto lock = std::scoped_lock(m_mutex);
+    auto [entry, inserted] = m_cache.try_emplace(std::move(key), nullptr);
+    if (inserted)
+    {
+        entry->second = &m_units.emplace_back(Unit{ .path = std::move(path) });
+        m_queue.push_back(entry->second);
+        m_pending++;
+
+        // threads are only started once there is something for them to do
+        const auto threads = std::max(1u, std::thread::hardware_concurrency());
+        if (m_workers.size() < std::min<std::size_t>(threads, m_pending))
+            m_workers.emplace_back([this] { work(); });
+        m_wake.notify_one();
+    }
+
+    from.events.emplace_back(Import{ keyword, &statement, entry->second });
+}
+
+auto loxe::ImportLoader::add_source(std::string_view text, std::string path) -> std::uint32_t
+{
+    auto lock = std::scoped_lock(m_mutex);
+    return m_sources->add(text, std::move(path)).base;
+}
+
+auto loxe::ImportLoader::flush(Unit& root) -> bool
+{
+    {
+        auto lock = std::unique_lock(m_mutex);
+        m_idle.wait(lock, [this] { return m_pending == 0; });
+    }
+
+    const auto clean = splice(root, root.path);
+    root.events.clear();
+    return clean;
+}
+
+auto loxe::ImportLoader::finish(Unit& root, ast::Arena& arena) -> bool
+{
+    const auto clean = flush(root);
+    for (auto& unit : m_units)
+        if (&unit != &root) utility::ignore(arena.make<ast::Arena>(std::move(unit.arena)));
+
+    return clean;
+}
+
+auto loxe::ImportLoader::canonical(std::string_view path) -> std::string
+{
+    // imports are looked up from the working directory; this only decides when two of
+    // them name the same file
+    auto error  = std::error_code();
+    auto result = std::filesystem::weakly_canonical(std::filesystem::path(path), error);
+    return error ? std::string(path) : result.string();
+}
+
+auto loxe::ImportLoader::work() -> void
+{
+    while (true)
+    {
+        auto unit = static_cast<Unit*>(nullptr);
+        {
+            auto lock = std::unique_lock(m_mutex);
+            m_wake.wait(lock, [this] { return m_stop || !m_queue.empty(); });
+            if (m_queue.empty()) return;
+
+            unit = m_queue.front();
+            m_queue.pop_front();
+        }
+
+        load(*unit);
+
+        auto lock = std::scoped_lock(m_mutex);
+        if (--m_pending == 0) m_idle.notify_all();
+    }
+}
+
+auto loxe::ImportLoader::load(Unit& unit) -> void
+{
+    auto source = Source::open(unit.path);
+    if (!source)
+    {
+        unit.found = false;
+        return;
+    }
+
+    auto text = unit.arena.make<Source>(std::move(*source))->text();
+    auto parser = Parser();
+    parser.m_defer = m_defer_bodies;
+    parser.parse_import(*this, unit, text);
+}
+
+auto loxe::ImportLoader::splice(Unit& unit, std::string_view name) -> bool
+{
+    auto clean  = true;
+    auto report = [&](const ParseError& error)
+    {
+        utility::println(std::cerr, "{}", error.report(*m_sources, name));
+        clean = false;
+    };
+
+    for (const auto& event : unit.events)
+    {
+        if (const auto error = std::get_if<ParseError>(&event))
+        {
+            report(*error);
+            continue;
+        }
+
+        const auto& import = std::get<Import>(event);
+        if (std::exchange(import.unit->spliced, true)) continue;
+
+        const auto path = std::string(import.statement->path.lexeme);
+        if (!import.unit->found)
+            report(ParseError(import.keyword, "failed to import file '" + path + "'"));
+        else if (!splice(*import.unit, path))
+            report(ParseError(import.keyword, "encountered error while parsing file '" + path + "'"));
+        else
+            import.statement->body = import.unit->statements;
+    }
+
+    return clean;
+}
@@ -1,5 +1,13 @@
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstdint>
+#include <istream>
+#include <string>
+
 #include "loxe/common/utility.hpp"
 #include "loxe/parser/lexer.hpp"
+#include "loxe/parser/scan.hpp"
 
 [[nodiscard]] inline constexpr auto is_digit(char c) -> bool
 {
@@ -16,14 +24,108 @@
     return (c == '_' || is_digit(c) || is_alpha(c));
 }
 
-auto loxe::Lexer::lex() -> Lexer&
+[[nodiscard]] inline constexpr auto is_hex(char c) -> bool
+{
+    return is_digit(c) || ('a' <= c && c <= 'f') || ('A' <= c && c <= 'F');
+}
+
+[[nodiscard]] inline constexpr auto is_blank(char c) -> bool
+{
+    return (c == ' ' || c == '\t' || c == '\r' || c == '\n');
+}
+
+// tokens only hold views, so every possible message is built once up front
+[[nodiscard]] static auto unexpected_character(char c) -> std::string_view
+{
+    static const auto messages = []
+    {
+        auto table = std::array<std::string, 256>();
+        for (auto i = 0; i < 256; i++)
+        {
+            const auto as_char = static_cast<char>(i);
+            const auto as_int  = int{ as_char };
+            const auto value   = (as_char <= ' ') ? "int value - " + std::to_string(as_int) : std::string(1, as_char);
+            table[static_cast<std::size_t>(i)] = "unexpected character: (" + value + ")";
+        }
+        return table;
+    }();
+
+    return messages[static_cast<unsigned char>(c)];
+}
+
+loxe::Lexer::Lexer(std::istream& input, SourceMap::File& file, ast::Arena* keep, std::size_t chunk)
+    : m_base(file.base), m_keep(keep), m_stream(std::make_unique<Stream>(input, file, chunk)) {}
+
+// digits may be grouped with single underscores, but never start or end with one
+[[nodiscard]] static auto well_separated(std::string_view digits) -> bool
 {
-    if (m_source.empty())
+    return !digits.empty() && digits.front() != '_' && digits.back() != '_' && digits.find("__") == std::string_view::npos;
+}
+
+// every power of ten a decimal of up to 15 digits can be scaled by, all exact as doubles
+static constexpr auto exact_powers = []
+{
+    auto result = std::array<double, 16>();
+    result[0] = 1;
+    for (auto i = std::size_t{1}; i < result.size(); i++) result[i] = result[i - 1] * 10;
+    return result;
+}();
+
+[[nodiscard]] static auto decode_number(std::string_view text, int base) -> std::optional<double>
+{
+    auto digits = std::string();
+    if (text.find('_') != std::string_view::npos)
+    {
+        std::ranges::copy_if(text, std::back_inserter(digits), [](char c) { return c != '_'; });
+        text = digits;
+    }
+
+    if (base == 10)
     {
-        return *this;
+        auto value = 0.0;
+        const auto [_, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+        return error == std::errc() ? std::optional(value) : std::nullopt;
+    }
+
+    auto value = std::uint64_t{0};
+    const auto [_, error] = std::from_chars(text.data(), text.data() + text.size(), value, base);
+    return error == std::errc() ? std::optional(static_cast<double>(value)) : std::nullopt;
+}
+
+[[nodiscard]] static auto unescape(std::string_view text) -> std::optional<std::string>
+{
+    auto result = std::string();
+    result.reserve(text.size());
+
+    for (auto i = std::size_t{0}; i < text.size(); i++)
+    {
+        if (text[i] != '\\')
+        {
+            result += text[i];
+            continue;
+        }
+
+        if (++i == text.size()) return std::nullopt;
+        switch (text[i])
+        {
+            case 'n':  result += '\n'; break;
+            case 't':  result += '\t'; break;
+            case 'r':  result += '\r'; break;
+            case '0':  result += '\0'; break;
+            case '\\': result += '\\'; break;
+            case '"':  result += '"';  break;
+            default:   return std::nullopt;
+        }
     }
-    else if (m_cursor == 0)
+
+    return result;
+}
+
+auto loxe::Lexer::lex() -> Lexer&
+{
+    if (!m_primed)
     {
+        m_primed        = true;
         m_cache.current = lex_token();
         m_cache.next    = lex_token();
     }
@@ -37,6 +139,19 @@ auto loxe::Lexer::lex() -> Lexer&
     return *this;
 }
 
+auto loxe::Lexer::tokenize() -> TokenBuffer
+{
+    auto tokens = TokenBuffer(m_source, m_base);
+    tokens.reserve(m_source.size() / 2); // typical code averages a token every 2-3 bytes
+    for (auto token = lex_token(); ; token = lex_token())
+    {
+        tokens.push(token);
+        if (token.type == Token::Type::EndOfFile) break;
+    }
+
+    return tokens;
+}
+
 auto loxe::Lexer::peek_prev() const -> const Token&
 {
     return m_cache.previous;
@@ -55,75 +170,158 @@ auto loxe::Lexer::peek_next() const -> const Token&
 auto loxe::Lexer::lex_token() -> Token
 {
     const auto c = skip_whitespace();
-    if      (!c)           return { Token::Type::EndOfFile, m_line, m_column };
-    else if (is_digit(*c)) return lex_number();
-    else if (is_ident(*c)) return lex_identifier();
-    else                   return lex_punctuation();
+    m_start      = m_cursor;
+
+    auto token = Token();
+    if      (!c)           token = { Token::Type::EndOfFile, position() };
+    else if (is_digit(*c)) token = lex_number();
+    else if (is_ident(*c)) token = lex_identifier();
+    else                   token = lex_punctuation();
+
+    // the window moves on under streamed tokens, so lexemes that must outlive it are copied out
+    if (m_stream && m_keep && !token.lexeme.empty() && token.lexeme.data() >= m_source.data() && token.lexeme.data() < end())
+        token.lexeme = m_keep->text(token.lexeme);
+
+    return token;
 }
 
 auto loxe::Lexer::lex_number() -> Token
 {
-    const auto line   = m_line;
-    const auto column = m_column;
+    const auto offset = position();
+
+    auto base = 10;
+    if (auto c = peek1(); *peek0() == '0' && c)
+    {
+        if      (*c == 'x' || *c == 'X') base = 16;
+        else if (*c == 'b' || *c == 'B') base = 2;
+        if (base != 10) utility::ignore(advance(), advance()); // 0x or 0b
+    }
+
+    auto skip = [this](auto is_part)
+    {
+        do
+        {
+            auto last = here();
+            while (last != end() && (*last == '_' || is_part(*last))) last++;
+            move_to(last);
+        } while (here() == end() && refill());
+    };
+
+    // decimal digits are accumulated on the way; while they fit a double's mantissa the
+    // value is that integer over an exact power of ten, a single correctly rounded division
+    auto mantissa = std::uint64_t{0};
+    auto digits   = std::size_t{0};
+    auto skip_decimal = [&]
+    {
+        do
+        {
+            auto last = here();
+            for (; last != end() && (*last == '_' || is_digit(*last)); last++)
+            {
+                if (*last == '_') continue;
+                mantissa = mantissa * 10 + static_cast<std::uint64_t>(*last - '0');
+                digits++;
+            }
+            move_to(last);
+        } while (here() == end() && refill());
+    };
+
+    if      (base == 16) skip(is_hex);
+    else if (base == 2)  skip([](char c) { return c == '0' || c == '1'; });
+    else                 skip_decimal();
 
-    auto lexeme = std::string();
-    for (auto c = peek0(); c && is_digit(*c); c = advance())
-        lexeme.push_back(*c);
+    const auto whole    = m_cursor - m_start;
+    const auto integral = digits;
 
-    if (peek0() && *peek0() == '.')
+    const auto fraction = base == 10 && peek0() && *peek0() == '.';
+    if (fraction)
     {
-        lexeme.push_back('.');
-        for (auto c = advance(); c && is_digit(*c); c = advance())
-            lexeme.push_back(*c);
+        utility::ignore(advance());
+        skip_decimal();
+    }
 
-        while (lexeme.back() == '0') lexeme.pop_back(); // remove trailing zeros
-        if    (lexeme.back() == '.') lexeme.pop_back(); // remove trailing decimal
+    const auto text     = slice(m_start);
+    const auto prefix   = std::size_t{base == 10 ? 0u : 2u};
+    const auto integer  = text.substr(prefix, whole - prefix);
+    const auto decimals = fraction ? text.substr(whole + 1) : std::string_view();
+    if (!well_separated(integer) || (!decimals.empty() && !well_separated(decimals)))
+        return { Token::Type::Unknown, offset, "malformed number literal" };
+
+    const auto exact = base == 10 && digits < exact_powers.size();
+    const auto value = exact ? std::optional(static_cast<double>(mantissa) / exact_powers[digits - integral])
+                             : decode_number(text.substr(prefix), base);
+    if (!value)
+        return { Token::Type::Unknown, offset, "number literal out of range" };
+
+    auto lexeme = text;
+    if (fraction)
+    {
+        while (lexeme.back() == '0') lexeme.remove_suffix(1); // remove trailing zeros
+        if    (lexeme.back() == '.') lexeme.remove_suffix(1); // remove trailing decimal
     }
 
-    return { Token::Type::Number, line, column, std::move(lexeme) };
+    return { Token::Type::Number, offset, lexeme, *value };
 }
 
 auto loxe::Lexer::lex_string() -> Token
 {
-    const auto line   = m_line;
-    const auto column = m_column;
+    const auto offset = position();
 
-    auto lexeme = std::string();
-    for (auto c = advance(); c && *c != '"'; c = advance())
-        lexeme.push_back(*c);
+    utility::ignore(advance()); // leading "
+    for (;;)
+    {
+        move_to(scan::find(here(), end(), '"'));
+        if (here() == end())
+        {
+            if (refill()) continue;
+            break;
+        }
+
+        // a quote behind an odd number of backslashes is escaped and doesn't end the string
+        auto slashes = std::size_t{0};
+        while (m_cursor - slashes > m_start + 1 && m_source[m_cursor - slashes - 1] == '\\') slashes++;
+        if (slashes % 2 == 0) break;
+        utility::ignore(advance());
+    }
 
     if (at_end())
-        return { Token::Type::Unknown, line, column, "unterminated string literal" };
+        return { Token::Type::Unknown, offset, "unterminated string literal" };
 
     utility::ignore(advance()); // trailing "
-    return { Token::Type::String, line, column, std::move(lexeme) };
+
+    auto contents = slice(m_start + 1);
+    contents.remove_suffix(1);
+    if (contents.find('\\') == std::string_view::npos)
+        return { Token::Type::String, offset, contents };
+
+    const auto unescaped = unescape(contents);
+    if (!unescaped)
+        return { Token::Type::Unknown, offset, "invalid escape sequence in string literal" };
+
+    return { Token::Type::String, offset, storage().text(*unescaped) };
 }
 
 auto loxe::Lexer::lex_identifier() -> Token
 {
-    const auto line   = m_line;
-    const auto column = m_column;
+    const auto offset = position();
 
-    auto lexeme = std::string();
-    for (auto c = peek0(); c && is_ident(*c); c = advance())
-        lexeme.push_back(*c);
+    do
+    {
+        move_to(scan::skip_ident(here(), end()));
+    } while (here() == end() && refill());
 
-    const auto type = Token::ident_type(lexeme);
-    return { type, line, column, std::move(lexeme) };
+    const auto lexeme = slice(m_start);
+    return { Token::ident_type(lexeme), offset, lexeme };
 }
 
 auto loxe::Lexer::lex_punctuation() -> Token
 {
-    const auto line   = m_line;
-    const auto column = m_column;
+    const auto offset = position();
 
     auto make_token = [&](Token::Type type, int length = 1) -> Token
     {
-        auto lexeme = std::string();
-        for (auto c = peek0(); c && length; length--, c = advance())
-            lexeme.push_back(*c);
-
-        return { type, line, column, std::move(lexeme) };
+        for (auto c = peek0(); c && length; length--, c = advance()) {}
+        return { type, offset, slice(m_start) };
     };
 
     const auto next   = peek1();
@@ -159,50 +357,110 @@ auto loxe::Lexer::lex_punctuation() -> Token
         case '"': return lex_string();
     }
 
-    const auto as_char = char{ *peek0() };
-    const auto as_int  = int { as_char  };
-    const auto value   = (as_char <= ' ') ? "int value - " + std::to_string(as_int) : std::string(1, as_char);
-
+    const auto message = unexpected_character(*peek0());
     utility::ignore(advance());
-    return { Token::Type::Unknown, line, column, "unexpected character: (" + value + ")"};
+    return { Token::Type::Unknown, offset, message };
+}
+
+auto loxe::Lexer::slice(std::size_t start) const -> std::string_view
+{
+    return m_source.substr(start, m_cursor - start);
+}
+
+auto loxe::Lexer::storage() -> ast::Arena&
+{
+    return m_keep ? *m_keep : m_own;
 }
 
-auto loxe::Lexer::at_end() const -> bool
+auto loxe::Lexer::at_end() -> bool
 {
-    return m_source.empty() || m_cursor >= m_source.size();
+    return m_cursor >= m_source.size() && !refill();
 }
 
-auto loxe::Lexer::peek0() const -> std::optional<char>
+auto loxe::Lexer::peek0() -> std::optional<char>
 {
     return at_end() ? std::nullopt : std::optional(m_source[m_cursor]);
 }
 
-auto loxe::Lexer::peek1() const -> std::optional<char>
+auto loxe::Lexer::peek1() -> std::optional<char>
 {
+    if (m_cursor + 1 >= m_source.size()) utility::ignore(refill());
+
     const auto next = m_cursor + 1;
     return at_end() || next >= m_source.size() ? std::nullopt : std::optional(m_source[next]);
 }
 
+// drops everything before the oldest byte still in use (the token being lexed, or one of
+// the cached tokens viewing the window) and appends the next chunk of input after the rest
+auto loxe::Lexer::refill() -> bool
+{
+    if (!m_stream) return false;
+
+    auto& window = m_stream->window;
+    auto  tokens = std::array{ &m_cache.previous, &m_cache.current, &m_cache.next };
+    auto  offset = std::array<std::size_t, 3>();
+
+    auto keep = m_start;
+    for (auto i = std::size_t{0}; i < tokens.size(); i++)
+    {
+        const auto lexeme = tokens[i]->lexeme;
+        const auto inside = !lexeme.empty() && lexeme.data() >= m_source.data() && lexeme.data() < end();
+        offset[i] = inside ? static_cast<std::size_t>(lexeme.data() - m_source.data()) : window.size();
+        if (inside) keep = std::min(keep, offset[i]);
+    }
+
+    window.erase(0, keep);
+    m_cursor          -= keep;
+    m_start           -= keep;
+    m_stream->dropped += keep;
+
+    const auto size = window.size();
+    if (m_stream->chunk == 0)
+    {
+        // straight from the buffer, which takes one call a character where the stream takes several
+        auto& buffer = *m_stream->input.rdbuf();
+        for (auto c = buffer.sbumpc(); c != std::char_traits<char>::eof(); c = buffer.sbumpc())
+        {
+            window.push_back(static_cast<char>(c));
+            if (c == '\n') break;
+        }
+    }
+    else
+    {
+        window.resize(size + m_stream->chunk);
+        m_stream->input.read(window.data() + size, static_cast<std::streamsize>(m_stream->chunk));
+        window.resize(size + static_cast<std::size_t>(m_stream->input.gcount()));
+    }
+
+    m_source = window;
+
+    // the window won't be around once an error needs a line number, so lines are noted now
+    const auto first = window.data() + size;
+    const auto last  = window.data() + window.size();
+    for (auto p = scan::find(first, last, '\n'); p != last; p = scan::find(p + 1, last, '\n'))
+        m_stream->file.lines.push_back(static_cast<std::uint32_t>(m_stream->dropped + static_cast<std::size_t>(p + 1 - window.data())));
+
+    for (auto i = std::size_t{0}; i < tokens.size(); i++)
+        if (offset[i] < size + keep)
+            tokens[i]->lexeme = { window.data() + offset[i] - keep, tokens[i]->lexeme.size() };
+
+    return window.size() > size;
+}
+
 auto loxe::Lexer::skip_whitespace() -> std::optional<char>
 {
     while (!at_end())
     {
-        switch (*peek0())
+        m_start = m_cursor;
+        if (is_blank(*here()))
         {
-            case ' ':
-            case '\r':
-            case '\t':
-            case '\n':
-                utility::ignore(advance());
-                break;
-           case '/':
-                if (auto c = peek1(); !c || (*c != '/' && *c != '*'))
-                    return peek0();
-                utility::ignore(skip_comment());
-                break;
-            default:
-                return peek0();
+            move_to(scan::skip_blanks(here(), end()));
+            continue;
         }
+
+        if (*here() != '/') break;
+        if (auto c = peek1(); !c || (*c != '/' && *c != '*')) break;
+        utility::ignore(skip_comment());
     }
 
     return peek0();
@@ -219,32 +477,61 @@ auto loxe::Lexer::skip_comment() -> std::optional<char>
 
     if (check('/', '/')) // single-line comment
     {
-        while (!at_end() && *peek0() != '\n') utility::ignore(advance());
+        do
+        {
+            move_to(scan::find(here(), end(), '\n'));
+            m_start = m_cursor;
+        } while (here() == end() && refill());
+
         utility::ignore(advance()); // '\n'
     }
     else if (check('/', '*')) // multi-line comment
     {
         utility::ignore(advance(), advance()); // /*
-        while (!check('*', '/')) utility::ignore(advance());
+        for (;;)
+        {
+            move_to(scan::find(here(), end(), '*'));
+            m_start = m_cursor;
+
+            if (here() == end())
+            {
+                if (refill()) continue;
+                break;
+            }
+
+            if (auto c = peek1(); !c || *c == '/') break;
+            utility::ignore(advance()); // *
+        }
+
         utility::ignore(advance(), advance()); // */
     }
 
     return peek0();
 }
 
-auto loxe::Lexer::advance() -> std::optional<char>
+auto loxe::Lexer::here() const -> const char*
 {
-    if (!at_end())
-    {
-        if (*peek0() == '\n')
-        {
-            m_line++;
-            m_column = 0;
-        }
+    return m_source.data() + m_cursor;
+}
 
-        m_column++;
-        m_cursor++;
-    }
+auto loxe::Lexer::end() const -> const char*
+{
+    return m_source.data() + m_source.size();
+}
 
+auto loxe::Lexer::move_to(const char* position) -> void
+{
+    m_cursor = static_cast<std::size_t>(position - m_source.data());
+}
+
+auto loxe::Lexer::position() const -> std::uint32_t
+{
+    const auto dropped = m_stream ? m_stream->dropped : 0;
+    return static_cast<std::uint32_t>(m_base + dropped + m_start);
+}
+
+auto loxe::Lexer::advance() -> std::optional<char>
+{
+    if (!at_end()) m_cursor++;
     return peek0();
 }
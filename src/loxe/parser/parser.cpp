@@ -1,35 +1,128 @@
-#include <fstream>
+#include <array>
+#include <span>
+#include <utility>
 
 #include "loxe/common/utility.hpp"
 #include "loxe/parser/parser.hpp"
 
-loxe::Parser::ParseError::ParseError(Token token, std::string message, std::string filename = {})
-    : token(std::move(token))
+auto loxe::Parser::parse(Source source, std::string filename) -> std::optional<ast::Program>
 {
-    static constexpr auto format_1 = "Error in {}:\n[{}, {}] ParseError: {} at end.\n";
-    static constexpr auto format_2 = "Error in {}:\n[{}, {}] ParseError: {} at '{}'.\n";
+    auto arena   = ast::Arena();
+    auto sources = SourceMap();
+    auto loader  = ImportLoader(sources, m_defer_imports);
+    m_arena      = &arena;
+    m_loader     = &loader;
+    m_unit       = &loader.root(std::move(filename));
+    use_source(arena.make<Source>(std::move(source))->text());
+    return parse_program(arena, sources, loader);
+}
+
+auto loxe::Parser::parse(std::istream& input, std::string filename) -> std::optional<ast::Program>
+{
+    auto arena   = ast::Arena();
+    auto sources = SourceMap();
+    auto loader  = ImportLoader(sources, m_defer_imports);
+    auto& stream = sources.add_stream();
+    m_lexer      = m_ready ? Lexer(input, stream, &arena, 0) : Lexer(input, stream, &arena);
+    m_buffered   = false;
+    m_loader     = &loader;
+    m_unit       = &loader.root(std::move(filename));
+    m_lexer.lex();
+    return parse_program(arena, sources, loader);
+}
+
+auto loxe::Parser::parse(std::istream& input, std::string filename, const ready_fn& ready) -> ast::Program
+{
+    m_ready = &ready;
+    auto program = parse(input, std::move(filename));
+    m_ready = nullptr;
+    return std::move(*program);
+}
+
+auto loxe::Parser::parse_program(ast::Arena& arena, SourceMap& sources, ImportLoader& loader) -> std::optional<ast::Program>
+{
+    m_arena = &arena;
+    m_error = false;
+
+    auto clean      = true;
+    auto statements = std::vector<ast::stmt_ptr>();
+    while (!at_end())
+    {
+        if (match(Token::Type::Semicolon)) continue;
+        statements.emplace_back(parse_dec_or_stmt());
+
+        if (!m_ready || !clean) continue;
+        clean = loader.flush(*m_unit);
+        if (!(*m_ready)(clean ? statements.back() : nullptr, sources)) break;
+    }
+
+    const auto finished = loader.finish(*m_unit, arena);
+    if (m_ready && clean && !finished) (*m_ready)(nullptr, sources);
+
+    m_arena  = nullptr;
+    m_loader = nullptr;
+    m_unit   = nullptr;
+    if (!(clean && finished) && !m_ready) return std::nullopt;
 
-    if (this->token.type == Token::Type::EndOfFile)
-        m_message = utility::as_string(format_1, filename, this->token.line, this->token.column, std::move(message));
-    else
-        m_message = utility::as_string(format_2, filename, this->token.line, this->token.column, std::move(message), this->token.lexeme);
+    auto program = arena.list(std::move(statements));
+    return ast::Program{ std::move(arena), std::move(sources), program, nullptr };
 }
 
-auto loxe::Parser::parse(std::string source, std::string filename) -> std::optional<ast::stmt_list>
+auto loxe::Parser::parse_import(ImportLoader& loader, ImportLoader::Unit& unit, std::string_view text) -> void
 {
-    m_error        = false;
-    m_lexer        = Lexer(std::move(source)).lex();
-    m_filename     = std::move(filename);
-    m_import_files = { m_filename };
+    m_arena  = &unit.arena;
+    m_loader = &loader;
+    m_unit   = &unit;
+    use_source(text);
 
-    auto ast = ast::stmt_list();
+    // imported files may only hold declarations
+    auto statements = std::vector<ast::stmt_ptr>();
     while (!at_end())
     {
         if (match(Token::Type::Semicolon)) continue;
-        ast.emplace_back(parse_dec_or_stmt());
+        statements.emplace_back(parse_declaration());
     }
 
-    return m_error ? std::nullopt : std::optional(std::move(ast));
+    unit.statements = m_arena->list(std::move(statements));
+}
+
+auto loxe::Parser::parse_body(ast::Program& program, const Span& body) -> ast::stmt_ptr
+{
+    auto unit = ImportLoader::Unit();
+    if (const auto file = program.sources.file(body.offset))
+        unit.path = file->path;
+
+    m_arena    = &program.arena;
+    m_unit     = &unit;
+    m_defer    = true;
+    m_lexer    = Lexer(body.lexeme, m_arena, body.offset);
+    m_tokens   = m_lexer.tokenize();
+    m_buffered = true;
+    m_index    = 0;
+
+    auto block = ast::stmt_ptr(nullptr);
+    try
+    {
+        consume(Token::Type::LeftBrace, "expect '{' before function body");
+        const auto nesting = nest();
+        block = parse_block_stmt();
+        if (!at_end()) throw error(current(), "expect end of function body");
+    }
+    catch (const ParseError& e)
+    {
+        unit.events.emplace_back(e);
+        m_too_deep = false;
+    }
+
+    m_arena = nullptr;
+    m_unit  = nullptr;
+    if (unit.events.empty()) return block;
+
+    auto errors = std::string();
+    for (const auto& event : unit.events)
+        errors += std::get<ParseError>(event).report(program.sources, unit.path);
+    errors.pop_back();
+    throw ExpandError(std::move(errors));
 }
 
 auto loxe::Parser::parse_dec_or_stmt() -> ast::stmt_ptr
@@ -46,7 +139,8 @@ auto loxe::Parser::parse_dec_or_stmt() -> ast::stmt_ptr
     }
     catch (const ParseError& e)
     {
-        utility::println(std::cerr, "{}", e.what());
+        if (m_too_deep && m_nesting > 0) throw;
+        m_unit->events.emplace_back(e);
         synchronize();
         return {};
     }
@@ -66,7 +160,8 @@ auto loxe::Parser::parse_declaration() -> ast::stmt_ptr
     }
     catch (const ParseError& e)
     {
-        utility::println(std::cerr, "{}", e.what());
+        if (m_too_deep && m_nesting > 0) throw;
+        m_unit->events.emplace_back(e);
         synchronize();
         return {};
     }
@@ -79,30 +174,30 @@ auto loxe::Parser::parse_class_dec() -> ast::stmt_ptr
     if (match(Token::Type::Less))
     {
         consume(Token::Type::Identifier, "expect superclass name");
-        superclass = ast::VariableExpr::make(previous());
+        superclass = make<ast::VariableExpr>(previous());
     }
 
     consume(Token::Type::LeftBrace, "expect '{' before class body");
 
-    auto methods = ast::method_list();
+    auto methods = std::vector<ast::fun_ptr>();
     while (!check(Token::Type::RightBrace) && !at_end())
     {
         auto method_name = consume(Token::Type::Identifier, "expect class method name");
-        auto method      = function("method");
+        auto method      = function("method", true);
         method->name = std::move(method_name);
-        methods.emplace_back(std::move(method));
+        methods.emplace_back(method);
     }
 
     consume(Token::Type::RightBrace, "expect '}' after class body");
-    return ast::ClassStmt::make(std::move(name), std::move(superclass), std::move(methods));
+    return make<ast::ClassStmt>(std::move(name), superclass, m_arena->list(std::move(methods)));
 }
 
 auto loxe::Parser::parse_fun_dec() -> ast::stmt_ptr
 {
     auto name = consume(Token::Type::Identifier, "expect function name");
-    auto fun  = function("function");
+    auto fun  = function("function", true);
     fun->name = std::move(name);
-    return ast::FunctionStmt::make(std::move(fun));
+    return make<ast::FunctionStmt>(fun);
 }
 
 auto loxe::Parser::parse_import_dec() -> ast::stmt_ptr
@@ -111,31 +206,10 @@ auto loxe::Parser::parse_import_dec() -> ast::stmt_ptr
     auto path    = consume(Token::Type::String, "expect filepath after 'import'");
     consume(Token::Type::Semicolon, "expect ';' after filepath");
 
-    if (m_import_files.contains(path.lexeme))
-        return ast::ImportStmt::make(std::move(path), ast::stmt_list());
-
-    m_import_files.insert(path.lexeme);
-
-    const auto loxe_file = std::ifstream(path.lexeme);
-    if (!loxe_file.is_open())
-        throw error(keyword, "failed to import file '" + path.lexeme + "'");
-
-    auto file_parser           = Parser();
-    file_parser.m_lexer        = Lexer(utility::as_string(loxe_file.rdbuf())).lex();
-    file_parser.m_import_files = m_import_files;
-    file_parser.m_filename     = path.lexeme;
-
-    auto body = ast::stmt_list();
-    while (!file_parser.at_end())
-    {
-        if (match(Token::Type::Semicolon)) continue;
-        body.emplace_back(file_parser.parse_declaration());
-    }
-
-    if (file_parser.m_error)
-        throw error(keyword, "encountered error while parsing file '" + path.lexeme + "'");
-
-    return ast::ImportStmt::make(std::move(path), std::move(body));
+    // the file is parsed elsewhere, and spliced in once everything is
+    auto import = make<ast::ImportStmt>(std::move(path), ast::stmt_list());
+    m_loader->request(*m_unit, keyword, *import);
+    return import;
 }
 
 auto loxe::Parser::parse_let_dec() -> ast::stmt_ptr
@@ -144,20 +218,21 @@ auto loxe::Parser::parse_let_dec() -> ast::stmt_ptr
     consume(Token::Type::Equal, "expect '=' after 'let' variable declaration");
     auto initializer = parse_expression();
     consume(Token::Type::Semicolon, "expect ';' after `let` initializer");
-    return ast::LetStmt::make(std::move(name), std::move(initializer));
+    return make<ast::LetStmt>(std::move(name), initializer);
 }
 
 auto loxe::Parser::parse_module_dec() -> ast::stmt_ptr
 {
+    const auto nesting = nest();
     auto name = consume(Token::Type::Identifier, "expect module name");
     consume(Token::Type::LeftBrace, "expect '{' before module body");
 
-    auto body = ast::stmt_list();
+    auto body = std::vector<ast::stmt_ptr>();
     while (!check(Token::Type::RightBrace) && !at_end())
         body.emplace_back(parse_declaration());
 
     consume(Token::Type::RightBrace, "expect '}' after module body");
-    return ast::ModuleStmt::make(std::move(name), std::move(body));
+    return make<ast::ModuleStmt>(std::move(name), m_arena->list(std::move(body)));
 }
 
 auto loxe::Parser::parse_var_dec()  -> ast::stmt_ptr
@@ -165,7 +240,7 @@ auto loxe::Parser::parse_var_dec()  -> ast::stmt_ptr
     auto name        = consume(Token::Type::Identifier, "expect variable name");
     auto initializer = match(Token::Type::Equal) ? parse_expression() : nullptr;
     consume(Token::Type::Semicolon, "expect ';' after variable declaration");
-    return ast::VariableStmt::make(std::move(name), std::move(initializer));
+    return make<ast::VariableStmt>(std::move(name), initializer);
 }
 
 auto loxe::Parser::parse_statement() -> ast::stmt_ptr
@@ -183,70 +258,71 @@ auto loxe::Parser::parse_statement() -> ast::stmt_ptr
 
 auto loxe::Parser::parse_block_stmt() -> ast::stmt_ptr
 {
-    auto statements = ast::stmt_list();
+    const auto nesting = nest();
+    auto statements = std::vector<ast::stmt_ptr>();
     while (!at_end() && !check(Token::Type::RightBrace))
         statements.emplace_back(parse_dec_or_stmt());
 
     consume(Token::Type::RightBrace, "expect '}' after block");
-    return ast::BlockStmt::make(std::move(statements));
+    return make<ast::BlockStmt>(m_arena->list(std::move(statements)));
 }
 
 auto loxe::Parser::parse_break_stmt() -> ast::stmt_ptr
 {
     auto keyword = previous();
     consume(Token::Type::Semicolon, "expect ';' after 'break'");
-    return ast::BreakStmt::make(std::move(keyword));
+    return make<ast::BreakStmt>(std::move(keyword));
 }
 
 auto loxe::Parser::parse_continue_stmt() -> ast::stmt_ptr
 {
     auto keyword = previous();
     consume(Token::Type::Semicolon, "expect ';' after 'continue'");
-    return ast::ContinueStmt::make(std::move(keyword));
+    return make<ast::ContinueStmt>(std::move(keyword));
 }
 
 auto loxe::Parser::parse_expr_stmt() -> ast::stmt_ptr
 {
     auto expr = parse_expression();
     consume(Token::Type::Semicolon, "expect ';' after expression statement");
-    return ast::ExpressionStmt::make(std::move(expr));
+    return make<ast::ExpressionStmt>(expr);
 }
 
 auto loxe::Parser::parse_for_stmt() -> ast::stmt_ptr
 {
+    const auto nesting = nest();
     consume(Token::Type::LeftParen, "expect '(' after 'for'");
     auto initializer = match(Token::Type::Semicolon) ? nullptr          :
                        match(Token::Type::Var)       ? parse_var_dec()  :
                                                        parse_expr_stmt();
 
-    auto condition = !check(Token::Type::Semicolon) ? parse_expression() : ast::BooleanExpr::make(true);
+    auto condition = !check(Token::Type::Semicolon) ? parse_expression() : make<ast::BooleanExpr>(true);
     consume(Token::Type::Semicolon, "expect ';' after 'for' condition");
     auto update  = !check(Token::Type::RightParen) ? parse_expression() : nullptr;
     consume(Token::Type::RightParen, "expect ')' after 'for' update clauses");
 
     auto body    = parse_statement();
-    auto loop    = ast::ForStmt::make(std::move(initializer), std::move(condition), std::move(update), std::move(body));
-    auto block = ast::stmt_list();
-    block.emplace_back(std::move(loop));
-
-    return ast::BlockStmt::make(std::move(block));
+    auto loop    = make<ast::ForStmt>(initializer, condition, update, body);
+    auto block   = std::vector<ast::stmt_ptr>{ loop };
+    return make<ast::BlockStmt>(m_arena->list(std::move(block)));
 }
 
 auto loxe::Parser::parse_if_stmt() -> ast::stmt_ptr
 {
+    const auto nesting = nest();
     consume(Token::Type::LeftParen, "expect '(' after 'if'");
     auto condition = parse_expression();
     consume(Token::Type::RightParen, "expect ')' after 'if' condition");
     auto then_branch = parse_statement();
     auto else_branch = match(Token::Type::Else) ? parse_statement() : nullptr;
-    return ast::IfStmt::make(std::move(condition), std::move(then_branch), std::move(else_branch));
+    return make<ast::IfStmt>(condition, then_branch, else_branch);
 }
 
 auto loxe::Parser::parse_print_stmt() -> ast::stmt_ptr
 {
     auto expr = parse_expression();
     consume(Token::Type::Semicolon, "expect ';' after print statement");
-    return ast::PrintStmt::make(std::move(expr));
+    return make<ast::PrintStmt>(expr);
 }
 
 auto loxe::Parser::parse_return_stmt() -> ast::stmt_ptr
@@ -254,339 +330,392 @@ auto loxe::Parser::parse_return_stmt() -> ast::stmt_ptr
     auto keyword = previous();
     auto value   = !check(Token::Type::Semicolon) ? parse_expression() : nullptr;
     consume(Token::Type::Semicolon, "expect ';' after return value");
-    return ast::ReturnStmt::make(std::move(keyword), std::move(value));
+    return make<ast::ReturnStmt>(std::move(keyword), value);
 }
 
 auto loxe::Parser::parse_while_stmt() -> ast::stmt_ptr
 {
+    const auto nesting = nest();
     consume(Token::Type::LeftParen, "expect '(' after 'while'");
     auto condition = parse_expression();
     consume(Token::Type::RightParen, "expect ')' after 'while' condition");
     auto body = parse_statement();
-    return ast::WhileStmt::make(std::move(condition), std::move(body));
+    return make<ast::WhileStmt>(condition, body);
 }
 
 auto loxe::Parser::parse_expression() -> ast::expr_ptr
 {
-    return parse_comma();
-}
+    // lambda bodies parse their expressions on top of whatever the enclosing one left on
+    // the stacks, and a failed one has to leave them as it found them
+    const auto bottom   = m_frames.size();
+    const auto operands = m_operands.size();
 
-auto loxe::Parser::parse_comma() -> ast::expr_ptr
-{
-    auto exprs = ast::expr_list();
-    do
+    try
     {
-        exprs.emplace_back(parse_conditional());
-    } while (match(Token::Type::Comma));
-
-    return exprs.size() == 1 ? std::move(exprs.front()) : ast::CommaExpr::make(std::move(exprs));
-}
-
-auto loxe::Parser::parse_conditional() -> ast::expr_ptr
-{
-    auto expr = parse_assignment();
-    if (match(Token::Type::Question))
+        m_frames.push_back({ Frame::Kind::Expression, Precedence::None, {}, nullptr, nullptr, operands });
+        auto expr = ast::expr_ptr(nullptr);
+        while (true)
+        {
+            while (!expr) expr = parse_prefix();
+            expr = parse_postfix(expr);
+            if (!expr) continue;
+
+            const auto precedence = infix_precedence(peek());
+            while (m_frames.back().floor > precedence)
+                expr = reduce(expr);
+
+            if (precedence != Precedence::None)
+            {
+                open_infix(expr);
+                expr = nullptr;
+            }
+            else if (m_frames.size() == bottom + 1 && !check(Token::Type::Comma))
+            {
+                m_operands.push_back(expr);
+                m_frames.pop_back();
+                return comma(operands);
+            }
+            else
+            {
+                expr = close(expr);
+            }
+        }
+    }
+    catch (const ParseError&)
     {
-        auto then_branch = parse_expression();
-        consume(Token::Type::Colon, "expect ':' after then branch of conditional expression");
-        auto else_branch = parse_conditional();
-        return ast::ConditionalExpr::make(std::move(expr), std::move(then_branch), std::move(else_branch));
+        m_frames.erase(m_frames.begin() + static_cast<std::ptrdiff_t>(bottom), m_frames.end());
+        m_operands.resize(operands);
+        throw;
     }
-
-    return expr;
 }
 
-auto loxe::Parser::parse_assignment() -> ast::expr_ptr
+auto loxe::Parser::parse_prefix() -> ast::expr_ptr
 {
-    auto expr = parse_logical_or();
-    if (match(Token::Type::Equal))
+    switch (peek())
     {
-        auto equals = previous();
-        auto value  = parse_assignment();
-        if (auto var = dynamic_cast<ast::VariableExpr*>(expr.get()))
-            return ast::AssignExpr::make(var->name, std::move(value));
-        else if (auto subscript = dynamic_cast<ast::SubscriptExpr*>(expr.get()))
-            return ast::SubscriptExpr::make(std::move(subscript->bracket), std::move(subscript->expression), std::move(subscript->index), std::move(value));
-        else if (auto get = dynamic_cast<ast::GetExpr*>(expr.get()))
-            return ast::SetExpr::make(std::move(get->name), std::move(get->object), std::move(value));
-
-        throw error(equals, "invalid assignment target");
-    }
+        case Token::Type::Nil:        return make<ast::NilExpr>(next());
+        case Token::Type::True:       return make<ast::BooleanExpr>(next());
+        case Token::Type::False:      return make<ast::BooleanExpr>(next());
+        case Token::Type::Number:     return make<ast::NumberExpr>(next());
+        case Token::Type::String:     return make<ast::StringExpr>(next());
+        case Token::Type::Identifier: return make<ast::VariableExpr>(next());
+        case Token::Type::This:       return make<ast::ThisExpr>(next());
+        case Token::Type::Lambda:     advance(); return parse_lambda();
+        case Token::Type::Super:      advance(); return parse_super();
+        case Token::Type::LeftBrace:  return open_initializer(next(), nullptr);
+
+        case Token::Type::LeftBracket:
+        {
+            auto start = next();
+            if (!match(Token::Type::Colon))
+                return make<ast::ArrayExpr>(std::move(start), nullptr, ast::expr_list());
 
-    return expr;
-}
+            m_frames.push_back({ Frame::Kind::ArraySize, Precedence::None, std::move(start), nullptr, nullptr, m_operands.size() });
+            return nullptr;
+        }
 
-auto loxe::Parser::parse_logical_or() -> ast::expr_ptr
-{
-    auto expr = parse_logical_and();
-    while (match(Token::Type::Or))
-    {
-        auto op  = previous();
-        auto rhs = parse_logical_and();
-        expr = ast::LogicalExpr::make(std::move(op), std::move(expr), std::move(rhs));
-    }
+        case Token::Type::LeftParen:
+            advance();
+            m_frames.push_back({ Frame::Kind::Grouping, Precedence::None, {}, nullptr, nullptr, m_operands.size() });
+            return nullptr;
+
+        case Token::Type::Bang:
+        case Token::Type::Minus:
+        case Token::Type::Plus:
+            m_frames.push_back({ Frame::Kind::Unary, Precedence::Unary, next() });
+            return nullptr;
+
+        // error productions: the right-hand operand is still parsed, at the operator's own
+        // precedence, before the missing left-hand one is reported
+        case Token::Type::BangEqual:
+        case Token::Type::EqualEqual:
+        case Token::Type::Greater:
+        case Token::Type::GreaterEqual:
+        case Token::Type::Less:
+        case Token::Type::LessEqual:
+        case Token::Type::Slash:
+        case Token::Type::Star:
+        {
+            const auto precedence = infix_precedence(peek());
+            m_frames.push_back({ Frame::Kind::Missing, precedence, next() });
+            return nullptr;
+        }
 
-    return expr;
+        default:
+            throw error(current(), "expect expression");
+    }
 }
 
-auto loxe::Parser::parse_logical_and() -> ast::expr_ptr
+auto loxe::Parser::parse_postfix(ast::expr_ptr expr) -> ast::expr_ptr
 {
-    auto expr = parse_equality();
-    while (match(Token::Type::And))
+    while (true)
     {
-        auto op  = previous();
-        auto rhs = parse_equality();
-        expr = ast::LogicalExpr::make(std::move(op), std::move(expr), std::move(rhs));
-    }
+        if (match(Token::Type::LeftParen))
+        {
+            if (!check(Token::Type::RightParen))
+            {
+                m_frames.push_back({ Frame::Kind::Call, Precedence::None, {}, expr, nullptr, m_operands.size() });
+                return nullptr;
+            }
 
-    return expr;
+            expr = make<ast::CallExpr>(next(), expr, ast::expr_list());
+        }
+        else if (match(Token::Type::Dot))
+        {
+            auto name = consume(Token::Type::Identifier, "expect property name after '.'");
+            expr = make<ast::GetExpr>(std::move(name), expr);
+        }
+        else if (check(Token::Type::LeftBracket))
+        {
+            m_frames.push_back({ Frame::Kind::Subscript, Precedence::None, next(), expr, nullptr, m_operands.size() });
+            return nullptr;
+        }
+        else
+        {
+            return expr;
+        }
+    }
 }
 
-auto loxe::Parser::parse_equality() -> ast::expr_ptr
+auto loxe::Parser::parse_lambda() -> ast::expr_ptr
 {
-    auto expr = parse_comparison();
-    while (match(Token::Type::BangEqual) || match(Token::Type::EqualEqual))
-    {
-        auto op  = previous();
-        auto rhs = parse_comparison();
-        expr = ast::BinaryExpr::make(std::move(op), std::move(expr), std::move(rhs));
-    }
-
-    return expr;
+    auto name    = previous();
+    auto lambda  = function("lambda");
+    lambda->name = std::move(name);
+    return lambda;
 }
 
-auto loxe::Parser::parse_comparison() -> ast::expr_ptr
+auto loxe::Parser::parse_super() -> ast::expr_ptr
 {
-    auto expr = parse_term();
-    while (match(Token::Type::Greater) || match(Token::Type::GreaterEqual) ||
-           match(Token::Type::Less)    || match(Token::Type::LessEqual))
-    {
-        auto op  = previous();
-        auto rhs = parse_term();
-        expr = ast::BinaryExpr::make(std::move(op), std::move(expr), std::move(rhs));
-    }
-
-    return expr;
+    auto keyword = previous();
+    consume(Token::Type::Dot, "expect '.' after 'super'");
+    auto method = consume(Token::Type::Identifier, "expect superclass method name");
+    return make<ast::SuperExpr>(std::move(keyword), std::move(method));
 }
 
-auto loxe::Parser::parse_term() -> ast::expr_ptr
+auto loxe::Parser::open_infix(ast::expr_ptr lhs) -> void
 {
-    auto expr = parse_factor();
-    while (match(Token::Type::Minus) || match(Token::Type::Plus))
-    {
-        auto op  = previous();
-        auto rhs = parse_factor();
-        expr = ast::BinaryExpr::make(std::move(op), std::move(expr), std::move(rhs));
-    }
+    const auto precedence = infix_precedence(peek());
+    auto op = next();
 
-    return expr;
+    if (op.type == Token::Type::Question)
+        m_frames.push_back({ Frame::Kind::Then, Precedence::None, std::move(op), lhs, nullptr, m_operands.size() });
+    else if (op.type == Token::Type::Equal) // right associative
+        m_frames.push_back({ Frame::Kind::Assign, precedence, std::move(op), lhs });
+    else // left associative, so only operators binding tighter extend the right-hand side
+        m_frames.push_back({ Frame::Kind::Binary, static_cast<Precedence>(static_cast<int>(precedence) + 1), std::move(op), lhs });
 }
 
-auto loxe::Parser::parse_factor() -> ast::expr_ptr
+auto loxe::Parser::open_initializer(Span start, ast::expr_ptr size) -> ast::expr_ptr
 {
-    auto expr = parse_unary();
-    while (match(Token::Type::Slash) || match(Token::Type::Star))
-    {
-        auto op  = previous();
-        auto rhs = parse_unary();
-        expr = ast::BinaryExpr::make(std::move(op), std::move(expr), std::move(rhs));
-    }
+    if (match(Token::Type::RightBrace))
+        return make<ast::ArrayExpr>(std::move(start), size, ast::expr_list());
 
-    return expr;
+    m_frames.push_back({ Frame::Kind::Initializer, Precedence::None, std::move(start), size, nullptr, m_operands.size() });
+    return nullptr;
 }
 
-auto loxe::Parser::parse_unary() -> ast::expr_ptr
+auto loxe::Parser::reduce(ast::expr_ptr expr) -> ast::expr_ptr
 {
-    while (match(Token::Type::Bang) || match(Token::Type::Minus) || match(Token::Type::Plus))
+    const auto frame = m_frames.back();
+    m_frames.pop_back();
+
+    switch (frame.kind)
     {
-        auto op      = previous();
-        auto operand = parse_unary();
-        return ast::UnaryExpr::make(std::move(op), std::move(operand));
-    }
+        case Frame::Kind::Binary:
+            if (frame.token.type == Token::Type::Or || frame.token.type == Token::Type::And)
+                return make<ast::LogicalExpr>(frame.token, frame.lhs, expr);
+            return make<ast::BinaryExpr>(frame.token, frame.lhs, expr);
 
-    return parse_call();
-}
+        case Frame::Kind::Unary:
+            return make<ast::UnaryExpr>(frame.token, expr);
 
-auto loxe::Parser::parse_call() -> ast::expr_ptr
-{
-    auto expr = parse_primary();
-    while (true)
-    {
-        if (match(Token::Type::LeftParen))
-        {
-            expr = finish_call(std::move(expr));
-        }
-        else if (match(Token::Type::Dot))
-        {
-            auto name = consume(Token::Type::Identifier, "expect property name after '.'");
-            expr = ast::GetExpr::make(std::move(name), std::move(expr));
-        }
-        else if (match(Token::Type::LeftBracket))
-        {
-            auto bracket = previous();
-            auto index   = parse_expression();
-            consume(Token::Type::RightBracket, "expect ']' after subscript arg");
-            expr = ast::SubscriptExpr::make(std::move(bracket), std::move(expr), std::move(index));
-        }
-        else
-        {
-            break;
-        }
-    }
+        case Frame::Kind::Else:
+            return make<ast::ConditionalExpr>(frame.lhs, frame.middle, expr);
+
+        case Frame::Kind::Assign:
+            if (auto var = dynamic_cast<ast::VariableExpr*>(frame.lhs))
+                return make<ast::AssignExpr>(var->name, expr);
+            else if (auto subscript = dynamic_cast<ast::SubscriptExpr*>(frame.lhs))
+                return make<ast::SubscriptExpr>(subscript->bracket, subscript->expression, subscript->index, expr);
+            else if (auto get = dynamic_cast<ast::GetExpr*>(frame.lhs))
+                return make<ast::SetExpr>(get->name, get->object, expr);
 
-    return expr;
+            throw error(frame.token, "invalid assignment target");
+
+        case Frame::Kind::Missing:
+            throw error(frame.token, "missing left-hand operand");
+
+        default: // the rest have no floor, so they are never reduced
+            return expr;
+    }
 }
 
-auto loxe::Parser::parse_primary() -> ast::expr_ptr
+auto loxe::Parser::close(ast::expr_ptr expr) -> ast::expr_ptr
 {
-    if (match(Token::Type::Nil))         return ast::NilExpr::make(previous());
-    if (match(Token::Type::True))        return ast::BooleanExpr::make(previous());
-    if (match(Token::Type::False))       return ast::BooleanExpr::make(previous());
-    if (match(Token::Type::Number))      return ast::NumberExpr::make(previous());
-    if (match(Token::Type::String))      return ast::StringExpr::make(previous());
-    if (match(Token::Type::Identifier))  return ast::VariableExpr::make(previous());
-    if (match(Token::Type::This))        return ast::ThisExpr::make(previous());
-    if (match(Token::Type::Lambda))      return parse_lambda();
-    if (match(Token::Type::Super))       return parse_super();
-    if (match(Token::Type::LeftBrace))   return parse_array();
-    if (match(Token::Type::LeftBracket)) return parse_array();
-    if (match(Token::Type::LeftParen))   return parse_grouping();
+    const auto frame = m_frames.back();
+    m_operands.push_back(expr);
 
-    // error productions
-    if (match(Token::Type::BangEqual) || match(Token::Type::EqualEqual))
+    if (frame.kind == Frame::Kind::Initializer)
     {
-        auto error_production = error(previous(), "missing left-hand operand");
-        utility::ignore(parse_equality());
-        throw error_production;
-    }
+        if (match(Token::Type::Comma) && !check(Token::Type::RightBrace)) return nullptr;
 
-    if (match(Token::Type::BangEqual) || match(Token::Type::EqualEqual))
-    {
-        auto error_production = error(previous(), "missing left-hand operand");
-        utility::ignore(parse_equality());
-        throw error_production;
+        consume(Token::Type::RightBrace, "expect '}' after initializer expression");
+        m_frames.pop_back();
+        return make<ast::ArrayExpr>(frame.token, frame.lhs, take(frame.base));
     }
 
-    if (match(Token::Type::Greater) || match(Token::Type::GreaterEqual) ||
-        match(Token::Type::Less) || match(Token::Type::LessEqual))
+    if (match(Token::Type::Comma)) return nullptr;
+
+    if (frame.kind == Frame::Kind::Call)
     {
-        auto error_production = error(previous(), "missing left-hand operand");
-        utility::ignore(parse_comparison());
-        throw error_production;
+        auto paren = consume(Token::Type::RightParen, "expect ')' after arguments");
+        m_frames.pop_back();
+        return make<ast::CallExpr>(std::move(paren), frame.lhs, take(frame.base));
     }
 
-    if (match(Token::Type::Slash) || match(Token::Type::Star))
+    const auto inner = comma(frame.base);
+    m_frames.pop_back();
+
+    switch (frame.kind)
     {
-        auto error_production = error(previous(), "missing left-hand operand");
-        utility::ignore(parse_factor());
-        throw error_production;
-    }
+        case Frame::Kind::Grouping:
+            consume(Token::Type::RightParen, "expect ')' after grouping expression");
+            return make<ast::GroupingExpr>(inner);
 
-    throw error(current(), "expect expression");
-}
+        case Frame::Kind::Subscript:
+            consume(Token::Type::RightBracket, "expect ']' after subscript arg");
+            return make<ast::SubscriptExpr>(frame.token, frame.lhs, inner);
 
-auto loxe::Parser::parse_lambda() -> ast::expr_ptr
-{
-    auto name    = previous();
-    auto lambda  = function("lambda");
-    lambda->name = std::move(name);
-    return lambda;
-}
+        case Frame::Kind::ArraySize:
+            consume(Token::Type::RightBracket, "expect ']' after subscript arg");
+            if (match(Token::Type::LeftBrace)) return open_initializer(frame.token, inner);
+            return make<ast::ArrayExpr>(frame.token, inner, ast::expr_list());
 
-auto loxe::Parser::parse_super() -> ast::expr_ptr
-{
-    auto keyword = previous();
-    consume(Token::Type::Dot, "expect '.' after 'super'");
-    auto method = consume(Token::Type::Identifier, "expect superclass method name");
-    return ast::SuperExpr::make(std::move(keyword), std::move(method));
+        case Frame::Kind::Then:
+            consume(Token::Type::Colon, "expect ':' after then branch of conditional expression");
+            m_frames.push_back({ Frame::Kind::Else, Precedence::Conditional, frame.token, frame.lhs, inner });
+            return nullptr;
+
+        default: // operators are reduced before anything gets closed
+            return inner;
+    }
 }
 
-auto loxe::Parser::parse_array() -> ast::expr_ptr
+auto loxe::Parser::infix_precedence(Token::Type type) -> Precedence
 {
-    auto start       = previous();
-    auto size        = ast::expr_ptr(nullptr);
-    auto initializer = ast::expr_list();
-
-    if (start.type == Token::Type::LeftBracket && match(Token::Type::Colon))
+    static constexpr auto table = []
     {
-        size = parse_expression();
-        consume(Token::Type::RightBracket, "expect ']' after subscript arg");
-        if (match(Token::Type::LeftBrace)) initializer = parse_initializer();
-    }
-    else if (start.type == Token::Type::LeftBrace)
+        auto result = std::array<Precedence, static_cast<std::size_t>(Token::Type::Unknown) + 1>();
+        auto at     = [&](Token::Type token) -> Precedence& { return result[static_cast<std::size_t>(token)]; };
+
+        at(Token::Type::Question)     = Precedence::Conditional;
+        at(Token::Type::Equal)        = Precedence::Assignment;
+        at(Token::Type::Or)           = Precedence::Or;
+        at(Token::Type::And)          = Precedence::And;
+        at(Token::Type::BangEqual)    = Precedence::Equality;
+        at(Token::Type::EqualEqual)   = Precedence::Equality;
+        at(Token::Type::Greater)      = Precedence::Comparison;
+        at(Token::Type::GreaterEqual) = Precedence::Comparison;
+        at(Token::Type::Less)         = Precedence::Comparison;
+        at(Token::Type::LessEqual)    = Precedence::Comparison;
+        at(Token::Type::Minus)        = Precedence::Term;
+        at(Token::Type::Plus)         = Precedence::Term;
+        at(Token::Type::Slash)        = Precedence::Factor;
+        at(Token::Type::Star)         = Precedence::Factor;
+        return result;
+    }();
+
+    return table[static_cast<std::size_t>(type)];
+}
+
+auto loxe::Parser::comma(std::size_t base) -> ast::expr_ptr
+{
+    if (m_operands.size() == base + 1)
     {
-        initializer = parse_initializer();
+        const auto expr = m_operands.back();
+        m_operands.pop_back();
+        return expr;
     }
 
-    return ast::ArrayExpr::make(std::move(start), std::move(size), std::move(initializer));
+    return make<ast::CommaExpr>(take(base));
 }
 
-auto loxe::Parser::parse_grouping() -> ast::expr_ptr
+auto loxe::Parser::take(std::size_t base) -> ast::expr_list
 {
-    auto expr = parse_expression();
-    consume(Token::Type::RightParen, "expect ')' after grouping expression");
-    return ast::GroupingExpr::make(std::move(expr));
+    const auto items = m_arena->list(std::span<const ast::expr_ptr>(m_operands).subspan(base));
+    m_operands.resize(base);
+    return items;
 }
 
-auto loxe::Parser::parse_initializer() -> ast::expr_list
+auto loxe::Parser::function(const std::string& kind, bool deferrable) -> ast::fun_ptr
 {
-    auto initializer = ast::expr_list();
-    if (!check(Token::Type::RightBrace))
+    static const auto implicit_name = Span(Token::Type::Implicit, Token::nowhere, "unnamed function");
+    consume(Token::Type::LeftParen, "expect '(' after " + kind + " name");
+    auto params = std::vector<Span>();
+
+    if (!check(Token::Type::RightParen))
     {
         do
         {
-            if (check(Token::Type::RightBrace)) break;
-            initializer.emplace_back(parse_conditional());
+            params.emplace_back(consume(Token::Type::Identifier, "expect paramater name"));
         } while (match(Token::Type::Comma));
     }
 
-    consume(Token::Type::RightBrace, "expect '}' after initializer expression");
-    return initializer;
-}
-
-auto loxe::Parser::finish_call(ast::expr_ptr callee) -> ast::expr_ptr
-{
-    auto args = ast::expr_list();
-    if (!check(Token::Type::RightParen))
+    consume(Token::Type::RightParen, "expect ')' after parameters");
+    consume(Token::Type::LeftBrace, "expect '{' before " + kind + " body");
+    const auto nesting = nest();
+    if (deferrable && m_defer && m_buffered)
     {
-        do
+        if (const auto body = skip_body())
         {
-            args.emplace_back(parse_conditional());
-        } while (match(Token::Type::Comma));
+            auto skipped = make<ast::FunctionExpr>(implicit_name, m_arena->list(std::move(params)), nullptr);
+            skipped->deferred = *body;
+            return skipped;
+        }
     }
 
-    auto paren = consume(Token::Type::RightParen, "expect ')' after arguments");
-    return ast::CallExpr::make(std::move(paren), std::move(callee), std::move(args));
+    auto body = parse_block_stmt();
+    return make<ast::FunctionExpr>(implicit_name, m_arena->list(std::move(params)), body);
 }
 
-auto loxe::Parser::function(const std::string& kind) -> ast::fun_ptr
+auto loxe::Parser::skip_body() -> std::optional<Span>
 {
-    static const auto implicit_name = Token(Token::Type::Implicit, -1, -1, "unnamed function");
-    consume(Token::Type::LeftParen, "expect '(' after " + kind + " name");
-    auto params = ast::param_list();
-
-    if (!check(Token::Type::RightParen))
+    // only token types are looked at, so nothing in the body is built or even decoded.
+    // imports have to be requested while the file is parsed, so bodies with one aren't skipped
+    const auto open  = m_index - 1;
+    auto       depth = 1;
+    for (; m_tokens.type(m_index) != Token::Type::EndOfFile; m_index++)
     {
-        do
+        const auto type = m_tokens.type(m_index);
+        if (type == Token::Type::Import) break;
+        if (type == Token::Type::LeftBrace) depth++;
+        if (type == Token::Type::RightBrace && --depth == 0)
         {
-            params.emplace_back(consume(Token::Type::Identifier, "expect paramater name"));
-        } while (match(Token::Type::Comma));
+            const auto first = m_tokens.token(open);
+            const auto last  = m_tokens.token(m_index++);
+            return Span(first.type, first.offset, { first.lexeme.data(), last.offset + 1 - first.offset });
+        }
     }
 
-    consume(Token::Type::RightParen, "expect ')' after parameters");
-    consume(Token::Type::LeftBrace, "expect '{' before " + kind + " body");
-    return ast::FunctionExpr::make(implicit_name, std::move(params), parse_block_stmt());
+    m_index = open + 1;
+    return std::nullopt;
+}
+
+auto loxe::Parser::peek() const -> Token::Type
+{
+    return m_buffered ? m_tokens.type(m_index) : m_lexer.peek_curr().type;
 }
 
 auto loxe::Parser::check(Token::Type type) const -> bool
 {
-    return m_lexer.peek_curr().type == type;
+    return peek() == type;
 }
 
 auto loxe::Parser::match(Token::Type type) -> bool
 {
     const auto matched = check(type);
-    if (matched) utility::ignore(next());
+    if (matched) advance();
     return matched;
 }
 
@@ -597,17 +726,27 @@ auto loxe::Parser::at_end() const -> bool
 
 auto loxe::Parser::current() const -> Token
 {
-    return m_lexer.peek_curr();
+    return m_buffered ? m_tokens.token(m_index) : m_lexer.peek_curr();
 }
 
 auto loxe::Parser::previous() const -> Token
 {
-    return m_lexer.peek_prev();
+    if (!m_buffered)   return m_lexer.peek_prev();
+    if (m_index == 0) return { Token::Type::Unknown };
+    return m_tokens.token(m_index - 1);
 }
 
 auto loxe::Parser::next() -> Token
 {
-    return m_lexer.lex().peek_prev();
+    advance();
+    return previous();
+}
+
+auto loxe::Parser::advance() -> void
+{
+    // like the lexer, stop on the end of file token
+    if      (!m_buffered)                                       m_lexer.lex();
+    else if (m_tokens.type(m_index) != Token::Type::EndOfFile) m_index++;
 }
 
 auto loxe::Parser::consume(Token::Type type, std::string msg) -> Token
@@ -616,15 +755,45 @@ auto loxe::Parser::consume(Token::Type type, std::string msg) -> Token
     throw error(current(), std::move(msg));
 }
 
-auto loxe::Parser::error(Token token, std::string msg) -> ParseError
+auto loxe::Parser::error(Span token, std::string msg) -> ParseError
 {
     m_error = true;
-    return ParseError(std::move(token), std::move(msg), m_filename);
+    return ParseError(token, std::move(msg));
+}
+
+auto loxe::Parser::use_source(std::string_view text) -> void
+{
+    // offsets in the buffer are 32 bits, anything bigger is lexed on the fly instead
+    m_lexer    = Lexer(text, m_arena, m_loader->add_source(text, m_unit->path));
+    m_buffered = text.size() <= TokenBuffer::max_source;
+    m_index    = 0;
+
+    if (m_buffered) m_tokens = m_lexer.tokenize();
+    else            m_lexer.lex();
+}
+
+auto loxe::Parser::nest() -> Nesting
+{
+    if (m_nesting == max_nesting)
+    {
+        m_too_deep = true;
+        throw error(previous(), utility::as_string("nests more than {} deep", max_nesting));
+    }
+
+    return Nesting(m_nesting);
 }
 
 auto loxe::Parser::synchronize() -> void
 {
-    utility::ignore(next());
+    // the statements around one nested too deep have all given up on it by now, and what
+    // follows can't be matched up with them
+    if (std::exchange(m_too_deep, false))
+    {
+        while (!at_end()) advance();
+        return;
+    }
+
+    advance();
     while (!at_end() && previous().type != Token::Type::Semicolon)
     {
         switch (current().type)
@@ -637,7 +806,7 @@ auto loxe::Parser::synchronize() -> void
             case Token::Type::While:
             case Token::Type::Print:
             case Token::Type::Return: return;
-            default: utility::ignore(next());
+            default: advance();
         }
     }
 }
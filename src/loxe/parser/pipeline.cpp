@@ -0,0 +1,87 @@
+#include <utility>
+
+#include "loxe/parser/parser.hpp"
+#include "loxe/parser/pipeline.hpp"
+
+loxe::Pipeline::Pipeline(std::istream& input, std::string filename)
+{
+    m_thread = std::jthread([this, &input, filename = std::move(filename)]() mutable { work(input, std::move(filename)); });
+}
+
+loxe::Pipeline::~Pipeline()
+{
+    stop();
+}
+
+auto loxe::Pipeline::next() -> ast::stmt_ptr
+{
+    // everything parsed so far is taken at once, so the lock is rarely fought over. waking
+    // up for every statement would cost more than running most of them, so the parsing
+    // thread only wakes this one for a whole batch and smaller ones are looked for now and then
+    if (m_taken.empty())
+    {
+        auto lock = std::unique_lock(m_mutex);
+        m_waiting = true;
+        while (!m_done && m_queue.empty())
+            m_wake.wait_for(lock, poll);
+
+        m_waiting = false;
+        std::swap(m_taken, m_queue);
+    }
+
+    if (m_taken.empty()) return nullptr;
+
+    const auto stmt = m_taken.front();
+    m_taken.pop_front();
+    return stmt;
+}
+
+auto loxe::Pipeline::stop() -> void
+{
+    {
+        auto lock = std::scoped_lock(m_mutex);
+        m_stop = true;
+    }
+
+    if (m_thread.joinable()) m_thread.join();
+}
+
+auto loxe::Pipeline::program() -> ast::Program&
+{
+    if (m_thread.joinable()) m_thread.join();
+    return *m_program;
+}
+
+auto loxe::Pipeline::state() -> State
+{
+    if (m_thread.joinable()) m_thread.join();
+    return m_state;
+}
+
+auto loxe::Pipeline::work(std::istream& input, std::string filename) -> void
+{
+    // after the first error nothing more is handed out, but the rest is still resolved
+    // to report its errors too
+    auto resolver = Resolver();
+    auto started  = false;
+    auto ready    = [&](ast::stmt_ptr stmt, const SourceMap& sources)
+    {
+        if (!std::exchange(started, true)) resolver.begin(sources);
+        const auto resolved = stmt && resolver.resolve_stmt(stmt) == Resolver::State::Ok;
+
+        auto lock = std::scoped_lock(m_mutex);
+        if      (!stmt)                 m_state = State::ParseError;
+        else if (!resolved)             m_state = State::ResolveError;
+        else if (m_state == State::Ok) m_queue.push_back(stmt);
+
+        if (m_waiting && m_queue.size() >= batch) m_wake.notify_one();
+        return !m_stop;
+    };
+
+    auto program = Parser().parse(input, std::move(filename), ready);
+
+    auto lock = std::scoped_lock(m_mutex);
+    m_program = std::move(program);
+    m_done    = true;
+    m_wake.notify_all();
+}
@@ -1,17 +1,86 @@
+#include <algorithm>
+
 #include "loxe/common/utility.hpp"
+#include "loxe/parser/parser.hpp"
 #include "loxe/parser/resolver.hpp"
 
-auto loxe::Resolver::resolve_ast(const ast::stmt_list& ast) -> State
+auto loxe::Resolver::resolve_ast(ast::Program& program) -> State
 {
+    // every top level declaration gets its slot in the global table up front,
+    // so functions can refer to globals that are declared after them
+    begin(program.sources);
+    hoist(program.statements);
+    resolve(program.statements);
+
+    // the globals stay in scope for the skipped bodies, which can still add to them
+    const auto state = m_state;
+    if (!m_deferred.empty())
+        program.resolver = program.arena.make<Resolver>(std::move(*this));
+
+    return state;
+}
+
+auto loxe::Resolver::begin(const SourceMap& sources) -> void
+{
+    m_sources  = &sources;
     m_loops    = 0;
     m_scopes   = {};
+    m_frozen   = {};
+    m_outer    = {};
+    m_deferred = {};
     m_state    = State::Ok;
     m_fun_type = FunType::None;
     m_cls_type = ClsType::None;
 
     begin_scope();
-    resolve(ast);
-    end_scope();
+}
+
+auto loxe::Resolver::resolve_stmt(ast::stmt_ptr stmt) -> State
+{
+    hoist(ast::stmt_list(&stmt, 1));
+    resolve(stmt);
+    return m_state;
+}
+
+auto loxe::Resolver::expand(ast::Program& program, const ast::FunctionExpr& function) -> State
+{
+    auto context = m_deferred.extract(&function);
+    if (context.empty()) return function.body ? State::Ok : State::Error;
+
+    // nodes are only ever const to the interpreters, the arena hands them out mutable
+    auto& target = const_cast<ast::FunctionExpr&>(function);
+    try
+    {
+        target.body = Parser().parse_body(program, function.deferred);
+    }
+    catch (const ExpandError&)
+    {
+        m_deferred.insert(std::move(context));
+        throw;
+    }
+
+    m_sources  = &program.sources;
+    m_state    = State::Ok;
+    m_assign   = false;
+    m_outer    = std::move(context.mapped().scopes);
+    m_cls_type = context.mapped().cls_type;
+    m_loops    = context.mapped().loops;
+    m_scopes.resize(1);
+    m_frozen.resize(1);
+
+    auto errors = std::string();
+    m_errors = &errors;
+    resolve_function(target, context.mapped().fun_type);
+    m_errors = nullptr;
+
+    context.mapped().scopes = std::exchange(m_outer, {});
+    if (m_state == State::Error)
+    {
+        target.body = nullptr;
+        m_deferred.insert(std::move(context));
+        errors.pop_back();
+        throw ExpandError(std::move(errors));
+    }
 
     return m_state;
 }
@@ -24,18 +93,34 @@ auto loxe::Resolver::resolve(const ast::stmt_list& stmts) -> void
 
 auto loxe::Resolver::resolve(const ast::stmt_ptr& stmt) -> void
 {
-    if (stmt) stmt->accept(*this);
+    if (!stmt) return;
+
+    m_deepest = std::max(m_deepest, ++m_nesting);
+    stmt->accept(*this);
+    m_nesting--;
 }
 
 auto loxe::Resolver::resolve(const ast::expr_ptr& expr) -> void
 {
-    if (expr) expr->accept(*this);
+    if (!expr) return;
+    if (m_nesting >= max_nesting)
+    {
+        // the rest of an expression that is too deep goes unreported, one error says it all
+        if (!m_too_deep) error(offset(*expr), utility::as_string("nests more than {} deep", max_nesting));
+        m_too_deep = true;
+        return;
+    }
+
+    m_deepest = std::max(m_deepest, ++m_nesting);
+    expr->accept(*this);
+    if (--m_nesting == 0) m_too_deep = false;
 }
 
 auto loxe::Resolver::visit(ast::BlockStmt& stmt) -> void
 {
     begin_scope();
     resolve(stmt.statements);
+    stmt.slots = m_scopes.back().size();
     end_scope();
 }
 
@@ -50,19 +135,20 @@ auto loxe::Resolver::visit(ast::ClassStmt& stmt) -> void
     const auto enclosing = m_cls_type;
     m_cls_type = ClsType::Class;
 
-    declare(stmt.name);
+    stmt.slot   = declare(stmt.name);
+    stmt.global = global_scope();
     define(stmt.name);
 
-    auto superclass = dynamic_cast<ast::VariableExpr*>(stmt.superclass.get());
+    auto superclass = dynamic_cast<ast::VariableExpr*>(stmt.superclass);
     if (superclass && superclass->name.lexeme == stmt.name.lexeme)
         error(superclass->name, "class can't inherit from itself");
 
     if (superclass)
     {
+        resolve(stmt.superclass);
         begin_scope();
         m_scopes.back()["super"] = true;
         m_cls_type = ClsType::SubClass;
-        resolve(stmt.superclass);
     }
 
     begin_scope();
@@ -71,7 +157,7 @@ auto loxe::Resolver::visit(ast::ClassStmt& stmt) -> void
     for (const auto& method : stmt.methods)
     {
         const auto fun_type = method->name.lexeme == "init" ? FunType::Initializer : FunType::Method;
-        resolve_function(*(method.get()), fun_type);
+        resolve_function(*method, fun_type);
     }
 
     end_scope();
@@ -103,9 +189,10 @@ auto loxe::Resolver::visit(ast::ForStmt& stmt) -> void
 
 auto loxe::Resolver::visit(ast::FunctionStmt& stmt) -> void
 {
-    declare(stmt.function->name);
+    stmt.slot   = declare(stmt.function->name);
+    stmt.global = global_scope();
     define(stmt.function->name);
-    resolve_function(*stmt.function.get(), FunType::Function);
+    resolve_function(*stmt.function, FunType::Function);
 }
 
 auto loxe::Resolver::visit(ast::IfStmt& stmt) -> void
@@ -122,7 +209,8 @@ auto loxe::Resolver::visit(ast::ImportStmt& stmt) -> void
 
 auto loxe::Resolver::visit(ast::LetStmt& stmt) -> void
 {
-    declare(stmt.name);
+    stmt.slot   = declare(stmt.name);
+    stmt.global = global_scope();
 
     if (stmt.initializer)
         resolve(stmt.initializer);
@@ -134,11 +222,19 @@ auto loxe::Resolver::visit(ast::LetStmt& stmt) -> void
 
 auto loxe::Resolver::visit(ast::ModuleStmt& stmt) -> void
 {
-    declare(stmt.name);
+    stmt.slot   = declare(stmt.name);
+    stmt.global = global_scope();
     define(stmt.name);
 
+    // members are hoisted so functions in the module can refer to members
+    // declared after them, and so the module can expose them by name
     begin_scope();
+    hoist(stmt.body);
     resolve(stmt.body);
+
+    stmt.slots = m_scopes.back().size();
+    for (const auto& [name, attribute] : m_scopes.back())
+        stmt.members[name] = attribute.slot;
     end_scope();
 }
 
@@ -160,7 +256,8 @@ auto loxe::Resolver::visit(ast::ReturnStmt& stmt) -> void
 
 auto loxe::Resolver::visit(ast::VariableStmt& stmt) -> void
 {
-    declare(stmt.name, true);
+    stmt.slot   = declare(stmt.name, true);
+    stmt.global = global_scope();
     if (stmt.initializer) resolve(stmt.initializer);
     define(stmt.name);
 }
@@ -228,6 +325,7 @@ auto loxe::Resolver::visit(ast::FunctionExpr& expr) -> void
 
 auto loxe::Resolver::visit(ast::GetExpr& expr) -> void
 {
+    expr.site = m_sites.properties++;
     resolve(expr.object);
 }
 
@@ -254,13 +352,14 @@ auto loxe::Resolver::visit(ast::NumberExpr& expr) -> void
 
 auto loxe::Resolver::visit(ast::SetExpr& expr) -> void
 {
+    expr.site = m_sites.properties++;
     resolve(expr.value);
     resolve(expr.object);
 }
 
 auto loxe::Resolver::visit(ast::StringExpr& expr) -> void
 {
-    utility::ignore(expr);
+    expr.site = m_sites.strings++;
 }
 
 auto loxe::Resolver::visit(ast::SubscriptExpr& expr) -> void
@@ -277,6 +376,7 @@ auto loxe::Resolver::visit(ast::SuperExpr& expr) -> void
     else if (m_cls_type != ClsType::SubClass)
         error(expr.keyword, "can't use 'super' in a class with no superclass");
 
+    expr.site = m_sites.supers++;
     resolve_local(expr, expr.keyword);
 }
 
@@ -297,11 +397,11 @@ auto loxe::Resolver::visit(ast::UnaryExpr& expr) -> void
 
 auto loxe::Resolver::visit(ast::VariableExpr& expr) -> void
 {
-    if (!m_scopes.empty() &&
-         m_scopes.back().contains(expr.name.lexeme) &&
-         m_scopes.back()[expr.name.lexeme].defined == false)
+    if (!m_scopes.empty())
     {
-        error(expr.name, "can't read local variable in its own initializer");
+        const auto it = m_scopes.back().find(expr.name.lexeme);
+        if (it != m_scopes.back().end() && it->second.defined == false)
+            error(expr.name, "can't read local variable in its own initializer");
     }
 
     resolve_local(expr, expr.name);
@@ -310,11 +410,13 @@ auto loxe::Resolver::visit(ast::VariableExpr& expr) -> void
 auto loxe::Resolver::begin_scope() -> void
 {
     m_scopes.push_back({});
+    m_frozen.push_back(nullptr);
 }
 
 auto loxe::Resolver::end_scope() -> void
 {
     m_scopes.pop_back();
+    m_frozen.pop_back();
 }
 
 auto loxe::Resolver::begin_loop() -> void
@@ -327,40 +429,100 @@ auto loxe::Resolver::end_loop() -> void
     m_loops--;
 }
 
-auto loxe::Resolver::declare(const Token &name, bool assignable) -> void
+auto loxe::Resolver::declare(const Span& name, bool assignable) -> std::size_t
 {
-    if (m_scopes.empty()) return;
-    if (m_scopes.back().contains(name.lexeme))
+    auto& scope = m_scopes.back();
+    auto  it    = scope.find(name.lexeme);
+    if (it != scope.end() && it->second.hoisted)
+        it->second = { false, assignable, it->second.slot };
+    else if (it != scope.end())
         error(name, "symbol already defined with this name in this scope");
+    else
+        it = scope.emplace(name.lexeme, Attribute(false, assignable, scope.size())).first;
+
+    return it->second.slot;
+}
 
-    m_scopes.back()[name.lexeme] = { false, assignable };
+auto loxe::Resolver::define(const Span& name) -> void
+{
+    if (auto it = m_scopes.back().find(name.lexeme); it != m_scopes.back().end())
+        it->second.defined = true;
 }
 
-auto loxe::Resolver::define(const Token &name) -> void
+auto loxe::Resolver::hoist(const ast::stmt_list& stmts) -> void
 {
-    if (m_scopes.empty()) return;
-    m_scopes.back()[name.lexeme].defined = true;
+    for (const auto& stmt : stmts)
+    {
+        if      (auto cls = dynamic_cast<ast::ClassStmt*>(stmt))    hoist(cls->name, false);
+        else if (auto fun = dynamic_cast<ast::FunctionStmt*>(stmt)) hoist(fun->function->name, false);
+        else if (auto let = dynamic_cast<ast::LetStmt*>(stmt))      hoist(let->name, false);
+        else if (auto mod = dynamic_cast<ast::ModuleStmt*>(stmt))   hoist(mod->name, false);
+        else if (auto var = dynamic_cast<ast::VariableStmt*>(stmt)) hoist(var->name, true);
+        else if (auto imp = dynamic_cast<ast::ImportStmt*>(stmt))   hoist(imp->body);
+    }
 }
 
-auto loxe::Resolver::resolve_local(ast::Expr& expr, const Token &name) -> void
+auto loxe::Resolver::hoist(const Span& name, bool assignable) -> void
 {
-    for (auto i = std::size_t{0}; i < m_scopes.size(); i++)
+    auto& scope = m_scopes.back();
+    if (scope.contains(name.lexeme)) return;
+
+    auto attribute    = Attribute(true, assignable, scope.size());
+    attribute.hoisted = true;
+    scope.emplace(name.lexeme, attribute);
+}
+
+auto loxe::Resolver::resolve_local(ast::Expr& expr, const Span& name) -> void
+{
+    // innermost first: the scopes being resolved, then those around the body being
+    // expanded (if any), and the globals last
+    const auto locals = m_scopes.size() - 1;
+    for (auto i = std::size_t{0}; i < locals + m_outer.size(); i++)
     {
-        if (m_scopes[m_scopes.size() - 1 - i].contains(name.lexeme))
+        const auto& scope = i < locals ? m_scopes[locals - i] : *m_outer[m_outer.size() - 1 - (i - locals)];
+        if (auto it = scope.find(name.lexeme); it != scope.end())
         {
-            if (m_assign && !m_scopes[m_scopes.size() - 1 - i][name.lexeme].assignable)
+            if (m_assign && !it->second.assignable)
                 error(name, "can't reassign this symbol in the current scope");
-            expr.depth = i;
-            break;
+            expr.depth = static_cast<std::uint32_t>(i);
+            expr.slot  = static_cast<std::uint32_t>(it->second.slot);
+            return;
         }
     }
+
+    auto& globals = m_scopes.front();
+    if (auto it = globals.find(name.lexeme); it != globals.end())
+    {
+        if (m_assign && !it->second.assignable)
+            error(name, "can't reassign this symbol in the current scope");
+        expr.slot = static_cast<std::uint32_t>(it->second.slot);
+        return;
+    }
+
+    // never declared: give it a global slot that stays undefined, so using it
+    // is reported at runtime like any other undefined global. it counts as hoisted,
+    // so a declaration resolved after it (one statement at a time) takes the slot over
+    expr.slot = static_cast<std::uint32_t>(globals.size());
+    auto attribute    = Attribute(true, true, expr.slot);
+    attribute.hoisted = true;
+    globals.emplace(name.lexeme, attribute);
+}
+
+auto loxe::Resolver::global_scope() const -> bool
+{
+    return m_scopes.size() == 1;
 }
 
 auto loxe::Resolver::resolve_function(ast::FunctionExpr& func, FunType type) -> void
 {
+    if (!func.body && !func.deferred.lexeme.empty())
+        return defer(func, type);
+
     const auto enclosing = m_fun_type;
+    const auto deepest   = std::exchange(m_deepest, m_nesting);
     m_fun_type = type;
 
+    // parameters and the body's top level locals share the call's environment
     begin_scope();
     for (const auto& param : func.params)
     {
@@ -368,15 +530,82 @@ auto loxe::Resolver::resolve_function(ast::FunctionExpr& func, FunType type) ->
         define(param);
     }
 
-    resolve(func.body);
+    if (auto body = dynamic_cast<ast::BlockStmt*>(func.body))
+        resolve(body->statements);
+    func.slots   = m_scopes.back().size();
+    func.nesting = m_deepest - m_nesting;
     end_scope();
 
     m_fun_type = enclosing;
+    m_deepest  = std::max(m_deepest, deepest);
 }
 
-auto loxe::Resolver::error(const Token& token, std::string message) -> void
+auto loxe::Resolver::defer(const ast::FunctionExpr& func, FunType type) -> void
+{
+    auto context = Context{ m_outer, type, m_cls_type, m_loops };
+    for (auto i = std::size_t{1}; i < m_scopes.size(); i++)
+    {
+        // scopes only ever grow, and a body never looks at what is added after it, so a
+        // copy of the same size is as good as a new one. entries can still change from
+        // hoisted to declared, which only matters to declarations in the scope itself
+        if (!m_frozen[i] || m_frozen[i]->size() != m_scopes[i].size())
+            m_frozen[i] = std::make_shared<const map>(m_scopes[i]);
+        context.scopes.push_back(m_frozen[i]);
+    }
+
+    m_deferred.insert_or_assign(&func, std::move(context));
+}
+
+auto loxe::Resolver::error(const Span& token, std::string message) -> void
 {
     static constexpr auto format = "[{}, {}] error resolving token '{}': {}.";
-    utility::println(std::cerr, format, token.line, token.column, token.lexeme, std::move(message));
+    const auto [line, column] = m_sources->position(token.offset);
+    report(utility::as_string(format, line, column, token.lexeme, std::move(message)));
+}
+
+auto loxe::Resolver::error(std::uint32_t offset, std::string message) -> void
+{
+    static constexpr auto format = "[{}, {}] error resolving expression: {}.";
+    const auto [line, column] = m_sources->position(offset);
+    report(utility::as_string(format, line, column, std::move(message)));
+}
+
+auto loxe::Resolver::report(std::string error) -> void
+{
+    if (m_errors)
+        m_errors->append(error).push_back('\n');
+    else
+        utility::println(std::cerr, "{}", error);
     m_state = State::Error;
 }
+
+auto loxe::Resolver::offset(const ast::Expr& expr) -> std::uint32_t
+{
+    // groupings, commas and conditionals have no token of their own, so where an
+    // expression is is where the first thing in it is
+    auto node = &expr;
+    while (true)
+    {
+        if      (auto e = dynamic_cast<const ast::GroupingExpr*>(node))    node = e->expression;
+        else if (auto e = dynamic_cast<const ast::CommaExpr*>(node))       node = e->expressions.front();
+        else if (auto e = dynamic_cast<const ast::ConditionalExpr*>(node)) node = e->condition;
+        else if (auto e = dynamic_cast<const ast::ArrayExpr*>(node))       return e->start.offset;
+        else if (auto e = dynamic_cast<const ast::AssignExpr*>(node))      return e->name.offset;
+        else if (auto e = dynamic_cast<const ast::BinaryExpr*>(node))      return e->op.offset;
+        else if (auto e = dynamic_cast<const ast::BooleanExpr*>(node))     return e->offset;
+        else if (auto e = dynamic_cast<const ast::CallExpr*>(node))        return e->paren.offset;
+        else if (auto e = dynamic_cast<const ast::FunctionExpr*>(node))    return e->name.offset;
+        else if (auto e = dynamic_cast<const ast::GetExpr*>(node))         return e->name.offset;
+        else if (auto e = dynamic_cast<const ast::LogicalExpr*>(node))     return e->op.offset;
+        else if (auto e = dynamic_cast<const ast::NilExpr*>(node))         return e->offset;
+        else if (auto e = dynamic_cast<const ast::NumberExpr*>(node))      return e->offset;
+        else if (auto e = dynamic_cast<const ast::SetExpr*>(node))         return e->name.offset;
+        else if (auto e = dynamic_cast<const ast::StringExpr*>(node))      return e->offset;
+        else if (auto e = dynamic_cast<const ast::SubscriptExpr*>(node))   return e->bracket.offset;
+        else if (auto e = dynamic_cast<const ast::SuperExpr*>(node))       return e->keyword.offset;
+        else if (auto e = dynamic_cast<const ast::ThisExpr*>(node))        return e->keyword.offset;
+        else if (auto e = dynamic_cast<const ast::UnaryExpr*>(node))       return e->op.offset;
+        else if (auto e = dynamic_cast<const ast::VariableExpr*>(node))    return e->name.offset;
+        else return Token::nowhere;
+    }
+}
@@ -0,0 +1,254 @@
+#include <bit>
+#include <cstdint>
+#include <algorithm>
+
+#include "loxe/parser/scan.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64)
+    #define LOXE_SCAN_SSE2 1
+    #include <emmintrin.h>
+    #if defined(__GNUC__)
+        #define LOXE_SCAN_AVX2 1
+        #include <immintrin.h>
+    #endif
+#endif
+
+namespace
+{
+    [[nodiscard]] constexpr auto is_blank(char c) -> bool
+    {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
+
+    [[nodiscard]] constexpr auto is_ident(char c) -> bool
+    {
+        return c == '_' || ('0' <= c && c <= '9') || ('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z');
+    }
+
+    [[nodiscard]] constexpr auto below(char c) -> char { return static_cast<char>(c - 1); }
+    [[nodiscard]] constexpr auto above(char c) -> char { return static_cast<char>(c + 1); }
+} // namespace
+
+namespace loxe::scan::scalar
+{
+    auto skip_blanks(const char* first, const char* last) -> const char*
+    {
+        return std::find_if_not(first, last, is_blank);
+    }
+
+    auto skip_ident(const char* first, const char* last) -> const char*
+    {
+        return std::find_if_not(first, last, is_ident);
+    }
+
+    auto find(const char* first, const char* last, char c) -> const char*
+    {
+        return std::find(first, last, c);
+    }
+} // namespace loxe::scan::scalar
+
+#if LOXE_SCAN_SSE2
+namespace loxe::scan::sse2
+{
+    constexpr auto width = std::ptrdiff_t{16};
+
+    [[nodiscard]] inline auto load(const char* p) -> __m128i
+    {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    }
+
+    [[nodiscard]] inline auto bits(__m128i mask) -> std::uint32_t
+    {
+        return static_cast<std::uint32_t>(_mm_movemask_epi8(mask));
+    }
+
+    [[nodiscard]] inline auto equal(__m128i v, char c) -> __m128i
+    {
+        return _mm_cmpeq_epi8(v, _mm_set1_epi8(c));
+    }
+
+    // signed compares, so bytes >= 0x80 never fall inside an ascii range
+    [[nodiscard]] inline auto in_range(__m128i v, char lo, char hi) -> __m128i
+    {
+        return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(below(lo))), _mm_cmpgt_epi8(_mm_set1_epi8(above(hi)), v));
+    }
+
+    auto skip_blanks(const char* first, const char* last) -> const char*
+    {
+        for (; last - first >= width; first += width)
+        {
+            const auto v     = load(first);
+            const auto blank = _mm_or_si128(_mm_or_si128(equal(v, ' '), equal(v, '\n')), _mm_or_si128(equal(v, '\t'), equal(v, '\r')));
+            if (const auto stop = ~bits(blank) & 0xFFFFu) return first + std::countr_zero(stop);
+        }
+
+        return scalar::skip_blanks(first, last);
+    }
+
+    auto skip_ident(const char* first, const char* last) -> const char*
+    {
+        for (; last - first >= width; first += width)
+        {
+            const auto v     = load(first);
+            const auto alpha = in_range(_mm_or_si128(v, _mm_set1_epi8(0x20)), 'a', 'z');
+            const auto ident = _mm_or_si128(_mm_or_si128(alpha, in_range(v, '0', '9')), equal(v, '_'));
+            if (const auto stop = ~bits(ident) & 0xFFFFu) return first + std::countr_zero(stop);
+        }
+
+        return scalar::skip_ident(first, last);
+    }
+
+    auto find(const char* first, const char* last, char c) -> const char*
+    {
+        for (; last - first >= width; first += width)
+            if (const auto hit = bits(equal(load(first), c))) return first + std::countr_zero(hit);
+
+        return scalar::find(first, last, c);
+    }
+} // namespace loxe::scan::sse2
+#endif
+
+#if LOXE_SCAN_AVX2
+#define LOXE_AVX2 __attribute__((target("avx2")))
+namespace loxe::scan::avx2
+{
+    constexpr auto width = std::ptrdiff_t{32};
+
+    [[nodiscard]] LOXE_AVX2 inline auto load(const char* p) -> __m256i
+    {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    }
+
+    [[nodiscard]] LOXE_AVX2 inline auto bits(__m256i mask) -> std::uint32_t
+    {
+        return static_cast<std::uint32_t>(_mm256_movemask_epi8(mask));
+    }
+
+    [[nodiscard]] LOXE_AVX2 inline auto equal(__m256i v, char c) -> __m256i
+    {
+        return _mm256_cmpeq_epi8(v, _mm256_set1_epi8(c));
+    }
+
+    [[nodiscard]] LOXE_AVX2 inline auto in_range(__m256i v, char lo, char hi) -> __m256i
+    {
+        return _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(below(lo))), _mm256_cmpgt_epi8(_mm256_set1_epi8(above(hi)), v));
+    }
+
+    LOXE_AVX2 auto skip_blanks(const char* first, const char* last) -> const char*
+    {
+        for (; last - first >= width; first += width)
+        {
+            const auto v     = load(first);
+            const auto blank = _mm256_or_si256(_mm256_or_si256(equal(v, ' '), equal(v, '\n')), _mm256_or_si256(equal(v, '\t'), equal(v, '\r')));
+            if (const auto stop = ~bits(blank)) return first + std::countr_zero(stop);
+        }
+
+        return sse2::skip_blanks(first, last);
+    }
+
+    LOXE_AVX2 auto skip_ident(const char* first, const char* last) -> const char*
+    {
+        for (; last - first >= width; first += width)
+        {
+            const auto v     = load(first);
+            const auto alpha = in_range(_mm256_or_si256(v, _mm256_set1_epi8(0x20)), 'a', 'z');
+            const auto ident = _mm256_or_si256(_mm256_or_si256(alpha, in_range(v, '0', '9')), equal(v, '_'));
+            if (const auto stop = ~bits(ident)) return first + std::countr_zero(stop);
+        }
+
+        return sse2::skip_ident(first, last);
+    }
+
+    LOXE_AVX2 auto find(const char* first, const char* last, char c) -> const char*
+    {
+        for (; last - first >= width; first += width)
+            if (const auto hit = bits(equal(load(first), c))) return first + std::countr_zero(hit);
+
+        return sse2::find(first, last, c);
+    }
+} // namespace loxe::scan::avx2
+#undef LOXE_AVX2
+#endif
+
+namespace
+{
+    namespace scan = loxe::scan;
+
+    enum class Isa : std::uint8_t
+    {
+        Scalar,
+        SSE2,
+        AVX2,
+    };
+
+    struct Backend
+    {
+        const char* (*skip_blanks)(const char*, const char*);
+        const char* (*skip_ident) (const char*, const char*);
+        const char* (*find)       (const char*, const char*, char);
+    };
+
+    [[nodiscard]] auto supported(Isa isa) -> bool
+    {
+        switch (isa)
+        {
+            case Isa::Scalar: return true;
+#if LOXE_SCAN_SSE2
+            case Isa::SSE2:   return true;
+#endif
+#if LOXE_SCAN_AVX2
+            case Isa::AVX2:
+                __builtin_cpu_init();
+                return __builtin_cpu_supports("avx2");
+#endif
+            default:          return false;
+        }
+    }
+
+    [[nodiscard]] auto backend(Isa isa) -> Backend
+    {
+        // fall back one level at a time until the cpu (or the build) supports it
+        while (!supported(isa)) isa = static_cast<Isa>(static_cast<int>(isa) - 1);
+        switch (isa)
+        {
+#if LOXE_SCAN_AVX2
+            case Isa::AVX2: return { scan::avx2::skip_blanks, scan::avx2::skip_ident, scan::avx2::find };
+#endif
+#if LOXE_SCAN_SSE2
+            case Isa::SSE2: return { scan::sse2::skip_blanks, scan::sse2::skip_ident, scan::sse2::find };
+#endif
+            default:        return { scan::scalar::skip_blanks, scan::scalar::skip_ident, scan::scalar::find };
+        }
+    }
+
+    constexpr auto prelude = std::ptrdiff_t{16};
+
+    const auto active = backend(Isa::AVX2);
+} // namespace
+
+// most runs in real code are only a few bytes long, so those are finished inline
+// and only what is left after `prelude` bytes goes through the vector backend
+
+auto loxe::scan::skip_blanks(const char* first, const char* last) -> const char*
+{
+    for (const auto stop = first + std::min(prelude, last - first); first != stop; ++first)
+        if (!is_blank(*first)) return first;
+
+    return active.skip_blanks(first, last);
+}
+
+auto loxe::scan::skip_ident(const char* first, const char* last) -> const char*
+{
+    for (const auto stop = first + std::min(prelude, last - first); first != stop; ++first)
+        if (!is_ident(*first)) return first;
+
+    return active.skip_ident(first, last);
+}
+
+auto loxe::scan::find(const char* first, const char* last, char c) -> const char*
+{
+    for (const auto stop = first + std::min(prelude, last - first); first != stop; ++first)
+        if (*first == c) return first;
+
+    return active.find(first, last, c);
+}
@@ -0,0 +1,110 @@
+#include <utility>
+
+#include "loxe/parser/source.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+    #define LOXE_SOURCE_MMAP 1
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#else
+    #include <fstream>
+    #include <sstream>
+#endif
+
+loxe::Source::Source(std::string text)
+    : m_buffer(std::move(text)) {}
+
+loxe::Source::Source(Source&& other) noexcept
+    : m_mapping(std::exchange(other.m_mapping, nullptr))
+    , m_size(std::exchange(other.m_size, 0))
+    , m_buffer(std::move(other.m_buffer)) {}
+
+loxe::Source::~Source()
+{
+    release();
+}
+
+auto loxe::Source::operator=(Source&& other) noexcept -> Source&
+{
+    if (this != &other)
+    {
+        release();
+        m_mapping = std::exchange(other.m_mapping, nullptr);
+        m_size    = std::exchange(other.m_size, 0);
+        m_buffer  = std::move(other.m_buffer);
+    }
+
+    return *this;
+}
+
+#if LOXE_SOURCE_MMAP
+auto loxe::Source::open(const std::string& path) -> std::optional<Source>
+{
+    const auto fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return std::nullopt;
+
+    auto source = Source();
+    struct stat info {};
+    if (::fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0)
+    {
+        const auto size    = static_cast<std::size_t>(info.st_size);
+        const auto mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping != MAP_FAILED)
+        {
+            ::madvise(mapping, size, MADV_SEQUENTIAL);
+            source.m_mapping = mapping;
+            source.m_size    = size;
+            ::close(fd);
+            return source;
+        }
+    }
+
+    // not mappable (pipe, tty, empty or special file): fall back to reading it in chunks
+    auto chunk = std::string(64 * 1024, '\0');
+    for (;;)
+    {
+        const auto count = ::read(fd, chunk.data(), chunk.size());
+        if (count < 0)
+        {
+            ::close(fd);
+            return std::nullopt;
+        }
+        if (count == 0) break;
+        source.m_buffer.append(chunk.data(), static_cast<std::size_t>(count));
+    }
+
+    ::close(fd);
+    return source;
+}
+
+auto loxe::Source::release() -> void
+{
+    if (m_mapping) ::munmap(m_mapping, m_size);
+    m_mapping = nullptr;
+    m_size    = 0;
+}
+#else
+auto loxe::Source::open(const std::string& path) -> std::optional<Source>
+{
+    auto file = std::ifstream(path, std::ios::binary);
+    if (!file.is_open()) return std::nullopt;
+
+    auto buffer = std::ostringstream();
+    buffer << file.rdbuf();
+    return Source(std::move(buffer).str());
+}
+
+auto loxe::Source::release() -> void
+{
+    m_mapping = nullptr;
+    m_size    = 0;
+}
+#endif
+
+auto loxe::Source::text() const -> std::string_view
+{
+    if (m_mapping) return { static_cast<const char*>(m_mapping), m_size };
+    return m_buffer;
+}
@@ -0,0 +1,65 @@
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+#include "loxe/parser/scan.hpp"
+#include "loxe/parser/source_map.hpp"
+#include "loxe/parser/token.hpp"
+
+auto loxe::SourceMap::add(std::string_view text, std::string path) -> const File&
+{
+    // one past the end too, which is where the file's end of file token sits
+    const auto base = m_next;
+    const auto free = std::size_t{std::numeric_limits<std::uint32_t>::max() - base};
+    m_next = base + static_cast<std::uint32_t>(std::min(text.size() + 1, free));
+
+    return m_files.emplace_back(File{ base, text, std::move(path), {} });
+}
+
+auto loxe::SourceMap::restore(std::uint32_t base, std::string_view text, std::string path) -> const File&
+{
+    const auto free = std::size_t{std::numeric_limits<std::uint32_t>::max() - base};
+    m_next = base + static_cast<std::uint32_t>(std::min(text.size() + 1, free));
+
+    return m_files.emplace_back(File{ base, text, std::move(path), {} });
+}
+
+auto loxe::SourceMap::add_stream() -> File&
+{
+    const auto base = m_next;
+    m_next = base + (std::numeric_limits<std::uint32_t>::max() - base) / 2;
+
+    return m_files.emplace_back(File{ base, {}, {}, { 0 } });
+}
+
+auto loxe::SourceMap::file(std::uint32_t offset) const -> const File*
+{
+    const auto next = std::ranges::upper_bound(m_files, offset, {}, &File::base);
+    if (offset == Token::nowhere || next == m_files.begin()) return nullptr;
+    return &*std::prev(next);
+}
+
+auto loxe::SourceMap::position(std::uint32_t offset) const -> std::pair<int, int>
+{
+    const auto entry = file(offset);
+    if (!entry) return { -1, -1 };
+
+    if (entry->lines.empty())
+    {
+        entry->lines.push_back(0);
+
+        const auto first = entry->text.data();
+        const auto last  = first + entry->text.size();
+        for (auto p = scan::find(first, last, '\n'); p != last; p = scan::find(p + 1, last, '\n'))
+            entry->lines.push_back(static_cast<std::uint32_t>(p + 1 - first));
+    }
+
+    const auto relative = offset - entry->base;
+    const auto line     = static_cast<std::size_t>(std::ranges::upper_bound(entry->lines, relative) - entry->lines.begin()) - 1;
+    return { static_cast<int>(line) + 1, static_cast<int>(relative - entry->lines[line]) + 1 };
+}
+
+auto loxe::SourceMap::files() const -> const std::deque<File>&
+{
+    return m_files;
+}
@@ -3,106 +3,140 @@
 #include "loxe/common/utility.hpp"
 #include "loxe/parser/token.hpp"
 
-auto loxe::Token::to_string() const -> std::string
+namespace
 {
-    static constexpr auto format = "[{:03d}] [{:5}, {:<3}] {:20} '{}'";
-    const auto type_int = static_cast<int>(type);
-    return utility::as_string(format, type_int, line, column, type_string(), lexeme);
-}
+    using Type = loxe::Token::Type;
 
-auto loxe::Token::type_string() const -> std::string
-{
-    static constexpr auto token_max = static_cast<int>(Type::Unknown);
-    static constexpr auto token_str = std::array
+    struct Spelling
+    {
+        Type             type;
+        std::string_view name;
+        std::string_view keyword = {};
+    };
+
+    // the single source for both type names and keywords, in enum order
+    constexpr auto spellings = std::array
     {
         // single-character tokens
-        "Type::Colon",
-        "Type::Comma",
-        "Type::Dot",
-        "Type::LeftBrace",
-        "Type::LeftBracket",
-        "Type::LeftParen",
-        "Type::Minus",
-        "Type::Plus",
-        "Type::Question",
-        "Type::RightBrace",
-        "Type::RightBracket",
-        "Type::RightParen",
-        "Type::Semicolon",
-        "Type::Slash",
-        "Type::Star",
+        Spelling{ Type::Colon,        "Type::Colon"        },
+        Spelling{ Type::Comma,        "Type::Comma"        },
+        Spelling{ Type::Dot,          "Type::Dot"          },
+        Spelling{ Type::LeftBrace,    "Type::LeftBrace"    },
+        Spelling{ Type::LeftBracket,  "Type::LeftBracket"  },
+        Spelling{ Type::LeftParen,    "Type::LeftParen"    },
+        Spelling{ Type::Minus,        "Type::Minus"        },
+        Spelling{ Type::Plus,         "Type::Plus"         },
+        Spelling{ Type::Question,     "Type::Question"     },
+        Spelling{ Type::RightBrace,   "Type::RightBrace"   },
+        Spelling{ Type::RightBracket, "Type::RightBracket" },
+        Spelling{ Type::RightParen,   "Type::RightParen"   },
+        Spelling{ Type::Semicolon,    "Type::Semicolon"    },
+        Spelling{ Type::Slash,        "Type::Slash"        },
+        Spelling{ Type::Star,         "Type::Star"         },
 
         // one or two character tokens
-        "Type::Bang",
-        "Type::BangEqual",
-        "Type::Equal",
-        "Type::EqualEqual",
-        "Type::Greater",
-        "Type::GreaterEqual",
-        "Type::Less",
-        "Type::LessEqual",
+        Spelling{ Type::Bang,         "Type::Bang"         },
+        Spelling{ Type::BangEqual,    "Type::BangEqual"    },
+        Spelling{ Type::Equal,        "Type::Equal"        },
+        Spelling{ Type::EqualEqual,   "Type::EqualEqual"   },
+        Spelling{ Type::Greater,      "Type::Greater"      },
+        Spelling{ Type::GreaterEqual, "Type::GreaterEqual" },
+        Spelling{ Type::Less,         "Type::Less"         },
+        Spelling{ Type::LessEqual,    "Type::LessEqual"    },
 
         // literals
-        "Type::Identifier",
-        "Type::Number",
-        "Type::String",
+        Spelling{ Type::Identifier,   "Type::Identifier"   },
+        Spelling{ Type::Number,       "Type::Number"       },
+        Spelling{ Type::String,       "Type::String"       },
 
         // keywords
-        "Type::And",
-        "Type::Break",
-        "Type::Class",
-        "Type::Else",
-        "Type::False",
-        "Type::For",
-        "Type::Fun",
-        "Type::If",
-        "Type::Import",
-        "Type::Lambda",
-        "Type::Let",
-        "Type::Module",
-        "Type::Nil",
-        "Type::Or",
-        "Type::Print",
-        "Type::Return",
-        "Type::Super",
-        "Type::This",
-        "Type::True",
-        "Type::Var",
-        "Type::While",
+        Spelling{ Type::And,          "Type::And",          "and"      },
+        Spelling{ Type::Break,        "Type::Break",        "break"    },
+        Spelling{ Type::Class,        "Type::Class",        "class"    },
+        Spelling{ Type::Continue,     "Type::Continue",     "continue" },
+        Spelling{ Type::Else,         "Type::Else",         "else"     },
+        Spelling{ Type::False,        "Type::False",        "false"    },
+        Spelling{ Type::For,          "Type::For",          "for"      },
+        Spelling{ Type::Fun,          "Type::Fun",          "fun"      },
+        Spelling{ Type::If,           "Type::If",           "if"       },
+        Spelling{ Type::Import,       "Type::Import",       "import"   },
+        Spelling{ Type::Lambda,       "Type::Lambda",       "lambda"   },
+        Spelling{ Type::Let,          "Type::Let",          "let"      },
+        Spelling{ Type::Module,       "Type::Module",       "module"   },
+        Spelling{ Type::Nil,          "Type::Nil",          "nil"      },
+        Spelling{ Type::Or,           "Type::Or",           "or"       },
+        Spelling{ Type::Print,        "Type::Print",        "print"    },
+        Spelling{ Type::Return,       "Type::Return",       "return"   },
+        Spelling{ Type::Super,        "Type::Super",        "super"    },
+        Spelling{ Type::This,         "Type::This",         "this"     },
+        Spelling{ Type::True,         "Type::True",         "true"     },
+        Spelling{ Type::Var,          "Type::Var",          "var"      },
+        Spelling{ Type::While,        "Type::While",        "while"    },
 
         // information
-        "Type::EndOfFile",
-        "Type::Implicit",
-        "Type::Unknown",
+        Spelling{ Type::EndOfFile,    "Type::EndOfFile"    },
+        Spelling{ Type::Implicit,     "Type::Implicit"     },
+        Spelling{ Type::Unknown,      "Type::Unknown"      },
     };
 
-    const auto index = static_cast<decltype(token_str)::size_type>(type);
-    return index < token_max ? token_str[index] : token_str.back();
+    static_assert(spellings.size() == static_cast<std::size_t>(Type::Unknown) + 1);
+    static_assert([]
+    {
+        for (auto i = std::size_t{0}; i < spellings.size(); i++)
+            if (static_cast<std::size_t>(spellings[i].type) != i) return false;
+        return true;
+    }(), "spellings must list every token type in enum order");
+
+    // keywords are told apart by length plus first and last character, so a
+    // lookup is one probe into this table and one string compare
+    constexpr auto keyword_slots = std::size_t{64};
+
+    [[nodiscard]] constexpr auto keyword_hash(std::string_view word) -> std::size_t
+    {
+        const auto first = static_cast<std::size_t>(static_cast<unsigned char>(word.front()));
+        const auto last  = static_cast<std::size_t>(static_cast<unsigned char>(word.back()));
+        return (5 * first + 3 * last + word.size()) & (keyword_slots - 1);
+    }
+
+    constexpr auto keywords = []
+    {
+        auto table = std::array<Type, keyword_slots>();
+        table.fill(Type::Identifier);
+        for (const auto& spelling : spellings)
+            if (!spelling.keyword.empty()) table[keyword_hash(spelling.keyword)] = spelling.type;
+        return table;
+    }();
+
+    [[nodiscard]] constexpr auto keyword_type(std::string_view identifier) -> Type
+    {
+        if (identifier.empty()) return Type::Identifier;
+
+        const auto type = keywords[keyword_hash(identifier)];
+        return spellings[static_cast<std::size_t>(type)].keyword == identifier ? type : Type::Identifier;
+    }
+
+    static_assert([]
+    {
+        for (const auto& spelling : spellings)
+            if (!spelling.keyword.empty() && keyword_type(spelling.keyword) != spelling.type) return false;
+        return true;
+    }(), "keyword_hash has a collision, pick other multipliers");
+} // namespace
+
+auto loxe::Token::to_string() const -> std::string
+{
+    static constexpr auto format = "[{:03d}] [{:10}] {:20} '{}'";
+    const auto type_int = static_cast<int>(type);
+    return utility::as_string(format, type_int, offset, type_string(), lexeme);
+}
+
+auto loxe::Token::type_string() const -> std::string
+{
+    const auto index = static_cast<std::size_t>(type);
+    return std::string(index < spellings.size() ? spellings[index].name : spellings.back().name);
 }
 
 auto loxe::Token::ident_type(std::string_view identifier) -> Type
 {
-    if (identifier == "and")      return Type::And;
-    if (identifier == "break")    return Type::Break;
-    if (identifier == "class")    return Type::Class;
-    if (identifier == "continue") return Type::Continue;
-    if (identifier == "else")     return Type::Else;
-    if (identifier == "false")    return Type::False;
-    if (identifier == "for")      return Type::For;
-    if (identifier == "fun")      return Type::Fun;
-    if (identifier == "if")       return Type::If;
-    if (identifier == "import")   return Type::Import;
-    if (identifier == "lambda")   return Type::Lambda;
-    if (identifier == "let")      return Type::Let;
-    if (identifier == "module")   return Type::Module;
-    if (identifier == "nil")      return Type::Nil;
-    if (identifier == "or")       return Type::Or;
-    if (identifier == "print")    return Type::Print;
-    if (identifier == "return")   return Type::Return;
-    if (identifier == "super")    return Type::Super;
-    if (identifier == "this")     return Type::This;
-    if (identifier == "true")     return Type::True;
-    if (identifier == "var")      return Type::Var;
-    if (identifier == "while")    return Type::While;
-    return Type::Identifier;
+    return keyword_type(identifier);
 }
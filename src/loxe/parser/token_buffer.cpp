@@ -0,0 +1,55 @@
+#include "loxe/parser/token_buffer.hpp"
+
+auto loxe::TokenBuffer::reserve(std::size_t count) -> void
+{
+    m_types.reserve(count);
+    m_offsets.reserve(count);
+    m_lengths.reserve(count);
+    m_numbers.entries.reserve(count / 4);
+}
+
+auto loxe::TokenBuffer::push(const Token& token) -> void
+{
+    const auto index = static_cast<std::uint32_t>(m_types.size());
+    const auto start = token.offset - m_base;
+
+    m_types.push_back(token.type);
+    m_offsets.push_back(start);
+    m_lengths.push_back(static_cast<std::uint32_t>(token.lexeme.size()));
+
+    if (token.type == Token::Type::Number)
+        m_numbers.entries.emplace_back(index, token.number);
+    else if (token.type == Token::Type::Unknown || (token.type == Token::Type::String && token.lexeme.data() != m_source.data() + start + 1))
+        m_texts.entries.emplace_back(index, token.lexeme);
+}
+
+auto loxe::TokenBuffer::size() const -> std::size_t
+{
+    return m_types.size();
+}
+
+auto loxe::TokenBuffer::type(std::size_t i) const -> Token::Type
+{
+    return m_types[i];
+}
+
+auto loxe::TokenBuffer::lexeme(std::size_t i) const -> std::string_view
+{
+    switch (m_types[i])
+    {
+        case Token::Type::Unknown:
+            return m_texts.get(i, {});
+        case Token::Type::EndOfFile:
+            return {};
+        case Token::Type::String: // the position is at the leading quote
+            return m_texts.get(i, m_source.substr(m_offsets[i] + 1, m_lengths[i]));
+        default:
+            return m_source.substr(m_offsets[i], m_lengths[i]);
+    }
+}
+
+auto loxe::TokenBuffer::token(std::size_t i) const -> Token
+{
+    const auto number = m_types[i] == Token::Type::Number ? m_numbers.get(i, 0.0) : 0.0;
+    return { m_types[i], m_base + m_offsets[i], lexeme(i), number };
+}
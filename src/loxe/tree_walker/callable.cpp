@@ -6,26 +6,21 @@
 
 auto loxe::tree_walker::FunctionObj::call(Interpreter& interpreter, args args) const -> Object
 {
-    static const auto implicit_this = Token(Token::Type::Implicit, -1, -1, "this");
-
     if (!m_declaration)
         throw Exception("can't call undefined function");
+    if (!m_declaration->body)
+        interpreter.expand(*m_declaration);
 
-    auto environment = std::make_shared<Environment>(m_closure.get());
+    const auto nesting = interpreter.nest(*m_declaration);
+    auto environment   = std::make_shared<Environment>(m_closure, m_declaration->slots);
     for (auto i = args::size_type{0}; i < m_declaration->params.size(); i++)
-        environment->define(m_declaration->params[i], std::move(args[i]));
-
-    try
-    {
-        auto body = dynamic_cast<ast::BlockStmt*>(m_declaration->body.get());
-        interpreter.execute(body->statements, environment);
-    }
-    catch (ReturnError& e)
-    {
-        return m_init ? m_closure->access_at(0, implicit_this) : std::move(e.value);
-    }
-
-    return m_init ? m_closure->access_at(0, implicit_this) : Object();
+        environment->define(i, std::move(args[i]));
+
+    auto body = dynamic_cast<const ast::BlockStmt*>(m_declaration->body);
+    if (interpreter.execute(body->statements, environment) == Completion::Return && !m_init)
+        return interpreter.return_value();
+
+    return m_init ? m_closure->access_at(0, 0) : Object();
 }
 
 auto loxe::tree_walker::FunctionObj::arity() const -> std::size_t
@@ -37,47 +32,62 @@ auto loxe::tree_walker::FunctionObj::arity() const -> std::size_t
 auto loxe::tree_walker::FunctionObj::to_string() const -> std::string
 {
     if (!m_declaration) return "<error: function does not have a declaration>";
-    return "<fn " + m_declaration->name.lexeme + ">";
+    return utility::as_string("<fn {}>", m_declaration->name.lexeme);
 }
 
 auto loxe::tree_walker::FunctionObj::bind(inst_ptr instance) -> Object
 {
-    static const auto implicit_this = Token(Token::Type::Implicit, -1, -1, "this");
-    auto environment = std::make_shared<Environment>(m_closure.get());
-    environment->define(implicit_this, { std::move(instance) });
-    return { std::make_shared<FunctionObj>(m_declaration, std::move(environment), m_init) };
+    auto environment = std::make_shared<Environment>(m_closure, 1);
+    environment->define(0, { std::move(instance) });
+    return { make_ref<FunctionObj>(m_declaration, std::move(environment), m_init) };
+}
+
+loxe::tree_walker::ClassObj::ClassObj(Span name, methods_type methods, fun_ptr init, const super_type& superclass)
+    : m_name(std::move(name)), m_init(std::move(init)), m_methods(std::move(methods))
+{
+    // ids tell classes apart in caches for as long as the program runs, unlike their addresses
+    static auto next_id = std::uint64_t{0};
+    m_id = ++next_id;
+
+    // methods the class defines itself are already in the table, and take precedence
+    if (superclass)
+        m_methods.insert(superclass->m_methods.begin(), superclass->m_methods.end());
+    if (superclass && !m_init)
+        m_init = superclass->m_init;
 }
 
 auto loxe::tree_walker::ClassObj::call(Interpreter& interpreter, args args) const -> Object
 {
-    auto instance = std::make_shared<InstanceObj>(*this);
-    if (auto init = m_methods.find("init"); init != m_methods.end())
-        init->second->bind(instance).as<Object::callable>()->call(interpreter, std::move(args));
+    auto instance = make_ref<InstanceObj>(Ref<const ClassObj>(this), interpreter.empty_shape());
+    if (m_init)
+        m_init->bind(instance).as<Object::callable>()->call(interpreter, std::move(args));
 
     return { instance };
 }
 
 auto loxe::tree_walker::ClassObj::arity() const -> std::size_t
 {
-    if (auto init = m_methods.find("init"); init != m_methods.end())
-        return init->second->arity();
+    if (m_init) return m_init->arity();
     return 0;
 }
 
 auto loxe::tree_walker::ClassObj::to_string() const -> std::string
 {
-    return "<class " + m_name.lexeme + ">";
+    return utility::as_string("<class {}>", m_name.lexeme);
+}
+
+auto loxe::tree_walker::ClassObj::id() const -> std::uint64_t
+{
+    return m_id;
 }
 
-auto loxe::tree_walker::ClassObj::name() const -> const std::string&
+auto loxe::tree_walker::ClassObj::name() const -> std::string_view
 {
     return m_name.lexeme;
 }
 
-auto loxe::tree_walker::ClassObj::find_method(const Token& name) const -> fun_ptr
+auto loxe::tree_walker::ClassObj::find_method(Symbols::id symbol) const -> FunctionObj*
 {
-    const auto& id = name.lexeme;
-    if (auto it = m_methods.find(id); it != m_methods.end()) return it->second;
-    if (m_superclass)                                        return m_superclass->find_method(name);
+    if (auto it = m_methods.find(symbol); it != m_methods.end()) return it->second.get();
     return nullptr;
 }
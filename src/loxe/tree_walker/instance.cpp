@@ -3,18 +3,35 @@
 
 auto loxe::tree_walker::InstanceObj::to_string() const -> std::string
 {
-    return "<" + m_class.name() + " instance>";
+    return utility::as_string("<{} instance>", m_class->name());
 }
 
-auto loxe::tree_walker::InstanceObj::get(const Token& name) -> Object
+auto loxe::tree_walker::InstanceObj::get(const Span& name, Symbols::id symbol, PropertyCache& cache) -> Object
 {
-    const auto& id = name.lexeme;
-    if (m_fields.contains(id))               return m_fields[id];
-    if (auto it = m_class.find_method(name)) return it->bind(shared_from_this());
-    throw RuntimeError(name, "undefined property '" + id + "'");
+    if (auto& entry = lookup(name, cache, false); entry.slot != Shape::absent) return m_slots[entry.slot];
+    if (auto it = m_class->find_method(symbol))                                return it->bind(Ref<InstanceObj>(this));
+    throw RuntimeError(name, utility::as_string("undefined property '{}'", name.lexeme));
 }
 
-auto loxe::tree_walker::InstanceObj::set(const Token& name, Object value) -> Object&
+auto loxe::tree_walker::InstanceObj::set(const Span& name, Object value, PropertyCache& cache) -> Object&
 {
-    return (m_fields[name.lexeme] = std::move(value));
+    auto& entry = lookup(name, cache, true);
+    if (!entry.target)
+        return (m_slots[entry.slot] = std::move(value));
+
+    m_shape = entry.target;
+    return m_slots.emplace_back(std::move(value));
+}
+
+auto loxe::tree_walker::InstanceObj::lookup(const Span& name, PropertyCache& cache, bool store) -> const PropertyCache::Entry&
+{
+    if (auto entry = cache.find(m_shape))
+        return *entry;
+
+    // a miss records where the field is. a store to a field the instance doesn't have yet
+    // records the shape that adds it instead, whose last slot it will take
+    auto slot = m_shape->find(name.lexeme);
+    if (slot == Shape::absent && store)
+        return cache.insert({ m_shape, m_shape->with(name.lexeme), m_shape->size() });
+    return cache.insert({ m_shape, nullptr, slot });
 }
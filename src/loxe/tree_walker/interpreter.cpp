@@ -1,4 +1,9 @@
+#include <utility>
+#include <functional>
+
 #include "loxe/common/utility.hpp"
+#include "loxe/parser/error.hpp"
+#include "loxe/parser/resolver.hpp"
 #include "loxe/tree_walker/error.hpp"
 #include "loxe/tree_walker/callable.hpp"
 #include "loxe/tree_walker/instance.hpp"
@@ -6,213 +11,280 @@
 #include "loxe/tree_walker/interpreter.hpp"
 
 loxe::tree_walker::Interpreter::Interpreter()
-    : m_global(std::make_shared<Environment>()), m_environment(m_global) {}
+    : m_globals({}), m_environment(nullptr) {}
+
+// the tree doesn't know what an `Object` is, so nodes are only evaluated from here
+template<typename Derived>
+auto loxe::ast::ExprCRTP<Derived>::accept(const_visitor<tree_walker::Object>& visitor) const -> tree_walker::Object
+{
+    return visitor.visit(*static_cast<const Derived*>(this));
+}
+
+template struct loxe::ast::ExprCRTP<loxe::ast::ArrayExpr>;
+template struct loxe::ast::ExprCRTP<loxe::ast::AssignExpr>;
+template struct loxe::ast::ExprCRTP<loxe::ast::BinaryExpr>;
+template struct loxe::ast::ExprCRTP<loxe::ast::BooleanExpr>;
+template struct loxe::ast::ExprCRTP<loxe::ast::CallExpr>;
+template struct loxe::ast::ExprCRTP<loxe::ast::CommaExpr>;
+template struct loxe::ast::ExprCRTP<loxe::ast::ConditionalExpr>;
+template struct loxe::ast::ExprCRTP<loxe::ast::FunctionExpr>;
+template struct loxe::ast::ExprCRTP<loxe::ast::GetExpr>;
+template struct loxe::ast::ExprCRTP<loxe::ast::GroupingExpr>;
+template struct loxe::ast::ExprCRTP<loxe::ast::LogicalExpr>;
+template struct loxe::ast::ExprCRTP<loxe::ast::NilExpr>;
+template struct loxe::ast::ExprCRTP<loxe::ast::NumberExpr>;
+template struct loxe::ast::ExprCRTP<loxe::ast::SetExpr>;
+template struct loxe::ast::ExprCRTP<loxe::ast::StringExpr>;
+template struct loxe::ast::ExprCRTP<loxe::ast::SubscriptExpr>;
+template struct loxe::ast::ExprCRTP<loxe::ast::SuperExpr>;
+template struct loxe::ast::ExprCRTP<loxe::ast::ThisExpr>;
+template struct loxe::ast::ExprCRTP<loxe::ast::UnaryExpr>;
+template struct loxe::ast::ExprCRTP<loxe::ast::VariableExpr>;
+
+auto loxe::tree_walker::Interpreter::interpret(ast::Program& program) -> void
+{
+    m_program = &program;
+    try
+    {
+        for (const auto& stmt : program.statements)
+            execute(stmt);
+    }
+    catch (const RuntimeError& e)
+    {
+        utility::println(std::cerr, "{}", e.report(program.sources));
+    }
+    catch (const ExpandError& e)
+    {
+        utility::println(std::cerr, "{}", e.report());
+    }
+}
 
-auto loxe::tree_walker::Interpreter::interpret(const ast::stmt_list& program) -> void
+auto loxe::tree_walker::Interpreter::interpret(Pipeline& pipeline) -> void
 {
     try
     {
-        for (const auto& stmt : program)
+        while (const auto stmt = pipeline.next())
             execute(stmt);
     }
     catch (const RuntimeError& e)
     {
-        utility::println(std::cerr, "{}", e.what());
+        // the parsing thread adds to the source map until it is done
+        pipeline.stop();
+        utility::println(std::cerr, "{}", e.report(pipeline.program().sources));
+    }
+    catch (const ExpandError& e)
+    {
+        pipeline.stop();
+        utility::println(std::cerr, "{}", e.report());
     }
 }
 
+auto loxe::tree_walker::Interpreter::expand(const ast::FunctionExpr& function) -> void
+{
+    const auto resolver = m_program ? m_program->resolver : nullptr;
+    if (!resolver || resolver->expand(*m_program, function) == Resolver::State::Error)
+        throw RuntimeError(function.name, "encountered error while parsing function body");
+}
+
 auto loxe::tree_walker::Interpreter::evaluate(const ast::expr_ptr& expr) -> Object
 {
-    return expr ? std::any_cast<Object>(expr->accept(*this)) : Object();
+    return expr ? expr->accept(*this) : Object();
 }
 
-auto loxe::tree_walker::Interpreter::execute(const ast::stmt_ptr& stmt) -> void
+auto loxe::tree_walker::Interpreter::execute(const ast::stmt_ptr& stmt) -> Completion
 {
-    if (stmt) stmt->accept(*this);
+    return stmt ? stmt->accept(*this) : Completion::Normal;
 }
 
-auto loxe::tree_walker::Interpreter::execute(const ast::stmt_list& stmts, env_ptr env) -> void
+auto loxe::tree_walker::Interpreter::execute(const ast::stmt_list& stmts, env_ptr env) -> Completion
 {
-    auto previous = std::move(m_environment);
+    auto previous   = std::move(m_environment);
+    auto completion = Completion::Normal;
     try
     {
         m_environment = std::move(env);
         for (const auto& stmt : stmts)
-            execute(stmt);
-
-        m_environment = std::move(previous);
-    }
-    catch (const BreakError& e)
-    {
-        m_environment = std::move(previous);
-        throw e;
-    }
-    catch (const ContinueError& e)
-    {
-        m_environment = std::move(previous);
-        throw e;
+            if ((completion = execute(stmt)) != Completion::Normal)
+                break;
     }
-    catch (ReturnError& e)
+    catch (...)
     {
         m_environment = std::move(previous);
-        throw e;
-    }
-    catch (const RuntimeError& e)
-    {
-        m_environment = std::move(previous);
-        throw e;
+        throw;
     }
+
+    m_environment = std::move(previous);
+    return completion;
 }
 
-auto loxe::tree_walker::Interpreter::visit(const ast::BlockStmt& stmt) -> void
+auto loxe::tree_walker::Interpreter::return_value() -> Object
 {
-    execute(stmt.statements, std::make_shared<Environment>(m_environment.get()));
+    return std::exchange(m_return_value, Object());
 }
 
-auto loxe::tree_walker::Interpreter::visit(const ast::BreakStmt& stmt) -> void
+auto loxe::tree_walker::Interpreter::nest(const ast::FunctionExpr& function) -> Nesting
 {
-    utility::ignore(stmt);
-    throw BreakError();
+    return Nesting(m_depth, function.nesting);
+}
+
+auto loxe::tree_walker::Interpreter::empty_shape() -> Shape*
+{
+    return &m_shapes;
+}
+
+auto loxe::tree_walker::Interpreter::intern(std::string_view string) -> Object
+{
+    if (auto it = m_strings.find(string); it != m_strings.end())
+        return Object{ it->second };
+
+    const auto hash   = std::hash<std::string_view>()(string);
+    const auto object = make_ref<Object::String>(std::string(string), hash);
+    m_strings.emplace(object->value(), object);
+    return Object{ object };
 }
 
-auto loxe::tree_walker::Interpreter::visit(const ast::ClassStmt& stmt) -> void
+auto loxe::tree_walker::Interpreter::visit(const ast::BlockStmt& stmt) -> Completion
 {
-    static const auto implicit_super = Token(Token::Type::Implicit, -1, -1, "super");
+    return execute(stmt.statements, std::make_shared<Environment>(m_environment, stmt.slots));
+}
 
+auto loxe::tree_walker::Interpreter::visit(const ast::BreakStmt& stmt) -> Completion
+{
+    utility::ignore(stmt);
+    return Completion::Break;
+}
+auto loxe::tree_walker::Interpreter::visit(const ast::ClassStmt& stmt) -> Completion
+{
     auto super = ClassObj::super_type(nullptr);
     if (stmt.superclass)
     {
         auto superclass  = evaluate(stmt.superclass);
         auto is_callable = superclass.is<Object::callable>();
         auto as_callable = is_callable ? superclass.as<Object::callable>() : nullptr;
-        super = std::dynamic_pointer_cast<ClassObj>(as_callable);
+        super = ClassObj::super_type(dynamic_cast<ClassObj*>(as_callable));
         if (!super)
         {
-            auto super_expr = dynamic_cast<ast::VariableExpr*>(stmt.superclass.get());
+            auto super_expr = dynamic_cast<ast::VariableExpr*>(stmt.superclass);
             throw RuntimeError(super_expr->name, "superclass must be a class");
         }
     }
 
     auto methods     = ClassObj::methods_type();
-    auto environment = std::make_shared<Environment>(m_environment.get());
-    if (super) environment->define(implicit_super, { super });
+    auto init        = ClassObj::fun_ptr(nullptr);
+    auto environment = m_environment;
+    if (super)
+    {
+        environment = std::make_shared<Environment>(m_environment, 1);
+        environment->define(0, { super });
+    }
 
     for (const auto& method : stmt.methods)
     {
-        auto dec  = method->make_clone();
-        auto init = method->name.lexeme == "init";
-        methods[method->name.lexeme] = std::make_shared<FunctionObj>(std::move(dec), environment, init);
+        auto is_init  = method->name.lexeme == "init";
+        auto function = make_ref<FunctionObj>(method, environment, is_init);
+        if (is_init) init = function;
+        methods[m_symbols.intern(method->name.lexeme)] = std::move(function);
     }
 
-    auto class_dec = std::make_shared<ClassObj>(stmt.name, std::move(methods), std::move(super));
-    m_environment->define(stmt.name, { std::move(class_dec) });
+    auto class_dec = make_ref<ClassObj>(stmt.name, std::move(methods), std::move(init), super);
+    define(stmt.slot, stmt.global, { std::move(class_dec) });
+    return Completion::Normal;
 }
 
-auto loxe::tree_walker::Interpreter::visit(const ast::ContinueStmt& stmt) -> void
+auto loxe::tree_walker::Interpreter::visit(const ast::ContinueStmt& stmt) -> Completion
 {
     utility::ignore(stmt);
-    throw ContinueError();
+    return Completion::Continue;
 }
 
-auto loxe::tree_walker::Interpreter::visit(const ast::ExpressionStmt& stmt) -> void
+auto loxe::tree_walker::Interpreter::visit(const ast::ExpressionStmt& stmt) -> Completion
 {
     evaluate(stmt.expression);
+    return Completion::Normal;
 }
 
-auto loxe::tree_walker::Interpreter::visit(const ast::ForStmt& stmt) -> void
+auto loxe::tree_walker::Interpreter::visit(const ast::ForStmt& stmt) -> Completion
 {
     for (execute(stmt.initializer); evaluate(stmt.condition).is_truthy(); evaluate(stmt.update))
     {
-        try
-        {
-            execute(stmt.body);
-        }
-        catch (const BreakError&)
-        {
+        if (auto completion = execute(stmt.body); completion == Completion::Break)
             break;
-        }
-        catch (const ContinueError&)
-        {
-            continue;
-        }
+        else if (completion == Completion::Return)
+            return completion;
     }
+
+    return Completion::Normal;
 }
 
-auto loxe::tree_walker::Interpreter::visit(const ast::FunctionStmt& stmt) -> void
+auto loxe::tree_walker::Interpreter::visit(const ast::FunctionStmt& stmt) -> Completion
 {
-    auto closure  = std::make_shared<Environment>(m_environment.get());
-    auto function = std::make_shared<FunctionObj>(stmt.function->make_clone(), std::move(closure));
-    m_environment->define(stmt.function->name, { std::move(function) });
+    auto function = make_ref<FunctionObj>(stmt.function, m_environment);
+    define(stmt.slot, stmt.global, { std::move(function) });
+    return Completion::Normal;
 }
 
-auto loxe::tree_walker::Interpreter::visit(const ast::IfStmt& stmt) -> void
+auto loxe::tree_walker::Interpreter::visit(const ast::IfStmt& stmt) -> Completion
 {
     if (evaluate(stmt.condition).is_truthy())
-        execute(stmt.then_branch);
-    else if (stmt.else_branch)
-        execute(stmt.else_branch);
+        return execute(stmt.then_branch);
+    return execute(stmt.else_branch);
 }
 
-auto loxe::tree_walker::Interpreter::visit(const ast::ImportStmt& stmt) -> void
+auto loxe::tree_walker::Interpreter::visit(const ast::ImportStmt& stmt) -> Completion
 {
     for (const auto& dec : stmt.body)
         execute(dec);
+    return Completion::Normal;
 }
 
-auto loxe::tree_walker::Interpreter::visit(const ast::LetStmt& stmt) -> void
+auto loxe::tree_walker::Interpreter::visit(const ast::LetStmt& stmt) -> Completion
 {
-    m_environment->define(stmt.name, evaluate(stmt.initializer));
+    define(stmt.slot, stmt.global, evaluate(stmt.initializer));
+    return Completion::Normal;
 }
 
-auto loxe::tree_walker::Interpreter::visit(const ast::ModuleStmt& stmt) -> void
+auto loxe::tree_walker::Interpreter::visit(const ast::ModuleStmt& stmt) -> Completion
 {
-    auto previous = std::move(m_environment);
-    m_environment = std::make_shared<Environment>(previous.get());
-
-    for (const auto& dec : stmt.body)
-        execute(dec);
+    auto module_env = std::make_shared<Environment>(m_environment, stmt.slots);
+    execute(stmt.body, module_env);
 
-    auto module_env = std::move(m_environment);
-    m_environment   = std::move(previous);
-    auto new_module = std::make_shared<Object::Module>(stmt.name.lexeme, std::move(module_env));
-    m_environment->define(stmt.name, { std::move(new_module) });
+    auto new_module = make_ref<Object::Module>(std::string(stmt.name.lexeme), std::move(module_env), stmt.members);
+    define(stmt.slot, stmt.global, { std::move(new_module) });
+    return Completion::Normal;
 }
 
-auto loxe::tree_walker::Interpreter::visit(const ast::PrintStmt& stmt) -> void
+auto loxe::tree_walker::Interpreter::visit(const ast::PrintStmt& stmt) -> Completion
 {
     utility::println("{}", evaluate(stmt.expression).stringify());
+    return Completion::Normal;
 }
 
-auto loxe::tree_walker::Interpreter::visit(const ast::ReturnStmt& stmt) -> void
+auto loxe::tree_walker::Interpreter::visit(const ast::ReturnStmt& stmt) -> Completion
 {
-    throw ReturnError(evaluate(stmt.value));
+    m_return_value = evaluate(stmt.value);
+    return Completion::Return;
 }
 
-auto loxe::tree_walker::Interpreter::visit(const ast::VariableStmt& stmt) -> void
+auto loxe::tree_walker::Interpreter::visit(const ast::VariableStmt& stmt) -> Completion
 {
-    m_environment->define(stmt.name, evaluate(stmt.initializer));
+    define(stmt.slot, stmt.global, evaluate(stmt.initializer));
+    return Completion::Normal;
 }
 
-auto loxe::tree_walker::Interpreter::visit(const ast::WhileStmt& stmt) -> void
+auto loxe::tree_walker::Interpreter::visit(const ast::WhileStmt& stmt) -> Completion
 {
     while (evaluate(stmt.condition).is_truthy())
     {
-        try
-        {
-            execute(stmt.body);
-        }
-        catch (const BreakError&)
-        {
+        if (auto completion = execute(stmt.body); completion == Completion::Break)
             break;
-        }
-        catch (const ContinueError&)
-        {
-            continue;
-        }
+        else if (completion == Completion::Return)
+            return completion;
     }
+
+    return Completion::Normal;
 }
 
-auto loxe::tree_walker::Interpreter::visit(const ast::ArrayExpr& expr) -> std::any
+auto loxe::tree_walker::Interpreter::visit(const ast::ArrayExpr& expr) -> Object
 {
     auto values = Object::Array::container();
     for (const auto& value : expr.initializer)
@@ -227,15 +299,15 @@ auto loxe::tree_walker::Interpreter::visit(const ast::ArrayExpr& expr) -> std::a
         if (values.size() < as_number) values.resize(as_number, Object());
     }
 
-    return Object{ std::make_shared<Object::Array>(std::move(values)) };
+    return Object{ make_ref<Object::Array>(std::move(values)) };
 }
 
-auto loxe::tree_walker::Interpreter::visit(const ast::AssignExpr& expr) -> std::any
+auto loxe::tree_walker::Interpreter::visit(const ast::AssignExpr& expr) -> Object
 {
-    return m_environment->assign_at(*expr.depth, expr.name, evaluate(expr.value));
+    return assign_var(expr.name, expr, evaluate(expr.value));
 }
 
-auto loxe::tree_walker::Interpreter::visit(const ast::BinaryExpr& expr) -> std::any
+auto loxe::tree_walker::Interpreter::visit(const ast::BinaryExpr& expr) -> Object
 {
     auto number = [&expr](const Object& object) -> Object::number {
         if (!object.is<Object::number>())
@@ -252,7 +324,7 @@ auto loxe::tree_walker::Interpreter::visit(const ast::BinaryExpr& expr) -> std::
         case Token::Type::EqualEqual: return Object{ lhs == rhs };
         case Token::Type::Plus:
             if (lhs.is<Object::string>() && rhs.is<Object::string>())
-                return Object{ lhs.as<Object::string>() + rhs.as<Object::string>() };
+                return Object{ Object::String::concat(*lhs.as<Object::string>(), *rhs.as<Object::string>()) };
             if (lhs.is<Object::number>() && rhs.is<Object::number>())
                 return Object{ lhs.as<Object::number>() + rhs.as<Object::number>() };
             throw RuntimeError(expr.op, "'+' operator requires two numbers or strings");
@@ -264,16 +336,16 @@ auto loxe::tree_walker::Interpreter::visit(const ast::BinaryExpr& expr) -> std::
         case Token::Type::GreaterEqual: return Object{ number(lhs) >= number(rhs) };
         case Token::Type::Less:         return Object{ number(lhs) <  number(rhs) };
         case Token::Type::LessEqual:    return Object{ number(lhs) <= number(rhs) };
-        default: throw RuntimeError(expr.op, "unrecognized binary operator: '" + expr.op.lexeme + "'");
+        default: throw RuntimeError(expr.op, utility::as_string("unrecognized binary operator: '{}'", expr.op.lexeme));
     }
 }
 
-auto loxe::tree_walker::Interpreter::visit(const ast::BooleanExpr& expr) -> std::any
+auto loxe::tree_walker::Interpreter::visit(const ast::BooleanExpr& expr) -> Object
 {
     return Object{ expr.value };
 }
 
-auto loxe::tree_walker::Interpreter::visit(const ast::CallExpr& expr) -> std::any
+auto loxe::tree_walker::Interpreter::visit(const ast::CallExpr& expr) -> Object
 {
     auto callee = evaluate(expr.callee);
     auto args   = Callable::args();
@@ -285,52 +357,57 @@ auto loxe::tree_walker::Interpreter::visit(const ast::CallExpr& expr) -> std::an
     if (!callee.is<Object::callable>())
         throw RuntimeError(expr.paren, "can only call functions and classes");
 
-    auto &callable = callee.as<Object::callable>();
+    if (m_depth > max_depth)
+        throw RuntimeError(expr.paren, "stack overflow");
+
+    auto callable = callee.as<Object::callable>();
     if (callable->arity() != args.size())
         throw RuntimeError(expr.paren, utility::as_string("expected {} args but got {}", callable-> arity(), args.size()));
 
     return callable->call(*this, std::move(args));
 }
 
-auto loxe::tree_walker::Interpreter::visit(const ast::CommaExpr& expr) -> std::any
+auto loxe::tree_walker::Interpreter::visit(const ast::CommaExpr& expr) -> Object
 {
-    for (auto it = expr.expressions.begin() + 1; it < expr.expressions.end(); it++)
+    for (auto it = expr.expressions.begin(); it + 1 < expr.expressions.end(); it++)
         evaluate(*it);
 
     return evaluate(expr.expressions.back());
 }
 
-auto loxe::tree_walker::Interpreter::visit(const ast::ConditionalExpr& expr) -> std::any
+auto loxe::tree_walker::Interpreter::visit(const ast::ConditionalExpr& expr) -> Object
 {
     auto condition = evaluate(expr.condition);
     return condition.is_truthy() ? evaluate(expr.then_branch) : evaluate(expr.else_branch);
 }
 
-auto loxe::tree_walker::Interpreter::visit(const ast::FunctionExpr& expr) -> std::any
+auto loxe::tree_walker::Interpreter::visit(const ast::FunctionExpr& expr) -> Object
 {
-    auto closure  = std::make_shared<Environment>(m_environment.get());
-    auto function = std::make_shared<FunctionObj>(expr.make_clone(), std::move(closure));
+    auto function = make_ref<FunctionObj>(&expr, m_environment);
     return Object{ std::move(function) };
 }
 
-auto loxe::tree_walker::Interpreter::visit(const ast::GetExpr& expr) -> std::any
+auto loxe::tree_walker::Interpreter::visit(const ast::GetExpr& expr) -> Object
 {
     if (auto value = evaluate(expr.object); value.is<Object::instance>())
-        return value.as<Object::instance>()->get(expr.name);
+    {
+        auto& entry = site(m_property_sites, expr.site);
+        return value.as<Object::instance>()->get(expr.name, symbol(expr.name, entry.symbol), entry.cache);
+    }
     else if (value.is<Object::array>() && expr.name.lexeme == "length")
         return Object{static_cast<Object::number>(value.as<Object::array>()->length())};
     else if (value.is<Object::module_>())
-        return value.as<Object::module_>()->env()->access(expr.name);
+        return value.as<Object::module_>()->access(expr.name);
 
     throw RuntimeError(expr.name, "only instance have properties");
 }
 
-auto loxe::tree_walker::Interpreter::visit(const ast::GroupingExpr& expr) -> std::any
+auto loxe::tree_walker::Interpreter::visit(const ast::GroupingExpr& expr) -> Object
 {
     return evaluate(expr.expression);
 }
 
-auto loxe::tree_walker::Interpreter::visit(const ast::LogicalExpr& expr) -> std::any
+auto loxe::tree_walker::Interpreter::visit(const ast::LogicalExpr& expr) -> Object
 {
     auto lhs = evaluate(expr.lhs);
     if (expr.op.type == Token::Type::Or  && lhs.is_truthy())  return lhs;
@@ -338,32 +415,35 @@ auto loxe::tree_walker::Interpreter::visit(const ast::LogicalExpr& expr) -> std:
     return evaluate(expr.rhs);
 }
 
-auto loxe::tree_walker::Interpreter::visit(const ast::NilExpr& expr) -> std::any
+auto loxe::tree_walker::Interpreter::visit(const ast::NilExpr& expr) -> Object
 {
     utility::ignore(expr);
     return Object{};
 }
 
-auto loxe::tree_walker::Interpreter::visit(const ast::NumberExpr& expr) -> std::any
+auto loxe::tree_walker::Interpreter::visit(const ast::NumberExpr& expr) -> Object
 {
     return Object{ expr.value };
 }
 
-auto loxe::tree_walker::Interpreter::visit(const ast::SetExpr& expr) -> std::any
+auto loxe::tree_walker::Interpreter::visit(const ast::SetExpr& expr) -> Object
 {
     if (auto object = evaluate(expr.object); object.is<Object::instance>())
-        return object.as<Object::instance>()->set(expr.name, evaluate(expr.value));
+        return object.as<Object::instance>()->set(expr.name, evaluate(expr.value), site(m_property_sites, expr.site).cache);
     else if (object.is<Object::module_>())
-        return object.as<Object::module_>()->env()->assign(expr.name, evaluate(expr.value));
+        return object.as<Object::module_>()->assign(expr.name, evaluate(expr.value));
     throw RuntimeError(expr.name, "only instances have properties");
 }
 
-auto loxe::tree_walker::Interpreter::visit(const ast::StringExpr& expr) -> std::any
+auto loxe::tree_walker::Interpreter::visit(const ast::StringExpr& expr) -> Object
 {
-    return Object{ expr.value };
+    // each literal is only looked up in `m_strings` the first time it runs
+    auto& literal = site(m_string_sites, expr.site);
+    if (literal.is<Object::nil>()) literal = intern(expr.value);
+    return literal;
 }
 
-auto loxe::tree_walker::Interpreter::visit(const ast::SubscriptExpr& expr) -> std::any
+auto loxe::tree_walker::Interpreter::visit(const ast::SubscriptExpr& expr) -> Object
 {
     auto object = evaluate(expr.expression);
     if (!object.is<Object::array>())
@@ -375,7 +455,7 @@ auto loxe::tree_walker::Interpreter::visit(const ast::SubscriptExpr& expr) -> st
         throw RuntimeError(expr.bracket, "subscript operator requires a number operator");
 
     auto index_value = index.as<Object::number>();
-    if (static_cast<std::size_t>(index_value) > array->length() || index_value < 0)
+    if (index_value < 0 || static_cast<std::size_t>(index_value) >= array->length())
         throw RuntimeError(expr.bracket, "index out of range for array");
 
     if (expr.new_value)
@@ -384,24 +464,27 @@ auto loxe::tree_walker::Interpreter::visit(const ast::SubscriptExpr& expr) -> st
     return array->access_at(index_value);
 }
 
-auto loxe::tree_walker::Interpreter::visit(const ast::SuperExpr& expr) -> std::any
+auto loxe::tree_walker::Interpreter::visit(const ast::SuperExpr& expr) -> Object
 {
-    auto distance   = *expr.depth;
-    auto superclass = m_environment->access_at(distance, expr.keyword);
-    auto object     = m_environment->access_at(distance - 1, expr.method);
-    auto as_class   = std::dynamic_pointer_cast<ClassObj>(superclass.as<Object::callable>());
+    // the class statement only ever puts a class in the scope `super` refers to
+    auto distance   = expr.depth;
+    auto superclass = static_cast<ClassObj*>(m_environment->access_at(distance, 0).as<Object::callable>());
+
+    auto& entry = site(m_super_sites, expr.site);
+    if (entry.cache.class_id != superclass->id())
+        entry.cache = { superclass->id(), superclass->find_method(symbol(expr.method, entry.symbol)) };
 
-    if (auto method = as_class->find_method(expr.method))
-        return method->bind(object.as<Object::instance>());
-    throw RuntimeError(expr.method, "undefined property '" + expr.method.lexeme + "'");
+    if (auto method = entry.cache.method)
+        return method->bind(Ref<InstanceObj>(m_environment->access_at(distance - 1, 0).as<Object::instance>()));
+    throw RuntimeError(expr.method, utility::as_string("undefined property '{}'", expr.method.lexeme));
 }
 
-auto loxe::tree_walker::Interpreter::visit(const ast::ThisExpr& expr) -> std::any
+auto loxe::tree_walker::Interpreter::visit(const ast::ThisExpr& expr) -> Object
 {
     return look_up_var(expr.keyword, expr);
 }
 
-auto loxe::tree_walker::Interpreter::visit(const ast::UnaryExpr& expr) -> std::any
+auto loxe::tree_walker::Interpreter::visit(const ast::UnaryExpr& expr) -> Object
 {
     switch (auto operand = evaluate(expr.operand); expr.op.type)
     {
@@ -420,12 +503,39 @@ auto loxe::tree_walker::Interpreter::visit(const ast::UnaryExpr& expr) -> std::a
     }
 }
 
-auto loxe::tree_walker::Interpreter::visit(const ast::VariableExpr& expr) -> std::any
+auto loxe::tree_walker::Interpreter::visit(const ast::VariableExpr& expr) -> Object
 {
     return look_up_var(expr.name, expr);
 }
 
-auto loxe::tree_walker::Interpreter::look_up_var(const Token& name, const ast::Expr& expr) -> const Object&
+auto loxe::tree_walker::Interpreter::define(std::size_t slot, bool global, Object value) -> void
+{
+    if (!global) return m_environment->define(slot, std::move(value));
+
+    if (slot >= m_globals.size()) m_globals.resize(slot + 1);
+    m_globals[slot] = std::move(value);
+}
+
+auto loxe::tree_walker::Interpreter::look_up_var(const Span& name, const ast::Expr& expr) -> const Object&
+{
+    if (expr.depth != ast::Expr::global) return m_environment->access_at(expr.depth, expr.slot);
+    return global(name, expr.slot);
+}
+
+auto loxe::tree_walker::Interpreter::assign_var(const Span& name, const ast::Expr& expr, Object value) -> const Object&
+{
+    if (expr.depth != ast::Expr::global) return m_environment->assign_at(expr.depth, expr.slot, std::move(value));
+    return (global(name, expr.slot) = std::move(value));
+}
+
+auto loxe::tree_walker::Interpreter::global(const Span& name, std::size_t slot) -> Object&
+{
+    if (slot < m_globals.size() && m_globals[slot]) return *m_globals[slot];
+    throw RuntimeError(name, utility::as_string("'{}' is an undefined symbol", name.lexeme));
+}
+
+auto loxe::tree_walker::Interpreter::symbol(const Span& name, Symbols::id& cached) -> Symbols::id
 {
-    return expr.depth ? m_environment->access_at(*expr.depth, name) : m_global->access(name);
+    if (cached == Symbols::unresolved) cached = m_symbols.intern(name.lexeme);
+    return cached;
 }
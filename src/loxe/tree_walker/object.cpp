@@ -1,3 +1,6 @@
+#include <functional>
+
+#include "loxe/tree_walker/error.hpp"
 #include "loxe/tree_walker/object.hpp"
 #include "loxe/tree_walker/callable.hpp"
 #include "loxe/tree_walker/instance.hpp"
@@ -12,26 +15,55 @@ auto loxe::tree_walker::Object::is_truthy() const -> bool
 
 auto loxe::tree_walker::Object::stringify() const -> std::string
 {
-    switch (m_value.index())
+    if (is<nil>())      return "nil";
+    if (is<boolean>())  return as<boolean>() ? "true" : "false";
+    if (is<string>())   return std::string(as<string>()->value());
+    if (is<callable>()) return as<callable>()->to_string();
+    if (is<instance>()) return as<instance>()->to_string();
+    if (is<array>())    return as<array>()->to_string();
+    if (is<module_>())  return as<module_>()->to_string();
+
+    auto string = std::to_string(as<number>());
+    while (string.back() == '0') string.pop_back();
+    if    (string.back() == '.') string.pop_back();
+    return string;
+}
+
+auto loxe::tree_walker::Object::String::concat(const String& lhs, const String& rhs) -> Ref<String>
+{
+    // interned buffers are never grown: the intern table keys on them. and a string can't be
+    // appended to the buffer it is itself a view of, as growing it may move the characters
+    auto& root = lhs.root();
+    if (!root.m_interned && root.m_buffer.size() == lhs.m_length && &rhs.root() != &root)
+    {
+        root.m_buffer.append(rhs.value());
+        return Ref<String>(new String(Ref<const String>(&root), root.m_buffer.size()));
+    }
+
+    auto buffer = std::string();
+    buffer.reserve(lhs.m_length + rhs.m_length);
+    buffer.append(lhs.value()).append(rhs.value());
+    return make_ref<String>(std::move(buffer));
+}
+
+auto loxe::tree_walker::Object::String::hash() const -> std::size_t
+{
+    if (!m_hashed)
     {
-        case 0: return "nil";
-        case 1: return as<boolean>() ? "true" : "false";
-        case 2:
-        {
-            auto string = std::to_string(as<number>());
-            while (string.back() == '0') string.pop_back();
-            if    (string.back() == '.') string.pop_back();
-            return string;
-        }
-        case 3: return as<string>();
-        case 4: return as<callable>()->to_string();
-        case 5: return as<instance>()->to_string();
-        case 6: return as<array>()->to_string();
-        case 7: return as<module_>()->to_string();
-        default: break;
+        m_hash   = std::hash<std::string_view>()(value());
+        m_hashed = true;
     }
 
-    return {};
+    return m_hash;
+}
+
+auto loxe::tree_walker::Object::String::equals(const String& other) const -> bool
+{
+    if (this == &other)                                       return true;
+    if (m_interned && other.m_interned)                       return false;
+    if (m_length != other.m_length)                           return false;
+    if (m_hashed && other.m_hashed && m_hash != other.m_hash) return false;
+    return value() == other.value();
 }
 
 auto loxe::tree_walker::Object::Array::length() const -> std::size_t
@@ -65,7 +97,19 @@ auto loxe::tree_walker::Object::Module::to_string() const -> std::string
     return "<module " + m_name + ">";
 }
 
-auto loxe::tree_walker::Object::Module::env() -> env_ptr&
+auto loxe::tree_walker::Object::Module::access(const Span& name) const -> const Object&
+{
+    return m_environment->access_at(0, slot(name));
+}
+
+auto loxe::tree_walker::Object::Module::assign(const Span& name, Object value) -> const Object&
+{
+    return m_environment->assign_at(0, slot(name), std::move(value));
+}
+
+auto loxe::tree_walker::Object::Module::slot(const Span& name) const -> std::size_t
 {
-    return m_environment;
+    if (auto it = m_members.find(name.lexeme); it != m_members.end())
+        return it->second;
+    throw RuntimeError(name, utility::as_string("'{}' is an undefined symbol", name.lexeme));
 }
@@ -0,0 +1,23 @@
+#include "loxe/tree_walker/shape.hpp"
+
+auto loxe::tree_walker::Shape::size() const -> std::uint32_t
+{
+    return static_cast<std::uint32_t>(m_slots.size());
+}
+
+auto loxe::tree_walker::Shape::find(std::string_view name) const -> std::uint32_t
+{
+    if (auto it = m_slots.find(name); it != m_slots.end()) return it->second;
+    return absent;
+}
+
+auto loxe::tree_walker::Shape::with(std::string_view name) -> Shape*
+{
+    if (auto it = m_transitions.find(name); it != m_transitions.end())
+        return it->second.get();
+
+    auto shape     = std::make_unique<Shape>();
+    shape->m_slots = m_slots;
+    shape->m_slots.emplace(name, size());
+    return m_transitions.emplace(name, std::move(shape)).first->second.get();
+}
@@ -1,24 +1,42 @@
-#include <fstream>
-
 #include "loxe/tree_walker/tree_walker.hpp"
 #include "loxe/tree_walker/interpreter.hpp"
 
 #include "loxe/common/utility.hpp"
+#include "loxe/parser/ast_cache.hpp"
 #include "loxe/parser/parser.hpp"
+#include "loxe/parser/pipeline.hpp"
 #include "loxe/parser/resolver.hpp"
 
 auto loxe::tree_walker::run_file(std::string filename) -> void
 {
-    auto file = std::ifstream(filename);
-    if (!file.is_open())
+    if (filename == "-")
+    {
+        // piped input starts running as soon as its first statement is in
+        auto pipeline = Pipeline(std::cin, "<stdin>");
+        Interpreter().interpret(pipeline);
+
+        if (pipeline.state() == Pipeline::State::ParseError)
+            return utility::println(std::cerr, "[tree_walker]: encountered parser error in file '{}'", filename);
+        if (pipeline.state() == Pipeline::State::ResolveError)
+            return utility::println(std::cerr, "[tree_walker]: encountered resolution error in file '{}'", filename);
+        return;
+    }
+
+    auto source = Source::open(filename);
+    if (!source)
         return utility::println(std::cerr, "[tree_walker]: failed to open file: '{}'", filename);
 
-    auto ast = Parser().parse(utility::as_string(file.rdbuf()), filename);
+    auto cache = AstCache(filename, source->text());
+    if (auto cached = cache.load())
+        return Interpreter().interpret(*cached);
+
+    auto ast = Parser(true).parse(std::move(*source), filename);
     if (!ast)
         return utility::println(std::cerr, "[tree_walker]: encountered parser error in file '{}'", filename);
 
     if (Resolver().resolve_ast(*ast) == Resolver::State::Error)
         return utility::println(std::cerr, "[tree_walker]: encountered resolution error in file '{}'", filename);
 
+    cache.store(*ast);
     Interpreter().interpret(*ast);
 }
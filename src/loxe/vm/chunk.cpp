@@ -0,0 +1,34 @@
+#include <algorithm>
+
+#include "loxe/vm/chunk.hpp"
+
+auto loxe::vm::Chunk::write(std::uint8_t byte, const Span& token) -> void
+{
+    if (m_last != &token)
+    {
+        m_tokens.emplace_back(code.size(), token);
+        m_last = &token;
+    }
+
+    code.push_back(byte);
+}
+
+auto loxe::vm::Chunk::write(OpCode op, const Span& token) -> void
+{
+    write(static_cast<std::uint8_t>(op), token);
+}
+
+auto loxe::vm::Chunk::add_constant(Value value) -> std::size_t
+{
+    constants.push_back(value);
+    return constants.size() - 1;
+}
+
+auto loxe::vm::Chunk::token_at(std::size_t offset) const -> const Span&
+{
+    static const auto unknown = Span();
+
+    auto after = [](std::size_t offset, const token_span& span) { return offset < span.first; };
+    auto it    = std::upper_bound(m_tokens.begin(), m_tokens.end(), offset, after);
+    return it == m_tokens.begin() ? unknown : std::prev(it)->second;
+}
@@ -0,0 +1,956 @@
+#include <bit>
+#include <limits>
+#include <vector>
+#include <utility>
+#include <algorithm>
+
+#include "loxe/common/utility.hpp"
+#include "loxe/parser/resolver.hpp"
+#include "loxe/vm/compiler.hpp"
+
+auto loxe::vm::Compiler::compile_ast(const ast::stmt_list& ast) -> FunctionObj*
+{
+    static const auto implicit_script = Span(Token::Type::Implicit, Token::nowhere, "script");
+
+    auto script = FunctionState();
+    script.function = m_heap.make<FunctionObj>(m_heap.intern(implicit_script.lexeme));
+    script.type     = FunType::Script;
+
+    m_function = &script;
+    m_token    = &implicit_script;
+    m_modules  = {};
+
+    add_local("", implicit_script);
+    compile(ast);
+    emit_return();
+    script.function->max_stack = stack_size(*script.function);
+
+    m_function = nullptr;
+    return script.function;
+}
+
+auto loxe::vm::Compiler::globals() const -> const names&
+{
+    return m_globals;
+}
+
+auto loxe::vm::Compiler::visit(const ast::BlockStmt& stmt) -> void
+{
+    begin_scope();
+    compile(stmt.statements);
+    end_scope();
+}
+
+auto loxe::vm::Compiler::visit(const ast::BreakStmt& stmt) -> void
+{
+    m_token = &stmt.keyword;
+    if (m_function->loops.empty())
+        throw error(stmt.keyword, "must be inside loop to use 'break'");
+
+    discard_locals(m_function->loops.back().locals);
+    m_function->loops.back().breaks.push_back(emit_jump(OpCode::Jump));
+}
+
+auto loxe::vm::Compiler::visit(const ast::ClassStmt& stmt) -> void
+{
+    m_token = &stmt.name;
+    const auto name     = identifier(stmt.name.lexeme);
+    const auto variable = declare(stmt.name);
+
+    emit_index(OpCode::Class, name);
+    define(variable);
+
+    const auto superclass = dynamic_cast<const ast::VariableExpr*>(stmt.superclass);
+    if (superclass)
+    {
+        get_variable(superclass->name.lexeme, superclass->name);
+        begin_scope();
+        add_local("super", stmt.name);
+        mark_initialized();
+
+        get_variable(stmt.name.lexeme, stmt.name);
+        m_token = &superclass->name;
+        emit(OpCode::Inherit);
+    }
+
+    get_variable(stmt.name.lexeme, stmt.name);
+    for (const auto& method : stmt.methods)
+    {
+        const auto type = method->name.lexeme == "init" ? FunType::Initializer : FunType::Method;
+        function(*method, type);
+        emit_index(OpCode::Method, identifier(method->name.lexeme));
+    }
+
+    emit(OpCode::Pop);
+    if (superclass) end_scope();
+}
+
+auto loxe::vm::Compiler::visit(const ast::ContinueStmt& stmt) -> void
+{
+    m_token = &stmt.keyword;
+    if (m_function->loops.empty())
+        throw error(stmt.keyword, "must be inside loop to use 'continue'");
+
+    auto& loop = m_function->loops.back();
+    discard_locals(loop.locals);
+
+    if (loop.is_for)
+        loop.continues.push_back(emit_jump(OpCode::Jump));
+    else
+        emit_loop(loop.start);
+}
+
+auto loxe::vm::Compiler::visit(const ast::ExpressionStmt& stmt) -> void
+{
+    compile(stmt.expression);
+    emit(OpCode::Pop);
+}
+
+auto loxe::vm::Compiler::visit(const ast::ForStmt& stmt) -> void
+{
+    compile(stmt.initializer);
+
+    const auto start = chunk().code.size();
+    compile(stmt.condition);
+    const auto exit = emit_jump(OpCode::JumpIfFalse);
+    emit(OpCode::Pop);
+
+    m_function->loops.push_back({ true, start, m_function->locals.size() });
+    compile(stmt.body);
+
+    for (const auto offset : m_function->loops.back().continues)
+        patch_jump(offset);
+
+    if (stmt.update)
+    {
+        compile(stmt.update);
+        emit(OpCode::Pop);
+    }
+
+    emit_loop(start);
+    patch_jump(exit);
+    emit(OpCode::Pop);
+
+    for (const auto offset : m_function->loops.back().breaks)
+        patch_jump(offset);
+    m_function->loops.pop_back();
+}
+
+auto loxe::vm::Compiler::visit(const ast::FunctionStmt& stmt) -> void
+{
+    const auto variable = declare(stmt.function->name);
+    if (variable.kind == Variable::Kind::Local) mark_initialized();
+
+    function(*stmt.function, FunType::Function);
+    define(variable);
+}
+
+auto loxe::vm::Compiler::visit(const ast::IfStmt& stmt) -> void
+{
+    compile(stmt.condition);
+    const auto then_jump = emit_jump(OpCode::JumpIfFalse);
+    emit(OpCode::Pop);
+    compile(stmt.then_branch);
+
+    const auto else_jump = emit_jump(OpCode::Jump);
+    patch_jump(then_jump);
+    emit(OpCode::Pop);
+    compile(stmt.else_branch);
+    patch_jump(else_jump);
+}
+
+auto loxe::vm::Compiler::visit(const ast::ImportStmt& stmt) -> void
+{
+    compile(stmt.body);
+}
+
+auto loxe::vm::Compiler::visit(const ast::LetStmt& stmt) -> void
+{
+    const auto variable = declare(stmt.name);
+    compile(stmt.initializer);
+    define(variable);
+}
+
+auto loxe::vm::Compiler::visit(const ast::ModuleStmt& stmt) -> void
+{
+    // the module is built in its own local when it is declared in a block, or in a hidden one
+    // otherwise. above that a scope holds one local per member, in the order the resolver
+    // numbered them, which the module captures like a closure would once its body has run
+    m_token = &stmt.name;
+    const auto variable = declare(stmt.name);
+    if (variable.kind != Variable::Kind::Local)
+        add_local("", stmt.name);
+    mark_initialized();
+    emit(OpCode::Nil);
+
+    const auto holder = static_cast<std::uint16_t>(m_function->locals.size() - 1);
+    const auto first  = m_function->locals.size();
+
+    auto names = std::vector<std::string_view>(stmt.members.size());
+    for (const auto& [name, slot] : stmt.members)
+        names[slot] = name;
+
+    begin_scope();
+    auto state = ModuleState{ m_function, m_function->scope_depth, {} };
+    for (const auto name : names)
+    {
+        add_local(name, stmt.name);
+        mark_initialized();
+        emit(OpCode::Nil);
+        state.members.emplace(name, static_cast<std::uint16_t>(m_function->locals.size() - 1));
+    }
+
+    m_modules.push_back(std::move(state));
+    compile(stmt.body);
+    m_modules.pop_back();
+
+    m_token = &stmt.name;
+    emit_index(OpCode::Module, identifier(stmt.name.lexeme));
+    emit_short(static_cast<std::uint16_t>(names.size()));
+    for (auto i = std::size_t{0}; i < names.size(); i++)
+    {
+        m_function->locals[first + i].captured = true;
+        emit_long(identifier(names[i]));
+        emit_short(static_cast<std::uint16_t>(first + i));
+    }
+
+    emit_slot(OpCode::SetLocal, holder);
+    emit(OpCode::Pop);
+    end_scope();
+
+    if (variable.kind != Variable::Kind::Local)
+    {
+        m_function->locals.pop_back();
+        define(variable);
+    }
+}
+
+auto loxe::vm::Compiler::visit(const ast::PrintStmt& stmt) -> void
+{
+    compile(stmt.expression);
+    emit(OpCode::Print);
+}
+
+auto loxe::vm::Compiler::visit(const ast::ReturnStmt& stmt) -> void
+{
+    m_token = &stmt.keyword;
+    if (!stmt.value) return emit_return();
+
+    compile(stmt.value);
+    m_token = &stmt.keyword;
+    emit(OpCode::Return);
+}
+
+auto loxe::vm::Compiler::visit(const ast::VariableStmt& stmt) -> void
+{
+    const auto variable = declare(stmt.name);
+    if (stmt.initializer)
+        compile(stmt.initializer);
+    else
+        emit(OpCode::Nil);
+    define(variable);
+}
+
+auto loxe::vm::Compiler::visit(const ast::WhileStmt& stmt) -> void
+{
+    const auto start = chunk().code.size();
+    compile(stmt.condition);
+    const auto exit = emit_jump(OpCode::JumpIfFalse);
+    emit(OpCode::Pop);
+
+    m_function->loops.push_back({ false, start, m_function->locals.size() });
+    compile(stmt.body);
+    emit_loop(start);
+
+    patch_jump(exit);
+    emit(OpCode::Pop);
+
+    for (const auto offset : m_function->loops.back().breaks)
+        patch_jump(offset);
+    m_function->loops.pop_back();
+}
+
+auto loxe::vm::Compiler::visit(const ast::ArrayExpr& expr) -> void
+{
+    for (const auto& value : expr.initializer)
+        compile(value);
+
+    m_token = &expr.start;
+    if (expr.initializer.size() > std::numeric_limits<std::uint32_t>::max())
+        throw error(expr.start, "too many values in array initializer");
+
+    const auto count = static_cast<std::uint32_t>(expr.initializer.size());
+    if (!expr.size) return emit_index(OpCode::Array, count);
+
+    compile(expr.size);
+    m_token = &expr.start;
+    emit_index(OpCode::SizedArray, count);
+}
+
+auto loxe::vm::Compiler::visit(const ast::AssignExpr& expr) -> void
+{
+    compile(expr.value);
+    set_variable(expr.name.lexeme, expr.name);
+}
+
+auto loxe::vm::Compiler::visit(const ast::BinaryExpr& expr) -> void
+{
+    compile(expr.lhs);
+    compile(expr.rhs);
+
+    m_token = &expr.op;
+    switch (expr.op.type)
+    {
+        case Token::Type::BangEqual:    return emit(OpCode::NotEqual);
+        case Token::Type::EqualEqual:   return emit(OpCode::Equal);
+        case Token::Type::Plus:         return emit(OpCode::Add);
+        case Token::Type::Minus:        return emit(OpCode::Subtract);
+        case Token::Type::Star:         return emit(OpCode::Multiply);
+        case Token::Type::Slash:        return emit(OpCode::Divide);
+        case Token::Type::Greater:      return emit(OpCode::Greater);
+        case Token::Type::GreaterEqual: return emit(OpCode::GreaterEqual);
+        case Token::Type::Less:         return emit(OpCode::Less);
+        case Token::Type::LessEqual:    return emit(OpCode::LessEqual);
+        default: throw error(expr.op, utility::as_string("unrecognized binary operator: '{}'", expr.op.lexeme));
+    }
+}
+
+auto loxe::vm::Compiler::visit(const ast::BooleanExpr& expr) -> void
+{
+    emit(expr.value ? OpCode::True : OpCode::False);
+}
+
+auto loxe::vm::Compiler::visit(const ast::CallExpr& expr) -> void
+{
+    if (expr.args.size() > std::numeric_limits<std::uint8_t>::max())
+        throw error(expr.paren, "can't have more than 255 arguments");
+
+    const auto argc = static_cast<std::uint8_t>(expr.args.size());
+
+    if (const auto get = dynamic_cast<const ast::GetExpr*>(expr.callee))
+    {
+        compile(get->object);
+        for (const auto& arg : expr.args)
+            compile(arg);
+
+        m_token = &get->name;
+        emit_index(OpCode::Invoke, identifier(get->name.lexeme));
+        m_token = &expr.paren;
+        return emit(argc);
+    }
+
+    if (const auto super = dynamic_cast<const ast::SuperExpr*>(expr.callee))
+    {
+        get_variable("this", super->keyword);
+        for (const auto& arg : expr.args)
+            compile(arg);
+
+        get_variable("super", super->keyword);
+        m_token = &super->method;
+        emit_index(OpCode::SuperInvoke, identifier(super->method.lexeme));
+        m_token = &expr.paren;
+        return emit(argc);
+    }
+
+    compile(expr.callee);
+    for (const auto& arg : expr.args)
+        compile(arg);
+
+    m_token = &expr.paren;
+    emit(OpCode::Call, argc);
+}
+
+auto loxe::vm::Compiler::visit(const ast::CommaExpr& expr) -> void
+{
+    for (auto it = expr.expressions.begin(); it != expr.expressions.end(); it++)
+    {
+        if (it != expr.expressions.begin()) emit(OpCode::Pop);
+        compile(*it);
+    }
+}
+
+auto loxe::vm::Compiler::visit(const ast::ConditionalExpr& expr) -> void
+{
+    compile(expr.condition);
+    const auto then_jump = emit_jump(OpCode::JumpIfFalse);
+    emit(OpCode::Pop);
+    compile(expr.then_branch);
+
+    const auto else_jump = emit_jump(OpCode::Jump);
+    patch_jump(then_jump);
+    emit(OpCode::Pop);
+    compile(expr.else_branch);
+    patch_jump(else_jump);
+}
+
+auto loxe::vm::Compiler::visit(const ast::FunctionExpr& expr) -> void
+{
+    function(expr, FunType::Function);
+}
+
+auto loxe::vm::Compiler::visit(const ast::GetExpr& expr) -> void
+{
+    compile(expr.object);
+    m_token = &expr.name;
+    emit_index(OpCode::GetProperty, identifier(expr.name.lexeme));
+}
+
+auto loxe::vm::Compiler::visit(const ast::GroupingExpr& expr) -> void
+{
+    compile(expr.expression);
+}
+
+auto loxe::vm::Compiler::visit(const ast::LogicalExpr& expr) -> void
+{
+    compile(expr.lhs);
+
+    if (expr.op.type == Token::Type::And)
+    {
+        const auto end_jump = emit_jump(OpCode::JumpIfFalse);
+        emit(OpCode::Pop);
+        compile(expr.rhs);
+        return patch_jump(end_jump);
+    }
+
+    const auto else_jump = emit_jump(OpCode::JumpIfFalse);
+    const auto end_jump  = emit_jump(OpCode::Jump);
+    patch_jump(else_jump);
+    emit(OpCode::Pop);
+    compile(expr.rhs);
+    patch_jump(end_jump);
+}
+
+auto loxe::vm::Compiler::visit(const ast::NilExpr& expr) -> void
+{
+    utility::ignore(expr);
+    emit(OpCode::Nil);
+}
+
+auto loxe::vm::Compiler::visit(const ast::NumberExpr& expr) -> void
+{
+    emit_index(OpCode::Constant, constant(expr.value));
+}
+
+auto loxe::vm::Compiler::visit(const ast::SetExpr& expr) -> void
+{
+    compile(expr.object);
+    compile(expr.value);
+    m_token = &expr.name;
+    emit_index(OpCode::SetProperty, identifier(expr.name.lexeme));
+}
+
+auto loxe::vm::Compiler::visit(const ast::StringExpr& expr) -> void
+{
+    emit_index(OpCode::Constant, constant(m_heap.intern(expr.value)));
+}
+
+auto loxe::vm::Compiler::visit(const ast::SubscriptExpr& expr) -> void
+{
+    compile(expr.expression);
+    compile(expr.index);
+
+    if (expr.new_value) compile(*expr.new_value);
+    m_token = &expr.bracket;
+    emit(expr.new_value ? OpCode::SetIndex : OpCode::GetIndex);
+}
+
+auto loxe::vm::Compiler::visit(const ast::SuperExpr& expr) -> void
+{
+    get_variable("this",  expr.keyword);
+    get_variable("super", expr.keyword);
+    m_token = &expr.method;
+    emit_index(OpCode::GetSuper, identifier(expr.method.lexeme));
+}
+
+auto loxe::vm::Compiler::visit(const ast::ThisExpr& expr) -> void
+{
+    get_variable("this", expr.keyword);
+}
+
+auto loxe::vm::Compiler::visit(const ast::UnaryExpr& expr) -> void
+{
+    compile(expr.operand);
+
+    m_token = &expr.op;
+    switch (expr.op.type)
+    {
+        case Token::Type::Plus:  return emit(OpCode::Identity);
+        case Token::Type::Minus: return emit(OpCode::Negate);
+        case Token::Type::Bang:  return emit(OpCode::Not);
+        default: throw error(expr.op, "invalid unary operator");
+    }
+}
+
+auto loxe::vm::Compiler::visit(const ast::VariableExpr& expr) -> void
+{
+    get_variable(expr.name.lexeme, expr.name);
+}
+
+auto loxe::vm::Compiler::compile(const ast::stmt_list& stmts) -> void
+{
+    for (const auto& stmt : stmts)
+        compile(stmt);
+}
+
+auto loxe::vm::Compiler::compile(const ast::stmt_ptr& stmt) -> void
+{
+    if (stmt) stmt->accept(*this);
+}
+
+auto loxe::vm::Compiler::compile(const ast::expr_ptr& expr) -> void
+{
+    if (!expr) return;
+    if (m_nesting == max_nesting)
+        throw error(*m_token, utility::as_string("expression nests more than {} deep", max_nesting));
+
+    m_nesting++;
+    expr->accept(*this);
+    m_nesting--;
+}
+
+auto loxe::vm::Compiler::function(const ast::FunctionExpr& expr, FunType type) -> void
+{
+    // there's no call to wait for here, the whole program is compiled up front
+    if (!expr.body && (!m_program.resolver || m_program.resolver->expand(m_program, expr) == Resolver::State::Error))
+        throw error(expr.name, "encountered error while parsing function body");
+
+    auto state = FunctionState();
+    state.enclosing = m_function;
+    state.function  = m_heap.make<FunctionObj>(m_heap.intern(expr.name.lexeme));
+    state.type      = type;
+
+    m_function = &state;
+    m_token    = &expr.name;
+
+    begin_scope();
+    add_local(type == FunType::Function ? "" : "this", expr.name);
+    mark_initialized();
+
+    for (const auto& param : expr.params)
+    {
+        if (state.function->arity == std::numeric_limits<std::uint8_t>::max())
+            throw error(param, "can't have more than 255 parameters");
+
+        state.function->arity++;
+        add_local(param.lexeme, param);
+        mark_initialized();
+    }
+
+    compile(expr.body);
+    emit_return();
+    state.function->max_stack = stack_size(*state.function);
+
+    m_function = state.enclosing;
+    m_token    = &expr.name;
+    emit_index(OpCode::Closure, constant(state.function));
+
+    for (const auto& upvalue : state.upvalues)
+    {
+        emit(static_cast<std::uint8_t>(upvalue.is_local ? 1 : 0));
+        emit_short(upvalue.index);
+    }
+}
+
+auto loxe::vm::Compiler::begin_scope() -> void
+{
+    m_function->scope_depth++;
+}
+
+auto loxe::vm::Compiler::end_scope() -> void
+{
+    auto& locals = m_function->locals;
+    m_function->scope_depth--;
+
+    while (!locals.empty() && locals.back().depth > m_function->scope_depth)
+    {
+        emit(locals.back().captured ? OpCode::CloseUpvalue : OpCode::Pop);
+        locals.pop_back();
+    }
+}
+
+auto loxe::vm::Compiler::discard_locals(std::size_t count) -> void
+{
+    const auto& locals = m_function->locals;
+    for (auto i = locals.size(); i > count; i--)
+        emit(locals[i - 1].captured ? OpCode::CloseUpvalue : OpCode::Pop);
+}
+
+auto loxe::vm::Compiler::declare(const Span& name) -> Variable
+{
+    m_token = &name;
+
+    if (!m_modules.empty() && m_modules.back().owner == m_function && m_modules.back().depth == m_function->scope_depth)
+    {
+        const auto& members = m_modules.back().members;
+        if (const auto member = members.find(name.lexeme); member != members.end())
+            return { Variable::Kind::Member, member->second };
+    }
+
+    if (m_function->scope_depth == 0)
+        return { Variable::Kind::Global, global(name.lexeme) };
+
+    add_local(name.lexeme, name);
+    return { Variable::Kind::Local };
+}
+
+auto loxe::vm::Compiler::define(Variable variable) -> void
+{
+    switch (variable.kind)
+    {
+        case Variable::Kind::Global:
+            emit_index(OpCode::DefineGlobal, variable.index);
+            break;
+
+        case Variable::Kind::Member:
+            emit_slot(OpCode::SetLocal, static_cast<std::uint16_t>(variable.index));
+            emit(OpCode::Pop);
+            break;
+
+        case Variable::Kind::Local:
+            mark_initialized();
+            break;
+    }
+}
+
+auto loxe::vm::Compiler::add_local(std::string_view name, const Span& token) -> void
+{
+    if (m_function->locals.size() > std::numeric_limits<std::uint16_t>::max())
+        throw error(token, "too many local variables in function");
+
+    m_function->locals.push_back({ name, -1, false });
+}
+
+auto loxe::vm::Compiler::mark_initialized() -> void
+{
+    if (m_function->scope_depth == 0) return;
+    m_function->locals.back().depth = m_function->scope_depth;
+}
+
+auto loxe::vm::Compiler::get_variable(std::string_view name, const Span& token) -> void
+{
+    m_token = &token;
+
+    if (const auto slot = resolve_local(*m_function, name))
+        emit_slot(OpCode::GetLocal, *slot);
+    else if (const auto index = resolve_upvalue(*m_function, name))
+        emit_slot(OpCode::GetUpvalue, *index);
+    else
+        emit_index(OpCode::GetGlobal, global(name));
+}
+
+auto loxe::vm::Compiler::set_variable(std::string_view name, const Span& token) -> void
+{
+    m_token = &token;
+
+    if (const auto slot = resolve_local(*m_function, name))
+        emit_slot(OpCode::SetLocal, *slot);
+    else if (const auto index = resolve_upvalue(*m_function, name))
+        emit_slot(OpCode::SetUpvalue, *index);
+    else
+        emit_index(OpCode::SetGlobal, global(name));
+}
+
+auto loxe::vm::Compiler::resolve_local(FunctionState& state, std::string_view name) -> std::optional<std::uint16_t>
+{
+    for (auto i = state.locals.size(); i > 0; i--)
+    {
+        if (state.locals[i - 1].name == name)
+            return static_cast<std::uint16_t>(i - 1);
+    }
+
+    return std::nullopt;
+}
+
+auto loxe::vm::Compiler::resolve_upvalue(FunctionState& state, std::string_view name) -> std::optional<std::uint16_t>
+{
+    if (!state.enclosing) return std::nullopt;
+
+    if (const auto local = resolve_local(*state.enclosing, name))
+    {
+        state.enclosing->locals[*local].captured = true;
+        return add_upvalue(state, *local, true);
+    }
+
+    if (const auto upvalue = resolve_upvalue(*state.enclosing, name))
+        return add_upvalue(state, *upvalue, false);
+
+    return std::nullopt;
+}
+
+auto loxe::vm::Compiler::add_upvalue(FunctionState& state, std::uint16_t index, bool is_local) -> std::uint16_t
+{
+    auto& upvalues = state.upvalues;
+    for (auto i = std::size_t{0}; i < upvalues.size(); i++)
+    {
+        if (upvalues[i].index == index && upvalues[i].is_local == is_local)
+            return static_cast<std::uint16_t>(i);
+    }
+
+    if (upvalues.size() > std::numeric_limits<std::uint16_t>::max())
+        throw error(*m_token, "too many closure variables in function");
+
+    upvalues.push_back({ index, is_local });
+    state.function->upvalue_count = upvalues.size();
+    return static_cast<std::uint16_t>(upvalues.size() - 1);
+}
+
+auto loxe::vm::Compiler::global(std::string_view name) -> std::uint32_t
+{
+    if (auto it = m_global_ids.find(name); it != m_global_ids.end())
+        return it->second;
+
+    if (m_globals.size() > std::numeric_limits<std::uint32_t>::max())
+        throw error(*m_token, "too many global variables");
+
+    const auto slot = static_cast<std::uint32_t>(m_globals.size());
+    m_globals.push_back(m_heap.intern(name));
+    m_global_ids.emplace(name, slot);
+    return slot;
+}
+
+auto loxe::vm::Compiler::emit(std::uint8_t byte) -> void
+{
+    chunk().write(byte, *m_token);
+}
+
+auto loxe::vm::Compiler::emit(OpCode op) -> void
+{
+    chunk().write(op, *m_token);
+}
+
+auto loxe::vm::Compiler::emit(OpCode op, std::uint8_t operand) -> void
+{
+    emit(op);
+    emit(operand);
+}
+
+auto loxe::vm::Compiler::emit_slot(OpCode op, std::uint16_t slot) -> void
+{
+    if (slot <= std::numeric_limits<std::uint8_t>::max())
+        return emit(op, static_cast<std::uint8_t>(slot));
+
+    emit(OpCode::Wide);
+    emit(op);
+    emit_short(slot);
+}
+
+auto loxe::vm::Compiler::emit_index(OpCode op, std::uint32_t index) -> void
+{
+    if (index <= std::numeric_limits<std::uint16_t>::max())
+    {
+        emit(op);
+        return emit_short(static_cast<std::uint16_t>(index));
+    }
+
+    emit(OpCode::Wide);
+    emit(op);
+    emit_long(index);
+}
+
+auto loxe::vm::Compiler::emit_short(std::uint16_t value) -> void
+{
+    emit(static_cast<std::uint8_t>((value >> 8) & 0xff));
+    emit(static_cast<std::uint8_t>(value & 0xff));
+}
+
+auto loxe::vm::Compiler::emit_long(std::uint32_t value) -> void
+{
+    emit_short(static_cast<std::uint16_t>((value >> 16) & 0xffff));
+    emit_short(static_cast<std::uint16_t>(value & 0xffff));
+}
+
+auto loxe::vm::Compiler::emit_jump(OpCode op) -> std::size_t
+{
+    // the offset is only known once the code jumped over is compiled, so it always
+    // gets four bytes rather than a width picked before then
+    emit(op);
+    emit_long(0xffffffff);
+    return chunk().code.size() - 4;
+}
+
+auto loxe::vm::Compiler::emit_loop(std::size_t start) -> void
+{
+    emit(OpCode::Loop);
+
+    const auto offset = chunk().code.size() - start + 4;
+    if (offset > std::numeric_limits<std::uint32_t>::max())
+        throw error(*m_token, "loop body too large");
+
+    emit_long(static_cast<std::uint32_t>(offset));
+}
+
+auto loxe::vm::Compiler::emit_return() -> void
+{
+    if (m_function->type == FunType::Initializer)
+        emit_slot(OpCode::GetLocal, 0);
+    else
+        emit(OpCode::Nil);
+
+    emit(OpCode::Return);
+}
+
+auto loxe::vm::Compiler::patch_jump(std::size_t offset) -> void
+{
+    auto& code = chunk().code;
+
+    const auto jump = code.size() - offset - 4;
+    if (jump > std::numeric_limits<std::uint32_t>::max())
+        throw error(*m_token, "too much code to jump over");
+
+    code[offset]     = static_cast<std::uint8_t>((jump >> 24) & 0xff);
+    code[offset + 1] = static_cast<std::uint8_t>((jump >> 16) & 0xff);
+    code[offset + 2] = static_cast<std::uint8_t>((jump >> 8) & 0xff);
+    code[offset + 3] = static_cast<std::uint8_t>(jump & 0xff);
+}
+
+auto loxe::vm::Compiler::stack_size(const FunctionObj& function) -> std::size_t
+{
+    // follows every path through the code once, counting the values each instruction leaves
+    // on the stack. the compiler leaves the same count at a jump target on every path there
+    const auto& code    = function.chunk.code;
+    auto        seen    = std::vector<bool>(code.size(), false);
+    auto        pending = std::vector<std::pair<std::size_t, std::ptrdiff_t>>{ { 0, function.arity + 1 } };
+    auto        deepest = static_cast<std::ptrdiff_t>(function.arity + 1);
+
+    auto read = [&](std::size_t offset, std::size_t bytes) -> std::size_t
+    {
+        auto value = std::size_t{0};
+        for (auto i = std::size_t{0}; i < bytes; i++)
+            value = (value << 8) | code[offset + i];
+        return value;
+    };
+
+    while (!pending.empty())
+    {
+        auto [offset, depth] = pending.back();
+        pending.pop_back();
+
+        while (offset < code.size() && !seen[offset])
+        {
+            seen[offset] = true;
+
+            const auto wide  = static_cast<OpCode>(code[offset]) == OpCode::Wide;
+            const auto op    = offset + (wide ? 1 : 0);
+            const auto slot  = std::size_t{wide ? 2u : 1u};
+            const auto index = std::size_t{wide ? 4u : 2u};
+
+            auto length = std::size_t{1};
+            auto effect = std::ptrdiff_t{0};
+            auto next   = true;
+            switch (static_cast<OpCode>(code[op]))
+            {
+                case OpCode::Nil:
+                case OpCode::True:
+                case OpCode::False:        effect = 1;                     break;
+                case OpCode::Constant:
+                case OpCode::GetGlobal:
+                case OpCode::Class:        effect = 1;  length += index;   break;
+                case OpCode::GetLocal:
+                case OpCode::GetUpvalue:   effect = 1;  length += slot;    break;
+                case OpCode::SetLocal:
+                case OpCode::SetUpvalue:                length += slot;    break;
+                case OpCode::SetGlobal:
+                case OpCode::GetProperty:               length += index;   break;
+                case OpCode::DefineGlobal:
+                case OpCode::SetProperty:
+                case OpCode::GetSuper:
+                case OpCode::Method:       effect = -1; length += index;   break;
+                case OpCode::SetIndex:     effect = -2;                    break;
+                case OpCode::Not:
+                case OpCode::Negate:
+                case OpCode::Identity:
+                case OpCode::Wide:                                         break;
+                case OpCode::Call:         effect = -code[op + 1];                                            length = 2;         break;
+                case OpCode::Invoke:       effect = -code[op + 1 + index];                                    length = 2 + index; break;
+                case OpCode::SuperInvoke:  effect = -code[op + 1 + index] - 1;                                length = 2 + index; break;
+                case OpCode::Array:        effect = 1 - static_cast<std::ptrdiff_t>(read(op + 1, index));     length += index;    break;
+                case OpCode::SizedArray:   effect = -static_cast<std::ptrdiff_t>(read(op + 1, index));        length += index;    break;
+                case OpCode::Return:       next   = false;                                                                        break;
+
+                case OpCode::Module:
+                {
+                    effect = 1;
+                    length = 1 + index + 2 + read(op + 1 + index, 2) * 6;
+                    break;
+                }
+
+                case OpCode::Closure:
+                {
+                    const auto closure = function.chunk.constants[read(op + 1, index)].as<FunctionObj>();
+                    effect = 1;
+                    length = 1 + index + closure->upvalue_count * 3;
+                    break;
+                }
+
+                case OpCode::Jump:
+                case OpCode::JumpIfFalse:
+                    length = 5;
+                    next   = static_cast<OpCode>(code[op]) == OpCode::JumpIfFalse;
+                    pending.emplace_back(op + length + read(op + 1, 4), depth);
+                    break;
+
+                case OpCode::Loop:
+                    length = 5;
+                    next   = false;
+                    break;
+
+                case OpCode::Pop:
+                case OpCode::CloseUpvalue:
+                case OpCode::GetIndex:
+                case OpCode::Equal:
+                case OpCode::NotEqual:
+                case OpCode::Greater:
+                case OpCode::GreaterEqual:
+                case OpCode::Less:
+                case OpCode::LessEqual:
+                case OpCode::Add:
+                case OpCode::Subtract:
+                case OpCode::Multiply:
+                case OpCode::Divide:
+                case OpCode::Inherit:
+                case OpCode::Print:        effect = -1;                    break;
+            }
+
+            depth  += effect;
+            deepest = std::max(deepest, depth);
+            offset  = op + length;
+            if (!next) break;
+        }
+    }
+
+    return static_cast<std::size_t>(deepest);
+}
+
+auto loxe::vm::Compiler::constant(Value value) -> std::uint32_t
+{
+    auto add = [&](auto& cache, auto key) -> std::uint32_t
+    {
+        if (auto it = cache.find(key); it != cache.end())
+            return it->second;
+
+        const auto index = chunk().add_constant(value);
+        if (index > std::numeric_limits<std::uint32_t>::max())
+            throw error(*m_token, "too many constants in one chunk");
+
+        return cache[key] = static_cast<std::uint32_t>(index);
+    };
+
+    if (value.is<Value::number>())
+        return add(m_function->number_constants, std::bit_cast<std::uint64_t>(value.as<Value::number>()));
+    return add(m_function->object_constants, value.as<Obj>());
+}
+
+auto loxe::vm::Compiler::identifier(std::string_view name) -> std::uint32_t
+{
+    return constant(m_heap.intern(name));
+}
+
+auto loxe::vm::Compiler::chunk() -> Chunk&
+{
+    return m_function->function->chunk;
+}
+
+auto loxe::vm::Compiler::error(const Span& token, std::string message) const -> CompileError
+{
+    return CompileError(token, std::move(message));
+}
@@ -0,0 +1,108 @@
+#include <algorithm>
+#include <functional>
+
+#include "loxe/vm/heap.hpp"
+
+loxe::vm::Heap::~Heap()
+{
+    while (m_objects)
+    {
+        auto next = m_objects->next;
+        delete m_objects;
+        m_objects = next;
+    }
+}
+
+auto loxe::vm::Heap::intern(std::string_view string) -> StringObj*
+{
+    if (auto it = m_strings.find(string); it != m_strings.end())
+        return it->second;
+    return intern(std::string(string));
+}
+
+auto loxe::vm::Heap::intern(std::string&& string) -> StringObj*
+{
+    if (auto it = m_strings.find(string); it != m_strings.end())
+        return it->second;
+
+    const auto hash   = std::hash<std::string>()(string);
+    const auto object = make<StringObj>(std::move(string), hash);
+    m_strings.emplace(object->value(), object);
+    return object;
+}
+
+auto loxe::vm::Heap::concat(StringObj* lhs, StringObj* rhs) -> StringObj*
+{
+    // interned buffers are never grown: the intern table keys on them. and a string can't be
+    // appended to the buffer it is itself a view of, as growing it may move the characters
+    const auto root = lhs->root ? lhs->root : lhs;
+    if (!root->interned && root->buffer.size() == lhs->length && (rhs->root ? rhs->root : rhs) != root)
+    {
+        const auto before = root->payload();
+        root->buffer.append(rhs->value());
+        root->size += root->payload() - before;
+        m_bytes    += root->payload() - before;
+        return make<StringObj>(root, root->buffer.size());
+    }
+
+    auto buffer = std::string();
+    buffer.reserve(lhs->length + rhs->length);
+    buffer.append(lhs->value()).append(rhs->value());
+    return make<StringObj>(std::move(buffer));
+}
+
+auto loxe::vm::Heap::mark(Value value) -> void
+{
+    if (value.is<Obj>()) mark(value.as<Obj>());
+}
+
+auto loxe::vm::Heap::mark(Obj* object) -> void
+{
+    if (!object || object->marked) return;
+    object->marked = true;
+    m_gray.push_back(object);
+}
+
+auto loxe::vm::Heap::should_collect() const -> bool
+{
+    return m_bytes > m_threshold;
+}
+
+auto loxe::vm::Heap::collect() -> void
+{
+    trace();
+
+    // interned strings are weak references: drop the ones nothing else reaches
+    std::erase_if(m_strings, [](const auto& entry) { return !entry.second->marked; });
+
+    sweep();
+    m_threshold = std::max(initial_threshold, m_bytes * 2);
+}
+
+auto loxe::vm::Heap::trace() -> void
+{
+    while (!m_gray.empty())
+    {
+        auto object = m_gray.back();
+        m_gray.pop_back();
+        object->trace(*this);
+    }
+}
+
+auto loxe::vm::Heap::sweep() -> void
+{
+    auto link = &m_objects;
+    while (auto object = *link)
+    {
+        if (object->marked)
+        {
+            object->marked = false;
+            link = &object->next;
+            continue;
+        }
+
+        *link = object->next;
+        m_bytes -= object->size;
+        delete object;
+    }
+}
@@ -0,0 +1,660 @@
+#include <functional>
+
+#include "loxe/common/utility.hpp"
+#include "loxe/parser/error.hpp"
+#include "loxe/vm/compiler.hpp"
+#include "loxe/vm/machine.hpp"
+
+loxe::vm::Machine::Machine()
+    : m_stack(std::make_unique<Value[]>(stack_max)), m_top(m_stack.get())
+{
+    m_frames.reserve(frames_max);
+    m_init_string = m_heap.intern(std::string_view("init"));
+}
+
+auto loxe::vm::Machine::interpret(ast::Program& program) -> void
+{
+    try
+    {
+        auto compiler = Compiler(m_heap, program);
+        auto script   = compiler.compile_ast(program.statements);
+
+        m_global_names = compiler.globals();
+        m_globals.assign(m_global_names.size(), Value::undefined());
+
+        auto closure = m_heap.make<ClosureObj>(script);
+        push(closure);
+        call(closure, 0);
+        run();
+    }
+    catch (const CompileError& e)
+    {
+        utility::println(std::cerr, "{}", e.report(program.sources));
+    }
+    catch (const RuntimeError& e)
+    {
+        utility::println(std::cerr, "{}", e.report(program.sources));
+    }
+    catch (const ExpandError& e)
+    {
+        utility::println(std::cerr, "{}", e.report());
+    }
+
+    reset();
+}
+
+auto loxe::vm::Machine::run() -> void
+{
+    auto frame = &m_frames.back();
+    auto ip    = frame->ip;
+
+    auto read_byte = [&]() -> std::uint8_t
+    {
+        return *ip++;
+    };
+
+    auto read_short = [&]() -> std::uint16_t
+    {
+        ip += 2;
+        return static_cast<std::uint16_t>((ip[-2] << 8) | ip[-1]);
+    };
+
+    auto read_long = [&]() -> std::uint32_t
+    {
+        ip += 4;
+        return (static_cast<std::uint32_t>(ip[-4]) << 24) | (static_cast<std::uint32_t>(ip[-3]) << 16) |
+               (static_cast<std::uint32_t>(ip[-2]) << 8)  |  static_cast<std::uint32_t>(ip[-1]);
+    };
+
+    // an instruction after `Wide` reads its slot, constant, global or count operand at
+    // twice the usual width, which the compiler only does once the narrow one is too small
+    auto wide = false;
+
+    auto read_slot = [&]() -> std::size_t
+    {
+        if (!wide) [[likely]] return read_byte();
+        wide = false;
+        return read_short();
+    };
+
+    auto read_index = [&]() -> std::size_t
+    {
+        if (!wide) [[likely]] return read_short();
+        wide = false;
+        return read_long();
+    };
+
+    auto read_constant = [&]() -> Value
+    {
+        return frame->closure->function->chunk.constants[read_index()];
+    };
+
+    auto read_string = [&]() -> StringObj*
+    {
+        return read_constant().as<StringObj>();
+    };
+
+    auto sync = [&]() -> void
+    {
+        frame->ip = ip;
+    };
+
+    auto reload = [&]() -> void
+    {
+        frame = &m_frames.back();
+        ip    = frame->ip;
+    };
+
+    auto numeric = [&](auto operation) -> void
+    {
+        const auto lhs = peek(1);
+        const auto rhs = peek(0);
+        if (!lhs.is<Value::number>() || !rhs.is<Value::number>())
+        {
+            sync();
+            throw error("operator requires a number");
+        }
+
+        m_top--;
+        m_top[-1] = Value(operation(lhs.as<Value::number>(), rhs.as<Value::number>()));
+    };
+
+    while (true)
+    {
+        switch (static_cast<OpCode>(read_byte()))
+        {
+            case OpCode::Constant: push(read_constant()); break;
+            case OpCode::Nil:      push(Value());         break;
+            case OpCode::True:     push(Value(true));     break;
+            case OpCode::False:    push(Value(false));    break;
+            case OpCode::Pop:      m_top--;               break;
+
+            case OpCode::GetLocal:   push(frame->slots[read_slot()]);                            break;
+            case OpCode::SetLocal:   frame->slots[read_slot()] = peek(0);                        break;
+            case OpCode::GetUpvalue: push(*frame->closure->upvalues[read_slot()]->location);     break;
+            case OpCode::SetUpvalue: *frame->closure->upvalues[read_slot()]->location = peek(0); break;
+
+            case OpCode::DefineGlobal:
+                m_globals[read_index()] = pop();
+                break;
+
+            case OpCode::GetGlobal:
+            {
+                const auto slot  = read_index();
+                const auto value = m_globals[slot];
+                if (value.is_undefined())
+                {
+                    sync();
+                    throw error(utility::as_string("'{}' is an undefined symbol", m_global_names[slot]->value()));
+                }
+
+                push(value);
+                break;
+            }
+
+            case OpCode::SetGlobal:
+            {
+                const auto slot = read_index();
+                if (m_globals[slot].is_undefined())
+                {
+                    sync();
+                    throw error(utility::as_string("'{}' is an undefined symbol", m_global_names[slot]->value()));
+                }
+
+                m_globals[slot] = peek(0);
+                break;
+            }
+
+            case OpCode::CloseUpvalue:
+                close_upvalues(m_top - 1);
+                m_top--;
+                break;
+
+            case OpCode::GetProperty:
+            {
+                const auto name = read_string();
+                sync();
+                m_top[-1] = get_property(peek(0), name, 1);
+                break;
+            }
+
+            case OpCode::SetProperty:
+            {
+                const auto name   = read_string();
+                const auto value  = peek(0);
+                const auto object = peek(1);
+                sync();
+
+                if (object.is<InstanceObj>())
+                {
+                    object.as<InstanceObj>()->fields[name] = value;
+                }
+                else if (object.is<ModuleObj>())
+                {
+                    const auto& members = object.as<ModuleObj>()->members;
+                    const auto  member  = members.find(name);
+                    if (member == members.end())
+                        throw error(utility::as_string("'{}' is an undefined symbol", name->value()));
+                    *member->second->location = value;
+                }
+                else
+                {
+                    throw error("only instances have properties");
+                }
+
+                m_top--;
+                m_top[-1] = value;
+                break;
+            }
+
+            case OpCode::GetSuper:
+            {
+                const auto name       = read_string();
+                const auto superclass = pop().as<ClassObj>();
+                sync();
+                m_top[-1] = bind_method(superclass, peek(0), name);
+                break;
+            }
+
+            case OpCode::GetIndex:
+            case OpCode::SetIndex:
+            {
+                const auto assign = static_cast<OpCode>(ip[-1]) == OpCode::SetIndex;
+                const auto object = peek(assign ? 2 : 1);
+                const auto index  = peek(assign ? 1 : 0);
+                sync();
+
+                if (!object.is<ArrayObj>())
+                    throw error("subscript operator can only be used on arrays");
+                if (!index.is<Value::number>())
+                    throw error("subscript operator requires a number operator");
+
+                auto&      values = object.as<ArrayObj>()->values;
+                const auto offset = index.as<Value::number>();
+                if (offset < 0 || static_cast<std::size_t>(offset) >= values.size())
+                    throw error("index out of range for array");
+
+                auto& element = values[static_cast<std::size_t>(offset)];
+                if (assign) element = peek(0);
+
+                m_top    -= assign ? 2 : 1;
+                m_top[-1] = element;
+                break;
+            }
+
+            case OpCode::Equal:
+            {
+                const auto rhs = pop();
+                m_top[-1] = Value(m_top[-1] == rhs);
+                break;
+            }
+
+            case OpCode::NotEqual:
+            {
+                const auto rhs = pop();
+                m_top[-1] = Value(!(m_top[-1] == rhs));
+                break;
+            }
+
+            case OpCode::Greater:      numeric(std::greater<>());       break;
+            case OpCode::GreaterEqual: numeric(std::greater_equal<>()); break;
+            case OpCode::Less:         numeric(std::less<>());          break;
+            case OpCode::LessEqual:    numeric(std::less_equal<>());    break;
+            case OpCode::Subtract:     numeric(std::minus<>());         break;
+            case OpCode::Multiply:     numeric(std::multiplies<>());    break;
+            case OpCode::Divide:       numeric(std::divides<>());       break;
+
+            case OpCode::Add:
+            {
+                const auto lhs = peek(1);
+                const auto rhs = peek(0);
+
+                if (lhs.is<Value::number>() && rhs.is<Value::number>())
+                {
+                    m_top--;
+                    m_top[-1] = Value(lhs.as<Value::number>() + rhs.as<Value::number>());
+                }
+                else if (lhs.is<StringObj>() && rhs.is<StringObj>())
+                {
+                    const auto string = m_heap.concat(lhs.as<StringObj>(), rhs.as<StringObj>());
+                    m_top--;
+                    m_top[-1] = string;
+                }
+                else
+                {
+                    sync();
+                    throw error("'+' operator requires two numbers or strings");
+                }
+                break;
+            }
+
+            case OpCode::Not:
+                m_top[-1] = Value(!m_top[-1].is_truthy());
+                break;
+
+            case OpCode::Negate:
+            case OpCode::Identity:
+            {
+                const auto negate = static_cast<OpCode>(ip[-1]) == OpCode::Negate;
+                if (!peek(0).is<Value::number>())
+                {
+                    sync();
+                    throw error(negate ? "'-' unary operator requires a numbers" : "'+' unary operator requires a numbers");
+                }
+
+                if (negate) m_top[-1] = Value(-m_top[-1].as<Value::number>());
+                break;
+            }
+
+            case OpCode::Jump:
+            {
+                const auto offset = read_long();
+                ip += offset;
+                break;
+            }
+
+            case OpCode::JumpIfFalse:
+            {
+                const auto offset = read_long();
+                if (!peek(0).is_truthy()) ip += offset;
+                break;
+            }
+
+            case OpCode::Loop:
+            {
+                const auto offset = read_long();
+                ip -= offset;
+                if (m_heap.should_collect()) collect_garbage();
+                break;
+            }
+
+            case OpCode::Call:
+            {
+                const auto argc = read_byte();
+                sync();
+                call_value(peek(argc), argc);
+                reload();
+                break;
+            }
+
+            case OpCode::Invoke:
+            {
+                const auto name = read_string();
+                const auto argc = read_byte();
+                sync();
+                invoke(name, argc);
+                reload();
+                break;
+            }
+
+            case OpCode::SuperInvoke:
+            {
+                const auto name       = read_string();
+                const auto argc       = read_byte();
+                const auto superclass = pop().as<ClassObj>();
+                sync();
+                invoke_from_class(superclass, name, argc);
+                reload();
+                break;
+            }
+
+            case OpCode::Closure:
+            {
+                const auto function = read_constant().as<FunctionObj>();
+                const auto closure  = m_heap.make<ClosureObj>(function);
+                push(closure);
+
+                for (auto& upvalue : closure->upvalues)
+                {
+                    const auto is_local = read_byte();
+                    const auto index    = read_short();
+                    upvalue = is_local ? capture_upvalue(frame->slots + index) : frame->closure->upvalues[index];
+                }
+                break;
+            }
+
+            case OpCode::Return:
+            {
+                const auto result = pop();
+                close_upvalues(frame->slots);
+
+                m_top = frame->slots;
+                m_frames.pop_back();
+                if (m_frames.empty()) return;
+
+                push(result);
+                reload();
+                break;
+            }
+
+            case OpCode::Array:
+            case OpCode::SizedArray:
+            {
+                const auto sized = static_cast<OpCode>(ip[-1]) == OpCode::SizedArray;
+                const auto count = read_index();
+                const auto size  = sized ? pop() : Value();
+
+                auto values = ArrayObj::container(m_top - count, m_top);
+                if (sized)
+                {
+                    if (!size.is<Value::number>())
+                    {
+                        sync();
+                        throw error("array size must be a number during initialization");
+                    }
+
+                    const auto as_number = size.as<Value::number>();
+                    if (as_number > 0 && values.size() < static_cast<std::size_t>(as_number))
+                        values.resize(static_cast<std::size_t>(as_number), Value());
+                }
+
+                m_top -= count;
+                push(m_heap.make<ArrayObj>(std::move(values)));
+                break;
+            }
+
+            case OpCode::Class:
+                push(m_heap.make<ClassObj>(read_string()));
+                break;
+
+            case OpCode::Module:
+            {
+                const auto module = m_heap.make<ModuleObj>(read_string());
+                push(module);
+
+                const auto count = read_short();
+                for (auto i = std::uint16_t{0}; i < count; i++)
+                {
+                    const auto name = frame->closure->function->chunk.constants[read_long()].as<StringObj>();
+                    module->members[name] = capture_upvalue(frame->slots + read_short());
+                }
+                break;
+            }
+
+            case OpCode::Inherit:
+            {
+                const auto superclass = peek(1);
+                if (!superclass.is<ClassObj>())
+                {
+                    sync();
+                    throw error("superclass must be a class");
+                }
+
+                const auto subclass = peek(0).as<ClassObj>();
+                subclass->methods = superclass.as<ClassObj>()->methods;
+                subclass->init    = superclass.as<ClassObj>()->init;
+                m_top--;
+                break;
+            }
+
+            case OpCode::Method:
+            {
+                const auto name   = read_string();
+                const auto method = peek(0).as<ClosureObj>();
+                const auto cls    = peek(1).as<ClassObj>();
+
+                cls->methods[name] = method;
+                if (name == m_init_string) cls->init = method;
+                m_top--;
+                break;
+            }
+
+            case OpCode::Print:
+                utility::println("{}", pop().stringify());
+                break;
+
+            case OpCode::Wide:
+                wide = true;
+                break;
+        }
+    }
+}
+
+auto loxe::vm::Machine::push(Value value) -> void
+{
+    *m_top++ = value;
+}
+
+auto loxe::vm::Machine::pop() -> Value
+{
+    return *--m_top;
+}
+
+auto loxe::vm::Machine::peek(std::size_t distance) const -> Value
+{
+    return m_top[-1 - static_cast<std::ptrdiff_t>(distance)];
+}
+
+auto loxe::vm::Machine::call_value(Value callee, std::size_t argc) -> void
+{
+    if (callee.is<ClosureObj>())
+        return call(callee.as<ClosureObj>(), argc);
+
+    if (callee.is<BoundMethodObj>())
+    {
+        const auto bound = callee.as<BoundMethodObj>();
+        m_top[-1 - static_cast<std::ptrdiff_t>(argc)] = bound->receiver;
+        return call(bound->method, argc);
+    }
+
+    if (callee.is<ClassObj>())
+    {
+        const auto cls = callee.as<ClassObj>();
+        m_top[-1 - static_cast<std::ptrdiff_t>(argc)] = m_heap.make<InstanceObj>(cls);
+
+        if (cls->init) return call(cls->init, argc);
+        if (argc != 0) throw error(utility::as_string("expected {} args but got {}", 0, argc));
+        return;
+    }
+
+    throw error("can only call functions and classes");
+}
+
+auto loxe::vm::Machine::call(ClosureObj* closure, std::size_t argc) -> void
+{
+    const auto arity = closure->function->arity;
+    if (arity != argc)
+        throw error(utility::as_string("expected {} args but got {}", arity, argc));
+
+    // the compiler worked out how deep the call can take the stack, so pushes don't check
+    const auto base = static_cast<std::size_t>(m_top - m_stack.get()) - argc - 1;
+    if (m_frames.size() == frames_max || base + closure->function->max_stack > stack_max)
+        throw error("stack overflow");
+
+    const auto& code = closure->function->chunk.code;
+    m_frames.push_back({ closure, code.data(), m_top - argc - 1 });
+
+    if (m_heap.should_collect())
+        collect_garbage();
+}
+
+auto loxe::vm::Machine::invoke(StringObj* name, std::size_t argc) -> void
+{
+    const auto receiver = peek(argc);
+    if (!receiver.is<InstanceObj>())
+        return call_value(m_top[-1 - static_cast<std::ptrdiff_t>(argc)] = get_property(receiver, name, 4), argc);
+
+    const auto instance = receiver.as<InstanceObj>();
+    if (auto field = instance->fields.find(name); field != instance->fields.end())
+        return call_value(m_top[-1 - static_cast<std::ptrdiff_t>(argc)] = field->second, argc);
+
+    invoke_from_class(instance->class_obj, name, argc);
+}
+
+auto loxe::vm::Machine::invoke_from_class(ClassObj* cls, StringObj* name, std::size_t argc) -> void
+{
+    const auto method = cls->methods.find(name);
+    if (method == cls->methods.end())
+        throw error(utility::as_string("undefined property '{}'", name->value()), 4);
+
+    call(method->second, argc);
+}
+
+auto loxe::vm::Machine::get_property(Value receiver, StringObj* name, std::size_t back) -> Value
+{
+    if (receiver.is<InstanceObj>())
+    {
+        const auto instance = receiver.as<InstanceObj>();
+        if (auto field = instance->fields.find(name); field != instance->fields.end())
+            return field->second;
+
+        if (instance->class_obj->methods.contains(name))
+            return bind_method(instance->class_obj, receiver, name);
+
+        throw error(utility::as_string("undefined property '{}'", name->value()), back);
+    }
+
+    if (receiver.is<ArrayObj>() && name->value() == "length")
+        return Value(static_cast<Value::number>(receiver.as<ArrayObj>()->values.size()));
+
+    if (receiver.is<ModuleObj>())
+    {
+        const auto& members = receiver.as<ModuleObj>()->members;
+        const auto  member  = members.find(name);
+        if (member == members.end())
+            throw error(utility::as_string("'{}' is an undefined symbol", name->value()), back);
+        return *member->second->location;
+    }
+
+    throw error("only instance have properties", back);
+}
+
+auto loxe::vm::Machine::bind_method(ClassObj* cls, Value receiver, StringObj* name) -> Value
+{
+    const auto method = cls->methods.find(name);
+    if (method == cls->methods.end())
+        throw error(utility::as_string("undefined property '{}'", name->value()));
+
+    return m_heap.make<BoundMethodObj>(receiver, method->second);
+}
+
+auto loxe::vm::Machine::capture_upvalue(Value* local) -> UpvalueObj*
+{
+    auto previous = static_cast<UpvalueObj*>(nullptr);
+    auto upvalue  = m_open_upvalues;
+    while (upvalue && upvalue->location > local)
+    {
+        previous = upvalue;
+        upvalue  = upvalue->next_open;
+    }
+
+    if (upvalue && upvalue->location == local)
+        return upvalue;
+
+    auto created = m_heap.make<UpvalueObj>(local);
+    created->next_open = upvalue;
+
+    if (previous)
+        previous->next_open = created;
+    else
+        m_open_upvalues = created;
+
+    return created;
+}
+
+auto loxe::vm::Machine::close_upvalues(Value* last) -> void
+{
+    while (m_open_upvalues && m_open_upvalues->location >= last)
+    {
+        auto upvalue = m_open_upvalues;
+        upvalue->closed   = *upvalue->location;
+        upvalue->location = &upvalue->closed;
+        m_open_upvalues   = upvalue->next_open;
+    }
+}
+
+auto loxe::vm::Machine::collect_garbage() -> void
+{
+    for (auto slot = m_stack.get(); slot < m_top; slot++)
+        m_heap.mark(*slot);
+
+    for (const auto& frame : m_frames)
+        m_heap.mark(frame.closure);
+
+    for (auto upvalue = m_open_upvalues; upvalue; upvalue = upvalue->next_open)
+        m_heap.mark(upvalue);
+
+    for (const auto& value : m_globals)
+        m_heap.mark(value);
+
+    for (const auto& name : m_global_names)
+        m_heap.mark(name);
+
+    m_heap.mark(m_init_string);
+    m_heap.collect();
+}
+
+auto loxe::vm::Machine::reset() -> void
+{
+    m_top           = m_stack.get();
+    m_open_upvalues = nullptr;
+    m_frames.clear();
+}
+
+auto loxe::vm::Machine::error(std::string message, std::size_t back) const -> RuntimeError
+{
+    const auto& frame  = m_frames.back();
+    const auto& chunk  = frame.closure->function->chunk;
+    const auto  offset = static_cast<std::size_t>(frame.ip - chunk.code.data()) - back;
+    return RuntimeError(chunk.token_at(offset), std::move(message));
+}
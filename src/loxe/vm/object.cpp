@@ -0,0 +1,140 @@
+#include "loxe/common/utility.hpp"
+#include "loxe/vm/heap.hpp"
+#include "loxe/vm/object.hpp"
+
+auto loxe::vm::StringObj::trace(Heap& heap) -> void
+{
+    heap.mark(root);
+}
+
+auto loxe::vm::StringObj::to_string() const -> std::string
+{
+    return std::string(value());
+}
+
+auto loxe::vm::StringObj::payload() const -> std::size_t
+{
+    return buffer.capacity();
+}
+
+auto loxe::vm::StringObj::equals(const StringObj& other) const -> bool
+{
+    if (this == &other)              return true;
+    if (interned && other.interned)  return false;
+    if (length != other.length)      return false;
+    return value() == other.value();
+}
+
+auto loxe::vm::FunctionObj::trace(Heap& heap) -> void
+{
+    heap.mark(name);
+    for (const auto& constant : chunk.constants)
+        heap.mark(constant);
+}
+
+auto loxe::vm::FunctionObj::to_string() const -> std::string
+{
+    return utility::as_string("<fn {}>", name->value());
+}
+
+auto loxe::vm::UpvalueObj::trace(Heap& heap) -> void
+{
+    heap.mark(closed);
+}
+
+auto loxe::vm::UpvalueObj::to_string() const -> std::string
+{
+    return "<upvalue>";
+}
+
+auto loxe::vm::ClosureObj::trace(Heap& heap) -> void
+{
+    heap.mark(function);
+    for (const auto& upvalue : upvalues)
+        heap.mark(upvalue);
+}
+
+auto loxe::vm::ClosureObj::to_string() const -> std::string
+{
+    return function->to_string();
+}
+
+auto loxe::vm::ClassObj::trace(Heap& heap) -> void
+{
+    heap.mark(name);
+    for (const auto& [method_name, method] : methods)
+    {
+        heap.mark(method_name);
+        heap.mark(method);
+    }
+}
+
+auto loxe::vm::ClassObj::to_string() const -> std::string
+{
+    return utility::as_string("<class {}>", name->value());
+}
+
+auto loxe::vm::InstanceObj::trace(Heap& heap) -> void
+{
+    heap.mark(class_obj);
+    for (const auto& [field_name, field] : fields)
+    {
+        heap.mark(field_name);
+        heap.mark(field);
+    }
+}
+
+auto loxe::vm::InstanceObj::to_string() const -> std::string
+{
+    return utility::as_string("<{} instance>", class_obj->name->value());
+}
+
+auto loxe::vm::BoundMethodObj::trace(Heap& heap) -> void
+{
+    heap.mark(receiver);
+    heap.mark(method);
+}
+
+auto loxe::vm::BoundMethodObj::to_string() const -> std::string
+{
+    return method->to_string();
+}
+
+auto loxe::vm::ArrayObj::trace(Heap& heap) -> void
+{
+    for (const auto& value : values)
+        heap.mark(value);
+}
+
+auto loxe::vm::ArrayObj::to_string() const -> std::string
+{
+    if (values.empty()) return "[]";
+
+    auto string = std::string("[");
+    for (const auto& value : values)
+        string += value.stringify() + ", ";
+
+    string.pop_back();
+    string.pop_back();
+    return string.append("]");
+}
+
+auto loxe::vm::ArrayObj::payload() const -> std::size_t
+{
+    return values.capacity() * sizeof(Value);
+}
+
+auto loxe::vm::ModuleObj::trace(Heap& heap) -> void
+{
+    heap.mark(name);
+    for (const auto& [member, upvalue] : members)
+    {
+        heap.mark(member);
+        heap.mark(upvalue);
+    }
+}
+
+auto loxe::vm::ModuleObj::to_string() const -> std::string
+{
+    return utility::as_string("<module {}>", name->value());
+}
@@ -0,0 +1,41 @@
+#include "loxe/vm/object.hpp"
+#include "loxe/vm/value.hpp"
+
+auto loxe::vm::Value::operator==(const Value& other) const -> bool
+{
+    if (m_type != other.m_type) return false;
+
+    switch (m_type)
+    {
+        case Type::Boolean: return m_as.boolean == other.m_as.boolean;
+        case Type::Number:  return m_as.number  == other.m_as.number;
+        case Type::Object:
+        {
+            // the results of `+` aren't interned, so strings may have to compare their characters
+            if (m_as.object == other.m_as.object) return true;
+            if (!StringObj::is(m_as.object) || !StringObj::is(other.m_as.object)) return false;
+            return static_cast<const StringObj*>(m_as.object)->equals(*static_cast<const StringObj*>(other.m_as.object));
+        }
+        default:            return true;
+    }
+}
+
+auto loxe::vm::Value::stringify() const -> std::string
+{
+    switch (m_type)
+    {
+        case Type::Nil:     return "nil";
+        case Type::Boolean: return m_as.boolean ? "true" : "false";
+        case Type::Number:
+        {
+            auto string = std::to_string(m_as.number);
+            while (string.back() == '0') string.pop_back();
+            if    (string.back() == '.') string.pop_back();
+            return string;
+        }
+        case Type::Object:  return m_as.object->to_string();
+        default:            break;
+    }
+
+    return "undefined";
+}
@@ -0,0 +1,39 @@
+#include "loxe/vm/vm.hpp"
+#include "loxe/vm/machine.hpp"
+
+#include "loxe/common/utility.hpp"
+#include "loxe/parser/ast_cache.hpp"
+#include "loxe/parser/parser.hpp"
+#include "loxe/parser/resolver.hpp"
+
+auto loxe::vm::run_file(std::string filename) -> void
+{
+    auto ast   = std::optional<ast::Program>();
+    auto cache = std::optional<AstCache>();
+    if (filename == "-")
+    {
+        ast = Parser().parse(std::cin, "<stdin>");
+    }
+    else if (auto source = Source::open(filename))
+    {
+        cache = AstCache(filename, source->text());
+        if (auto cached = cache->load())
+            return Machine().interpret(*cached);
+
+        ast = Parser().parse(std::move(*source), filename);
+    }
+    else
+    {
+        return utility::println(std::cerr, "[vm]: failed to open file: '{}'", filename);
+    }
+
+    if (!ast)
+        return utility::println(std::cerr, "[vm]: encountered parser error in file '{}'", filename);
+
+    if (Resolver().resolve_ast(*ast) == Resolver::State::Error)
+        return utility::println(std::cerr, "[vm]: encountered resolution error in file '{}'", filename);
+
+    if (cache) cache->store(*ast);
+
+    Machine().interpret(*ast);
+}